@@ -0,0 +1,219 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replayserver.h"
+#include "mpdtrace.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QDebug>
+#include <stdio.h>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+static const int constReplyTimeout=30000;
+
+struct Scenario
+{
+    Scenario(const char *n=nullptr) : name(n) { }
+    QByteArray name;
+    QList<QByteArray> commands;
+};
+
+static qint64 peakRss()
+{
+    #ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (0==getrusage(RUSAGE_SELF, &usage)) {
+        #ifdef Q_OS_MAC
+        return usage.ru_maxrss/1024;
+        #else
+        return usage.ru_maxrss;
+        #endif
+    }
+    #endif
+    return -1;
+}
+
+// Read until the final line of a reply - "OK" or "ACK ..."
+static bool readReply(QTcpSocket &socket, QByteArray &reply)
+{
+    reply.clear();
+    for (;;) {
+        if (reply.endsWith('\n')) {
+            int start=reply.lastIndexOf('\n', reply.size()-2)+1;
+            QByteArray line=reply.mid(start, reply.size()-start-1);
+            if ("OK"==line || line.startsWith("ACK ")) {
+                return true;
+            }
+        }
+        if (!socket.bytesAvailable() && !socket.waitForReadyRead(constReplyTimeout)) {
+            return false;
+        }
+        reply+=socket.readAll();
+    }
+}
+
+static QList<Scenario> syntheticScenarios(int idleEvents)
+{
+    QList<Scenario> scenarios;
+    Scenario startup("startup");
+    startup.commands << "status" << "stats" << "outputs" << "listpartitions";
+    scenarios << startup;
+    Scenario library("library-load");
+    library.commands << "listallinfo";
+    scenarios << library;
+    Scenario queue("queue-load");
+    queue.commands << "playlistinfo" << "status";
+    scenarios << queue;
+    Scenario search("search");
+    search.commands << "search any \"Track 1\"";
+    scenarios << search;
+    Scenario idle("idle-burst");
+    for (int i=0; i<idleEvents; ++i) {
+        idle.commands << "idle" << "status";
+    }
+    scenarios << idle;
+    return scenarios;
+}
+
+static Scenario traceScenario(const MpdTrace &trace)
+{
+    Scenario scenario("trace");
+    int idleReplies=0;
+    for (const MpdTraceEntry &e: trace.entries()) {
+        if ('I'==e.type) {
+            idleReplies++;
+        }
+    }
+    for (const MpdTraceEntry &e: trace.entries()) {
+        if ('C'!=e.type || "noidle"==e.data) {
+            continue;
+        }
+        // Only send "idle" whilst there is recorded idle data to reply with
+        if ("idle"==e.data || e.data.startsWith("idle ")) {
+            if (0==idleReplies) {
+                continue;
+            }
+            idleReplies--;
+        }
+        scenario.commands << e.data;
+    }
+    return scenario;
+}
+
+// Runs MPD protocol scenarios against cantata-replay, and reports wall time, round trips, bytes received, and
+// peak RSS (of the whole process, so this only ever increases) for each.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("cantata-bench");
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.setApplicationDescription(QObject::tr("Benchmark MPD sessions against a replay server"));
+    cmdLineParser.addHelpOption();
+    QCommandLineOption traceOption(QStringList() << "t" << "trace", QObject::tr("Recorded trace to replay, instead of synthetic session"), "file", "");
+    QCommandLineOption queueOption(QStringList() << "q" << "queue", QObject::tr("Synthetic play queue length"), "songs", "30000");
+    QCommandLineOption libraryOption(QStringList() << "s" << "library", QObject::tr("Synthetic library size"), "songs", "50000");
+    QCommandLineOption idleOption(QStringList() << "i" << "idle", QObject::tr("Synthetic idle events"), "events", "200");
+    QCommandLineOption latencyOption(QStringList() << "L" << "latency", QObject::tr("Delay (ms) before each reply"), "ms", "0");
+    QCommandLineOption bandwidthOption(QStringList() << "b" << "bandwidth", QObject::tr("Maximum bytes per second to send"), "bytes", "0");
+    cmdLineParser.addOption(traceOption);
+    cmdLineParser.addOption(queueOption);
+    cmdLineParser.addOption(libraryOption);
+    cmdLineParser.addOption(idleOption);
+    cmdLineParser.addOption(latencyOption);
+    cmdLineParser.addOption(bandwidthOption);
+    cmdLineParser.process(app);
+
+    MpdTrace trace;
+    QList<Scenario> scenarios;
+    if (cmdLineParser.isSet(traceOption)) {
+        if (!trace.load(cmdLineParser.value(traceOption))) {
+            return 1;
+        }
+        scenarios << traceScenario(trace);
+    } else {
+        int idleEvents=cmdLineParser.value(idleOption).toInt();
+        trace=MpdTrace::synthetic(cmdLineParser.value(queueOption).toInt(), cmdLineParser.value(libraryOption).toInt(), idleEvents);
+        scenarios=syntheticScenarios(idleEvents);
+    }
+
+    ReplayServer *server=new ReplayServer(trace);
+    server->setLatency(cmdLineParser.value(latencyOption).toInt());
+    server->setBandwidth(cmdLineParser.value(bandwidthOption).toInt());
+    server->setRecordedIdleDelays(false);
+    if (!server->listen(QLatin1String("0"))) {
+        qWarning() << "Failed to start replay server";
+        return 1;
+    }
+    quint16 port=server->port();
+    QThread serverThread;
+    server->moveToThread(&serverThread);
+    serverThread.start();
+
+    bool ok=true;
+    QTcpSocket socket;
+    socket.connectToHost(QLatin1String("127.0.0.1"), port);
+    bool connected=socket.waitForConnected(constReplyTimeout);
+    while (connected && !socket.canReadLine()) {
+        connected=socket.waitForReadyRead(constReplyTimeout);
+    }
+    if (!connected) {
+        qWarning() << "Failed to connect to replay server";
+        ok=false;
+    } else {
+        socket.readLine(); // Greeting
+        printf("%-16s %10s %12s %14s %14s\n", "scenario", "wall (ms)", "round trips", "bytes", "peak RSS (kB)");
+        for (const Scenario &scenario: scenarios) {
+            QElapsedTimer timer;
+            qint64 bytes=0;
+            int roundTrips=0;
+            QByteArray reply;
+            timer.start();
+            for (const QByteArray &cmd: scenario.commands) {
+                socket.write(cmd+'\n');
+                if (!readReply(socket, reply)) {
+                    qWarning() << "No reply to" << cmd.left(80);
+                    ok=false;
+                    break;
+                }
+                bytes+=reply.size();
+                roundTrips++;
+            }
+            printf("%-16s %10lld %12d %14lld %14lld\n", scenario.name.constData(), (long long)timer.elapsed(), roundTrips, (long long)bytes, (long long)peakRss());
+            if (!ok) {
+                break;
+            }
+        }
+        socket.disconnectFromHost();
+    }
+
+    serverThread.quit();
+    serverThread.wait();
+    delete server;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,364 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "db/librarydb.h"
+#include <QtTest>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <stdio.h>
+
+// Chi-squared value, for 99 degrees of freedom, that a uniform sample exceeds with probability 0.001
+static const double constChiSquared99=148.23;
+static const int constSampleAlbums=100;
+static const int constSamplesPerAlbum=200;
+static const int constBenchTracks=300000;
+static const int constBenchQueries=200;
+
+static Song benchSong(int album, int track)
+{
+    Song s;
+    int artist=album/10;
+    s.file=QString("Artist %1/Album %2/%3.flac").arg(artist).arg(album).arg(track+1);
+    s.artist=QString("Artist %1").arg(artist);
+    s.album=QString("Album %1").arg(album);
+    s.title=QString("Track %1").arg(track+1);
+    s.track=track+1;
+    s.year=1960+(album%60);
+    s.time=200;
+    s.genres[0]=QString("Genre %1").arg(album%4);
+    s.lastModified=1600000000;
+    return s;
+}
+
+// Albums have 1 to 5 tracks, so that weighted and uniform sampling differ
+static int sampleTracks(int album)
+{
+    return (album%5)+1;
+}
+
+static void updateDb(LibraryDb &db, time_t version, const QList<Song> &songs)
+{
+    db.updateStarted(version);
+    db.insertSongs(new QList<Song>(songs));
+    db.updateFinished();
+}
+
+static double chiSquared(const QHash<QString, int> &counts, const QHash<QString, double> &expected)
+{
+    double total=0.0;
+    QHash<QString, double>::ConstIterator it=expected.constBegin();
+    QHash<QString, double>::ConstIterator end=expected.constEnd();
+    for (; it!=end; ++it) {
+        double diff=counts.value(it.key())-it.value();
+        total+=(diff*diff)/it.value();
+    }
+    return total;
+}
+
+// Checks, and times, LibraryDb's random album sampling
+class LibraryBench : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void uniformSampling();
+    void weightedSampling();
+    void bulkSampling();
+    void incrementalIndex();
+    void foldArtist_data();
+    void foldArtist();
+    void resolveArtist();
+    void randomAlbumBench();
+
+private:
+    QString dbFile(const QString &name) const;
+    static QList<Song> sampleSongs();
+    static void report(const char *name, qint64 ms, int queries);
+};
+
+void LibraryBench::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
+    dir.removeRecursively();
+    QVERIFY(QDir().mkpath(dir.absolutePath()));
+    printf("%-20s %10s %10s\n", "scenario", "wall (ms)", "queries");
+}
+
+QString LibraryBench::dbFile(const QString &name) const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation)+QLatin1Char('/')+name+LibraryDb::constFileExt;
+}
+
+QList<Song> LibraryBench::sampleSongs()
+{
+    QList<Song> songs;
+    for (int album=0; album<constSampleAlbums; ++album) {
+        for (int track=0; track<sampleTracks(album); ++track) {
+            songs.append(benchSong(album, track));
+        }
+    }
+    return songs;
+}
+
+void LibraryBench::report(const char *name, qint64 ms, int queries)
+{
+    printf("%-20s %10lld %10d\n", name, (long long)ms, queries);
+}
+
+void LibraryBench::uniformSampling()
+{
+    LibraryDb db(nullptr, QLatin1String("uniform"));
+    QVERIFY(db.init(dbFile("uniform")));
+    updateDb(db, 1, sampleSongs());
+
+    QHash<QString, int> counts;
+    QHash<QString, double> expected;
+    const int samples=constSampleAlbums*constSamplesPerAlbum;
+    for (int i=0; i<samples; ++i) {
+        LibraryDb::Album album=db.getRandomAlbum(QString(), QString());
+        QVERIFY(!album.id.isEmpty());
+        counts[album.id]++;
+    }
+    for (int album=0; album<constSampleAlbums; ++album) {
+        expected.insert(QString("Album %1").arg(album), constSamplesPerAlbum);
+    }
+    QCOMPARE(counts.count(), constSampleAlbums);
+    QVERIFY2(chiSquared(counts, expected)<constChiSquared99, qPrintable(QString::number(chiSquared(counts, expected))));
+}
+
+void LibraryBench::weightedSampling()
+{
+    LibraryDb db(nullptr, QLatin1String("weighted"));
+    QVERIFY(db.init(dbFile("weighted")));
+    QList<Song> songs=sampleSongs();
+    updateDb(db, 1, songs);
+
+    QHash<QString, int> counts;
+    QHash<QString, double> expected;
+    const int samples=constSampleAlbums*constSamplesPerAlbum;
+    for (int i=0; i<samples; ++i) {
+        QList<LibraryDb::Album> albums=db.getRandomAlbums(QStringList(), QStringList(), 1, true);
+        QCOMPARE(albums.count(), 1);
+        counts[albums.first().id]++;
+    }
+    // Each track is equally likely, so albums are picked in proportion to their track count
+    for (int album=0; album<constSampleAlbums; ++album) {
+        expected.insert(QString("Album %1").arg(album), (samples*sampleTracks(album))/(double)songs.count());
+    }
+    QVERIFY2(chiSquared(counts, expected)<constChiSquared99, qPrintable(QString::number(chiSquared(counts, expected))));
+}
+
+void LibraryBench::bulkSampling()
+{
+    LibraryDb db(nullptr, QLatin1String("bulk"));
+    QVERIFY(db.init(dbFile("bulk")));
+    updateDb(db, 1, sampleSongs());
+
+    // Albums within one call are distinct, and across calls each is equally likely
+    const int count=10;
+    const int calls=(constSampleAlbums*constSamplesPerAlbum)/count;
+    QHash<QString, int> counts;
+    QHash<QString, double> expected;
+    for (int i=0; i<calls; ++i) {
+        QSet<QString> picked;
+        for (const LibraryDb::Album &album: db.getRandomAlbums(QStringList(), QStringList(), count)) {
+            picked.insert(album.id);
+            counts[album.id]++;
+        }
+        QCOMPARE(picked.count(), count);
+    }
+    for (int album=0; album<constSampleAlbums; ++album) {
+        expected.insert(QString("Album %1").arg(album), constSamplesPerAlbum);
+    }
+    QVERIFY2(chiSquared(counts, expected)<constChiSquared99, qPrintable(QString::number(chiSquared(counts, expected))));
+
+    // Asking for more than there are returns all matching albums
+    QList<LibraryDb::Album> genreAlbums=db.getRandomAlbums(QStringList() << "Genre 1", QStringList(), constSampleAlbums);
+    QCOMPARE(genreAlbums.count(), constSampleAlbums/4);
+    for (const LibraryDb::Album &album: genreAlbums) {
+        QCOMPARE(album.id.mid(6).toInt()%4, 1);
+    }
+    QList<LibraryDb::Album> weighted=db.getRandomAlbums(QStringList() << "Genre 2", QStringList() << "Artist 0", constSampleAlbums, true);
+    QCOMPARE(weighted.count(), (constSampleAlbums/4)+10-2);
+}
+
+// After an update, the sampling index is adjusted for the changed albums - rather than rebuilt
+void LibraryBench::incrementalIndex()
+{
+    LibraryDb db(nullptr, QLatin1String("incremental"));
+    QVERIFY(db.init(dbFile("incremental")));
+    QList<Song> songs=sampleSongs();
+    updateDb(db, 1, songs);
+    QVERIFY(!db.getRandomAlbum(QString(), QString()).id.isEmpty());
+
+    // Remove Artist 0's albums, move album 10 to another genre, and add a new album
+    QList<Song> updated;
+    for (const Song &s: songs) {
+        if (s.artist!=QLatin1String("Artist 0")) {
+            updated.append(s);
+            if (QLatin1String("Album 10")==s.album) {
+                updated.last().genres[0]=QLatin1String("Genre 3");
+            }
+        }
+    }
+    updated.append(benchSong(constSampleAlbums, 0));
+    updateDb(db, 2, updated);
+
+    QSet<QString> all;
+    for (const LibraryDb::Album &album: db.getRandomAlbums(QStringList(), QStringList(), constSampleAlbums*2)) {
+        all.insert(album.id);
+    }
+    QCOMPARE(all.count(), constSampleAlbums-10+1);
+    QVERIFY(!all.contains("Album 0"));
+    QVERIFY(all.contains(QString("Album %1").arg(constSampleAlbums)));
+    QVERIFY(db.getRandomAlbums(QStringList(), QStringList() << "Artist 0", 1).isEmpty());
+
+    QSet<QString> genre3;
+    for (const LibraryDb::Album &album: db.getRandomAlbums(QStringList() << "Genre 3", QStringList(), constSampleAlbums)) {
+        genre3.insert(album.id);
+    }
+    QVERIFY(genre3.contains("Album 10"));
+    QVERIFY(!genre3.contains("Album 3"));
+    QSet<QString> genre2;
+    for (const LibraryDb::Album &album: db.getRandomAlbums(QStringList() << "Genre 2", QStringList(), constSampleAlbums)) {
+        genre2.insert(album.id);
+    }
+    QVERIFY(!genre2.contains("Album 10"));
+}
+
+void LibraryBench::foldArtist_data()
+{
+    QTest::addColumn<QString>("a");
+    QTest::addColumn<QString>("b");
+    QTest::addColumn<bool>("same");
+
+    QTest::newRow("case") << "Pink Floyd" << "PINK FLOYD" << true;
+    QTest::newRow("spaces") << "  Pink  Floyd " << "Pink Floyd" << true;
+    QTest::newRow("the") << "The Beatles" << "Beatles" << true;
+    QTest::newRow("the-lower") << "the beatles" << "Beatles" << true;
+    QTest::newRow("the-only") << "The" << "the" << true;
+    QTest::newRow("the-inside") << "Theatre of Tragedy" << "atre of Tragedy" << false;
+    QTest::newRow("punctuation") << "AC/DC" << "ACDC" << true;
+    QTest::newRow("apostrophe") << "Guns N' Roses" << "Guns N Roses" << true;
+    QTest::newRow("accents") << QString::fromUtf8("Beyonc\xc3\xa9") << "Beyonce" << true;
+    QTest::newRow("umlaut") << QString::fromUtf8("Mot\xc3\xb6rhead") << "Motorhead" << true;
+    QTest::newRow("non-latin") << QString::fromUtf8("\xe5\x9d\x82\xe6\x9c\xac\xe9\xbe\x8d\xe4\xb8\x80") << QString::fromUtf8("\xe5\x9d\x82\xe6\x9c\xac") << false;
+    QTest::newRow("symbols-only") << "!!!" << "???" << false;
+    QTest::newRow("different") << "Sigur Ros" << "Sigur Ros Band" << false;
+}
+
+void LibraryBench::foldArtist()
+{
+    QFETCH(QString, a);
+    QFETCH(QString, b);
+    QFETCH(bool, same);
+    QCOMPARE(LibraryDb::foldArtist(a)==LibraryDb::foldArtist(b), same);
+    QVERIFY(!LibraryDb::foldArtist(a).isEmpty());
+}
+
+// Artist names from other sources are matched to the library's album artists, regardless of case, accents, etc.
+void LibraryBench::resolveArtist()
+{
+    LibraryDb db(nullptr, QLatin1String("resolve"));
+    QVERIFY(db.init(dbFile("resolve")));
+    QList<Song> songs;
+    QStringList artists=QStringList() << "The Beatles" << QString::fromUtf8("Bj\xc3\xb6rk") << "AC/DC";
+    for (int i=0; i<artists.count(); ++i) {
+        Song s=benchSong(i, 0);
+        s.artist=s.albumartist=artists.at(i);
+        songs.append(s);
+    }
+    updateDb(db, 1, songs);
+
+    QCOMPARE(db.resolveArtist("The Beatles"), QString("The Beatles"));
+    QCOMPARE(db.resolveArtist("beatles"), QString("The Beatles"));
+    QCOMPARE(db.resolveArtist("BJORK"), QString::fromUtf8("Bj\xc3\xb6rk"));
+    QCOMPARE(db.resolveArtist("Ac-Dc"), QString("AC/DC"));
+    QVERIFY(db.resolveArtist("Pink Floyd").isEmpty());
+    QVERIFY(db.resolveArtist(QString()).isEmpty());
+
+    // Index follows library updates
+    songs.removeFirst();
+    updateDb(db, 2, songs);
+    QVERIFY(db.resolveArtist("beatles").isEmpty());
+    QCOMPARE(db.resolveArtist("bjork"), QString::fromUtf8("Bj\xc3\xb6rk"));
+}
+
+// Compare sampling index with the previous "order by random()" query, on a large library
+void LibraryBench::randomAlbumBench()
+{
+    LibraryDb db(nullptr, QLatin1String("large"));
+    QVERIFY(db.init(dbFile("large")));
+    QList<Song> songs;
+    for (int i=0; i<constBenchTracks; ++i) {
+        songs.append(benchSong(i/10, i%10));
+    }
+    QElapsedTimer timer;
+    timer.start();
+    updateDb(db, 1, songs);
+    report("create-db", timer.elapsed(), 0);
+
+    {
+        QSqlDatabase direct=QSqlDatabase::addDatabase("QSQLITE", "librarybench-direct");
+        direct.setDatabaseName(dbFile("large"));
+        QVERIFY(direct.open());
+        QString genreClause;
+        for (int i=0; i<Song::constNumGenres; ++i) {
+            genreClause+=QString("%1genre%2=:genre").arg(i ? " OR " : "").arg(i+1);
+        }
+        QSqlQuery query(direct);
+        query.prepare("select artistId, albumId from songs where ("+genreClause+") order by random() limit 1");
+        timer.restart();
+        for (int i=0; i<constBenchQueries; ++i) {
+            query.bindValue(":genre", QString("Genre %1").arg(i%4));
+            QVERIFY(query.exec());
+            QVERIFY(query.next());
+        }
+        report("order-by-random", timer.elapsed(), constBenchQueries);
+        direct.close();
+    }
+    QSqlDatabase::removeDatabase("librarybench-direct");
+
+    timer.restart();
+    QVERIFY(!db.getRandomAlbum(QString(), QString()).id.isEmpty());
+    report("build-index", timer.elapsed(), 1);
+
+    timer.restart();
+    for (int i=0; i<constBenchQueries; ++i) {
+        QVERIFY(!db.getRandomAlbum(QString("Genre %1").arg(i%4), QString()).id.isEmpty());
+    }
+    report("sample-index", timer.elapsed(), constBenchQueries);
+
+    timer.restart();
+    QCOMPARE(db.getRandomAlbums(QStringList() << "Genre 0" << "Genre 1", QStringList(), constBenchQueries, true).count(), constBenchQueries);
+    report("sample-bulk", timer.elapsed(), 1);
+}
+
+QTEST_MAIN(LibraryBench)
+#include "librarybench.moc"
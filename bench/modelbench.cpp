@@ -0,0 +1,379 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replayserver.h"
+#include "virtualmpd.h"
+#include "mpd-interface/mpdconnection.h"
+#include "models/playqueuemodel.h"
+#include "models/mpdlibrarymodel.h"
+#include "db/librarydb.h"
+#include "support/thread.h"
+#include <QtTest>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThread>
+#include <stdio.h>
+
+static const int constLoadTimeout=120000;
+
+// Passes play queue updates from MPDConnection to PlayQueueModel, as MainWindow does
+class QueueUpdater : public QObject
+{
+    Q_OBJECT
+
+public:
+    QueueUpdater()
+        : updates(0)
+    {
+        connect(MPDConnection::self(), SIGNAL(playlistUpdated(QList<Song>,bool)), this, SLOT(update(QList<Song>,bool)));
+        connect(MPDConnection::self(), SIGNAL(playlistPagedUpdated(QList<qint32>,QList<quint32>)), this, SLOT(updatePaged(QList<qint32>,QList<quint32>)));
+    }
+
+    int updates;
+
+public Q_SLOTS:
+    void update(const QList<Song> &songs, bool isComplete)
+    {
+        PlayQueueModel::self()->update(songs, isComplete);
+        updates++;
+    }
+
+    void updatePaged(const QList<qint32> &ids, const QList<quint32> &times)
+    {
+        PlayQueueModel::self()->updatePaged(ids, times);
+        updates++;
+    }
+};
+
+// Exposes the item indexes, so that these can be checked after changes have been merged
+class ChangeSetModel : public SqlLibraryModel
+{
+public:
+    ChangeSetModel(LibraryDb *d) : SqlLibraryModel(d, nullptr, T_Artist) { }
+
+    int artistItemCount(const QString &artistId) const { return artistItems(artistId).count(); }
+    int albumItemCount(const QString &artistId, const QString &albumId) const { return albumItems(artistId, albumId).count(); }
+};
+
+static Song changeSetSong(int artist, int album, int track)
+{
+    Song s;
+    s.file=QString("Artist %1/Album %2/%3.flac").arg(artist).arg(album).arg(track+1);
+    s.artist=QString("Artist %1").arg(artist);
+    s.album=QString("Album %1").arg((artist*10)+album);
+    s.title=QString("Track %1").arg(track+1);
+    s.track=track+1;
+    s.year=2000+album;
+    s.time=200;
+    s.genres[0]=QLatin1String("Rock");
+    s.lastModified=1600000000;
+    return s;
+}
+
+static QList<Song> changeSetSongs(int artist, int albums, int tracks)
+{
+    QList<Song> songs;
+    for (int album=0; album<albums; ++album) {
+        for (int track=0; track<tracks; ++track) {
+            songs.append(changeSetSong(artist, album, track));
+        }
+    }
+    return songs;
+}
+
+static void updateDb(LibraryDb &db, time_t version, const QList<Song> &songs)
+{
+    db.updateStarted(version);
+    db.insertSongs(new QList<Song>(songs));
+    db.updateFinished();
+}
+
+// Loads the play queue and library from a VirtualMpd, via MPDConnection, PlayQueueModel, MpdLibraryDb,
+// and MpdLibraryModel - i.e. the same code paths as Cantata itself.
+class ModelBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelBench() : server(nullptr), updater(nullptr) { }
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void queueLoad();
+    void pagedQueueLoad();
+    void libraryLoad();
+    void libraryChangeSet();
+    void folderEnumeration();
+    void commandCoalescing();
+
+private:
+    void connectTo(int queueLength, int librarySize);
+    void stopServer();
+    static void report(const char *name, qint64 ms, int rows, int commands);
+
+private:
+    ReplayServer *server;
+    QThread serverThread;
+    QueueUpdater *updater;
+};
+
+void ModelBench::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // Library DBs are named after host and port, so remove any from a previous run
+    QDir(QStandardPaths::writableLocation(QStandardPaths::DataLocation)).removeRecursively();
+    MPDConnection::self()->start();
+    updater=new QueueUpdater();
+    MpdLibraryModel::self()->setTopLevel(SqlLibraryModel::T_Artist);
+    printf("%-16s %10s %10s %10s\n", "scenario", "wall (ms)", "rows", "commands");
+}
+
+void ModelBench::cleanupTestCase()
+{
+    disconnect(MPDConnection::self(), nullptr, nullptr, nullptr);
+    ThreadCleaner::self()->stopAll();
+    stopServer();
+    delete updater;
+}
+
+// Start a new server, and connect to this - each connection uses its own library DB
+void ModelBench::connectTo(int queueLength, int librarySize)
+{
+    stopServer();
+    server=new ReplayServer(MpdTrace());
+    server->setVirtualMpd(new VirtualMpd(queueLength, librarySize));
+    server->setRecordedIdleDelays(false);
+    QVERIFY(server->listen(QLatin1String("0")));
+    server->moveToThread(&serverThread);
+    serverThread.start();
+
+    MPDConnectionDetails details;
+    details.name=QLatin1String("bench");
+    details.hostname=QLatin1String("127.0.0.1");
+    details.port=server->port();
+    updater->updates=0;
+    QMetaObject::invokeMethod(MPDConnection::self(), "setDetails", Qt::QueuedConnection, Q_ARG(MPDConnectionDetails, details));
+}
+
+void ModelBench::stopServer()
+{
+    if (server) {
+        serverThread.quit();
+        serverThread.wait();
+        delete server;
+        server=nullptr;
+    }
+}
+
+void ModelBench::report(const char *name, qint64 ms, int rows, int commands)
+{
+    printf("%-16s %10lld %10d %10d\n", name, (long long)ms, rows, commands);
+}
+
+void ModelBench::queueLoad()
+{
+    QElapsedTimer timer;
+    timer.start();
+    connectTo(5000, 100);
+    QTRY_VERIFY_WITH_TIMEOUT(updater->updates>0, constLoadTimeout);
+    QCOMPARE(PlayQueueModel::self()->rowCount(), 5000);
+    QVERIFY(!PlayQueueModel::self()->isPaged());
+    report("queue-load", timer.elapsed(), PlayQueueModel::self()->rowCount(), server->commandCount("playlistinfo"));
+}
+
+void ModelBench::pagedQueueLoad()
+{
+    const int queueLength=MPDConnection::constPagedPlayQueueLength+5000;
+    const int pageSize=MPDConnection::constPlayQueuePageSize;
+    PlayQueueModel *model=PlayQueueModel::self();
+    QElapsedTimer timer;
+    timer.start();
+    connectTo(queueLength, 100);
+    QTRY_VERIFY_WITH_TIMEOUT(updater->updates>0, constLoadTimeout);
+    QVERIFY(model->isPaged());
+    QCOMPARE(model->rowCount(), queueLength);
+    // Play queue is read once, a page at a time
+    QCOMPARE(server->commandCount("playlistinfo"), (queueLength+pageSize-1)/pageSize);
+    report("paged-queue-load", timer.elapsed(), model->rowCount(), server->commandCount("playlistinfo"));
+
+    // IDs are 1-based positions
+    timer.restart();
+    for (int row=0; row<queueLength; ++row) {
+        QCOMPARE(model->getRowById(row+1), row);
+    }
+    QCOMPARE(model->getRowById(queueLength+1), -1);
+    report("paged-row-by-id", timer.elapsed(), queueLength, 0);
+
+    // Details are only read, for the page containing the row, when a row is shown. Use a row in the middle
+    // of a page, so that the neighbouring page is not also read.
+    int row=((queueLength/2)/pageSize)*pageSize+pageSize/2;
+    server->clearCommandCounts();
+    timer.restart();
+    model->data(model->index(row, 0), Qt::DisplayRole);
+    QTRY_COMPARE_WITH_TIMEOUT(model->getSongByRow(row).title, QString("Track %1").arg((row%10)+1), constLoadTimeout);
+    QCOMPARE(server->commandCount("playlistinfo"), 1);
+    report("paged-fetch-page", timer.elapsed(), 1, server->commandCount("playlistinfo"));
+}
+
+void ModelBench::libraryLoad()
+{
+    const int librarySize=5000;
+    const int artists=librarySize/100;
+    const int albums=librarySize/10;
+    MpdLibraryModel *model=MpdLibraryModel::self();
+    QElapsedTimer timer;
+    timer.start();
+    connectTo(0, librarySize);
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(QModelIndex()), artists, constLoadTimeout);
+    QCOMPARE(model->trackCount(), librarySize);
+    // Server type detection, then root, each artist, and each album
+    QVERIFY(server->commandCount("lsinfo")>=2+artists+albums);
+    report("library-load", timer.elapsed(), model->rowCount(QModelIndex()), server->commandCount("lsinfo"));
+
+    // Expanding an artist reads its albums via a worker
+    QModelIndex artist=model->index(0, 0, QModelIndex());
+    QVERIFY(model->canFetchMore(artist));
+    timer.restart();
+    model->fetchMore(artist);
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(artist), 10, constLoadTimeout);
+    report("library-expand", timer.elapsed(), model->rowCount(artist), 0);
+}
+
+// Changes to a library whose previous contents are known are merged into the model, as row insertions,
+// removals, and moves - so that loaded (and expanded) items are kept.
+void ModelBench::libraryChangeSet()
+{
+    QString dbFile=QStandardPaths::writableLocation(QStandardPaths::DataLocation)+QLatin1String("/changeset.sql");
+    QDir().mkpath(QFileInfo(dbFile).absolutePath());
+    LibraryDb db(nullptr, QLatin1String("changeset"));
+    QVERIFY(db.init(dbFile));
+    ChangeSetModel model(&db);
+
+    // Initial contents are not known, so first update resets the model
+    QList<Song> songs;
+    for (int artist=0; artist<5; ++artist) {
+        songs+=changeSetSongs(artist, 2, 3);
+    }
+    updateDb(db, 1, songs);
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(QModelIndex()), 5, constLoadTimeout);
+
+    QPersistentModelIndex artist=model.index(1, 0, QModelIndex());
+    model.fetchMore(artist);
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(artist), 2, constLoadTimeout);
+    QPersistentModelIndex album=model.index(0, 0, artist);
+    model.fetchMore(album);
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(album), 3, constLoadTimeout);
+
+    QSignalSpy resets(&model, SIGNAL(modelReset()));
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removed(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // Remove the first artist, add a new last artist, and add an album and a track to those loaded
+    songs.clear();
+    for (int artist=1; artist<6; ++artist) {
+        songs+=changeSetSongs(artist, 1==artist ? 3 : 2, 3);
+    }
+    songs.append(changeSetSong(1, 0, 3));
+    QElapsedTimer timer;
+    timer.start();
+    updateDb(db, 2, songs);
+    QTRY_VERIFY_WITH_TIMEOUT(!inserted.isEmpty(), constLoadTimeout);
+    report("library-changes", timer.elapsed(), inserted.count()+removed.count(), 0);
+
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(model.rowCount(QModelIndex()), 5);
+    QCOMPARE(model.index(0, 0, QModelIndex()).data().toString(), QString("Artist 1"));
+    QCOMPARE(model.index(4, 0, QModelIndex()).data().toString(), QString("Artist 5"));
+    QVERIFY(artist.isValid());
+    QCOMPARE(artist.row(), 0);
+    QCOMPARE(model.rowCount(artist), 3);
+    QVERIFY(album.isValid());
+    QCOMPARE(model.rowCount(album), 4);
+
+    QCOMPARE(model.artistItemCount("Artist 0"), 0);
+    QCOMPARE(model.artistItemCount("Artist 5"), 1);
+    QCOMPARE(model.albumItemCount("Artist 1", "Album 12"), 1);
+    QCOMPARE(model.albumItemCount("Artist 0", "Album 0"), 0);
+    QModelIndex found=model.findArtistIndex("Artist 5");
+    QVERIFY(found.isValid());
+    QCOMPARE(found.row(), 4);
+}
+
+// Adding a folder too large for a single "listall" splits this into sub-folders that are small enough
+void ModelBench::folderEnumeration()
+{
+    const int librarySize=30000;
+    const int artists=librarySize/100;
+    MpdLibraryModel *model=MpdLibraryModel::self();
+    connectTo(0, librarySize);
+    QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(QModelIndex()), artists, constLoadTimeout);
+
+    server->clearCommandCounts();
+    QElapsedTimer timer;
+    timer.start();
+    QMetaObject::invokeMethod(MPDConnection::self(), "add", Qt::QueuedConnection, Q_ARG(QStringList, QStringList() << MPDConnection::constDirPrefix),
+                              Q_ARG(int, MPDConnection::Append), Q_ARG(quint8, 0), Q_ARG(bool, false));
+    QTRY_COMPARE_WITH_TIMEOUT(server->commandCount("add"), librarySize, constLoadTimeout);
+    // Root is listed, then each artist (100 songs) is counted, and listed with one "listall"
+    QCOMPARE(server->commandCount("lsinfo"), 1);
+    QCOMPARE(server->commandCount("count"), artists);
+    QCOMPARE(server->commandCount("listall"), artists);
+    report("folder-enumerate", timer.elapsed(), server->commandCount("add"),
+           server->commandCount("lsinfo")+server->commandCount("count")+server->commandCount("listall"));
+}
+
+// Continuous controls (e.g. dragging the volume slider) send the latest value at most once per coalescing
+// interval, rather than a command for every change.
+void ModelBench::commandCoalescing()
+{
+    const int changes=100;
+    const int changeInterval=5;
+    connectTo(10, 100);
+    QTRY_VERIFY_WITH_TIMEOUT(updater->updates>0, constLoadTimeout);
+
+    server->clearCommandCounts();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i=0; i<changes; ++i) {
+        QMetaObject::invokeMethod(MPDConnection::self(), "setVolume", Qt::QueuedConnection, Q_ARG(int, i));
+        QMetaObject::invokeMethod(MPDConnection::self(), "setSeekId", Qt::QueuedConnection, Q_ARG(qint32, 1), Q_ARG(quint32, i));
+        QMetaObject::invokeMethod(MPDConnection::self(), "setCrossFade", Qt::QueuedConnection, Q_ARG(int, i%10));
+        QTest::qWait(changeInterval);
+    }
+    qint64 elapsed=timer.elapsed();
+
+    // Pending values are sent, once the interval has passed
+    const int maxCommands=int(elapsed/MPDConnection::constCoalesceInterval)+2;
+    for (const char *cmd: { "setvol", "seekid", "crossfade" }) {
+        QTRY_VERIFY_WITH_TIMEOUT(server->commandCount(cmd)>=1, constLoadTimeout);
+        QTest::qWait(MPDConnection::constCoalesceInterval*2);
+        QVERIFY2(server->commandCount(cmd)<=maxCommands, qPrintable(QString("%1: %2 > %3").arg(QLatin1String(cmd)).arg(server->commandCount(cmd)).arg(maxCommands)));
+    }
+    report("coalesce", elapsed, changes*3, server->commandCount("setvol")+server->commandCount("seekid")+server->commandCount("crossfade"));
+}
+
+QTEST_MAIN(ModelBench)
+#include "modelbench.moc"
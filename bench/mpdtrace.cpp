@@ -0,0 +1,143 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "mpdtrace.h"
+#include <QFile>
+#include <QDebug>
+
+static const QByteArray constHeader("# Cantata MPD trace ");
+static const QByteArray constDefaultGreeting("OK MPD 0.23.0\n");
+
+bool MpdTrace::load(const QString &fileName)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open" << fileName;
+        return false;
+    }
+
+    items.clear();
+    QByteArray header=f.readLine();
+    if (!header.startsWith(constHeader)) {
+        qWarning() << fileName << "is not an MPD trace";
+        return false;
+    }
+
+    while (!f.atEnd()) {
+        QList<QByteArray> parts=f.readLine().trimmed().split(' ');
+        if (parts.count()<3 || 1!=parts.at(0).length()) {
+            qWarning() << "Invalid entry in" << fileName;
+            return false;
+        }
+        MpdTraceEntry entry(parts.at(0).at(0), parts.at(1).toLongLong());
+        if (4==parts.count()) {
+            entry.duration=parts.at(2).toLongLong();
+        }
+        int size=parts.last().toInt();
+        entry.data=f.read(size);
+        f.read(1); // Newline that separates entries
+        if (entry.data.size()!=size) {
+            qWarning() << "Truncated entry in" << fileName;
+            return false;
+        }
+        items.append(entry);
+    }
+    return true;
+}
+
+QByteArray MpdTrace::greeting() const
+{
+    for (const MpdTraceEntry &e: items) {
+        if ('G'==e.type && !e.data.isEmpty()) {
+            return e.data;
+        }
+    }
+    return constDefaultGreeting;
+}
+
+QByteArray MpdTrace::song(int index)
+{
+    int artist=index/100;
+    int album=index/10;
+    int track=(index%10)+1;
+    return "file: Artist "+QByteArray::number(artist)+"/Album "+QByteArray::number(album)+"/"+QByteArray::number(track)+".flac\n"
+           "Artist: Artist "+QByteArray::number(artist)+"\n"
+           "Album: Album "+QByteArray::number(album)+"\n"
+           "Title: Track "+QByteArray::number(track)+"\n"
+           "Track: "+QByteArray::number(track)+"\n"
+           "Genre: Genre "+QByteArray::number(artist%20)+"\n"
+           "Date: "+QByteArray::number(1960+(album%60))+"\n"
+           "Time: 200\nduration: 200.000\n";
+}
+
+QByteArray MpdTrace::songs(int count, int startId)
+{
+    QByteArray data;
+    for (int i=0; i<count; ++i) {
+        data+=song(i);
+        if (startId>=0) {
+            data+="Pos: "+QByteArray::number(i)+"\nId: "+QByteArray::number(startId+i)+"\n";
+        }
+    }
+    return data+"OK\n";
+}
+
+void MpdTrace::add(char type, const QByteArray &data)
+{
+    items.append(MpdTraceEntry(type, items.isEmpty() ? 0 : items.last().time+1, data));
+}
+
+MpdTrace MpdTrace::synthetic(int queueLength, int librarySize, int idleEvents)
+{
+    MpdTrace t;
+    QByteArray status="volume: 50\nrepeat: 0\nrandom: 0\nsingle: 0\nconsume: 0\nplaylist: 2\nplaylistlength: "+
+                      QByteArray::number(queueLength)+"\nmixrampdb: 0.000000\nstate: play\nsong: 0\nsongid: 1\n"
+                      "time: 10:200\nelapsed: 10.000\nbitrate: 900\nduration: 200.000\naudio: 44100:16:2\nOK\n";
+    t.add('G', constDefaultGreeting);
+    // Startup
+    t.add('C', "status");
+    t.add('R', status);
+    t.add('C', "stats");
+    t.add('R', "artists: "+QByteArray::number(librarySize/100)+"\nalbums: "+QByteArray::number(librarySize/10)+"\nsongs: "+
+               QByteArray::number(librarySize)+"\nuptime: 10\ndb_playtime: 1000\ndb_update: 1600000000\nplaytime: 10\nOK\n");
+    t.add('C', "outputs");
+    t.add('R', "outputid: 0\noutputname: Default\nplugin: alsa\noutputenabled: 1\nOK\n");
+    t.add('C', "listpartitions");
+    t.add('R', "partition: default\nOK\n");
+    // Library and play queue
+    t.add('C', "listallinfo");
+    t.add('R', songs(librarySize, -1));
+    t.add('C', "playlistinfo");
+    t.add('R', songs(queueLength, 1));
+    // Search
+    t.add('C', "search any \"Track 1\"");
+    t.add('R', songs(librarySize/10, -1));
+    // Idle events, each causing a status update
+    for (int i=0; i<idleEvents; ++i) {
+        t.add('C', "idle");
+        t.add('I', "changed: player\nchanged: mixer\nOK\n");
+        t.add('C', "status");
+        t.add('R', status);
+    }
+    return t;
+}
@@ -0,0 +1,62 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MPD_TRACE_H
+#define MPD_TRACE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// An MPD session, as recorded by "cantata --trace-mpd <file>" (see MPDConnection::enableTrace)
+struct MpdTraceEntry
+{
+    MpdTraceEntry(char t=0, qint64 tm=0, const QByteArray &d=QByteArray())
+        : type(t), time(tm), duration(-1), data(d) { }
+    char type; // G, C, R, or I
+    qint64 time;
+    qint64 duration;
+    QByteArray data;
+};
+
+class MpdTrace
+{
+public:
+    bool load(const QString &fileName);
+    // Create a session with a play queue, and library, of the given sizes.
+    static MpdTrace synthetic(int queueLength, int librarySize, int idleEvents);
+    static QByteArray songs(int count, int startId);
+    // Tags of the song at index - songs are grouped 10 per album, and 100 per artist
+    static QByteArray song(int index);
+
+    const QList<MpdTraceEntry> & entries() const { return items; }
+    QByteArray greeting() const;
+
+private:
+    void add(char type, const QByteArray &data);
+
+private:
+    QList<MpdTraceEntry> items;
+};
+
+#endif
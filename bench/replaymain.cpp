@@ -0,0 +1,68 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replayserver.h"
+#include "mpdtrace.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+
+// Serve a recorded (cantata --trace-mpd <file>) MPD session, so that Cantata may be connected to this.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("cantata-replay");
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.setApplicationDescription(QObject::tr("Serve a recorded MPD session"));
+    cmdLineParser.addHelpOption();
+    QCommandLineOption listenOption(QStringList() << "l" << "listen", QObject::tr("Port, or local socket path, to listen on"), "address", "6600");
+    QCommandLineOption latencyOption(QStringList() << "L" << "latency", QObject::tr("Delay (ms) before each reply"), "ms", "0");
+    QCommandLineOption bandwidthOption(QStringList() << "b" << "bandwidth", QObject::tr("Maximum bytes per second to send"), "bytes", "0");
+    QCommandLineOption noIdleDelayOption(QStringList() << "n" << "no-idle-delay", QObject::tr("Send idle events immediately, rather than at recorded times"));
+    cmdLineParser.addOption(listenOption);
+    cmdLineParser.addOption(latencyOption);
+    cmdLineParser.addOption(bandwidthOption);
+    cmdLineParser.addOption(noIdleDelayOption);
+    cmdLineParser.addPositionalArgument("trace", QObject::tr("Trace file"));
+    cmdLineParser.process(app);
+
+    if (1!=cmdLineParser.positionalArguments().count()) {
+        cmdLineParser.showHelp(1);
+    }
+
+    MpdTrace trace;
+    if (!trace.load(cmdLineParser.positionalArguments().at(0))) {
+        return 1;
+    }
+
+    ReplayServer server(trace);
+    server.setLatency(cmdLineParser.value(latencyOption).toInt());
+    server.setBandwidth(cmdLineParser.value(bandwidthOption).toInt());
+    server.setRecordedIdleDelays(!cmdLineParser.isSet(noIdleDelayOption));
+    if (!server.listen(cmdLineParser.value(listenOption))) {
+        qWarning() << "Failed to listen on" << cmdLineParser.value(listenOption);
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,270 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replayserver.h"
+#include "virtualmpd.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QMutexLocker>
+#include <QDebug>
+
+static const int constWriteInterval=50; // ms between writes when limiting bandwidth
+
+ReplayClient::ReplayClient(ReplayServer *s, QIODevice *d)
+    : QObject(s)
+    , server(s)
+    , dev(d)
+    , inCommandList(false)
+    , idling(false)
+{
+    dev->setParent(this);
+    idleTimer=new QTimer(this);
+    idleTimer->setSingleShot(true);
+    writeTimer=new QTimer(this);
+    writeTimer->setSingleShot(true);
+    connect(idleTimer, SIGNAL(timeout()), this, SLOT(sendIdleReply()));
+    connect(writeTimer, SIGNAL(timeout()), this, SLOT(writePending()));
+    connect(dev, SIGNAL(readyRead()), this, SLOT(readCommands()));
+    connect(dev, SIGNAL(disconnected()), this, SLOT(deleteLater()));
+    send(server->greeting());
+}
+
+void ReplayClient::readCommands()
+{
+    buffer+=dev->readAll();
+    for (int end=buffer.indexOf('\n'); -1!=end; end=buffer.indexOf('\n')) {
+        QByteArray line=buffer.left(end);
+        buffer.remove(0, end+1);
+        if (inCommandList) {
+            commandList.append(line);
+            if ("command_list_end"==line) {
+                inCommandList=false;
+                QByteArray command;
+                for (const QByteArray &l: commandList) {
+                    if (!command.isEmpty()) {
+                        command+='\n';
+                    }
+                    command+=l;
+                }
+                commandList.clear();
+                handle(command);
+            }
+        } else if ("command_list_begin"==line || "command_list_ok_begin"==line) {
+            inCommandList=true;
+            commandList.append(line);
+        } else {
+            handle(line);
+        }
+    }
+}
+
+void ReplayClient::handle(const QByteArray &command)
+{
+    server->countCommand(command);
+    if ("idle"==command || command.startsWith("idle ")) {
+        qint64 delay=0;
+        idling=true;
+        idleReply.clear();
+        // If there is no more recorded idle data, then wait for "noidle"
+        if (server->nextIdleReply(delay, idleReply)) {
+            idleTimer->start(delay);
+        }
+    } else if ("noidle"==command) {
+        if (idling) {
+            idleTimer->stop();
+            sendIdleReply();
+        }
+    } else if (command.startsWith("password ")) {
+        // Passwords are not recorded
+        send("OK\n");
+    } else if ("close"==command) {
+        dev->close();
+    } else {
+        send(server->reply(command));
+    }
+}
+
+void ReplayClient::sendIdleReply()
+{
+    if (idling) {
+        idling=false;
+        send(idleReply.isEmpty() ? QByteArray("OK\n") : idleReply);
+        idleReply.clear();
+    }
+}
+
+void ReplayClient::send(const QByteArray &data)
+{
+    pending+=data;
+    if (!writeTimer->isActive()) {
+        writeTimer->start(server->getLatency());
+    }
+}
+
+void ReplayClient::writePending()
+{
+    if (pending.isEmpty()) {
+        return;
+    }
+    if (server->getBandwidth()<=0) {
+        dev->write(pending);
+        pending.clear();
+    } else {
+        int chunk=qMax(1, (server->getBandwidth()*constWriteInterval)/1000);
+        dev->write(pending.left(chunk));
+        pending.remove(0, chunk);
+        if (!pending.isEmpty()) {
+            writeTimer->start(constWriteInterval);
+        }
+    }
+}
+
+ReplayServer::ReplayServer(const MpdTrace &trace, QObject *p)
+    : QObject(p)
+    , greetingData(trace.greeting())
+    , tcp(nullptr)
+    , local(nullptr)
+    , latency(0)
+    , bandwidth(0)
+    , idleDelays(true)
+    , virtualMpd(nullptr)
+{
+    const QList<MpdTraceEntry> &entries=trace.entries();
+    qint64 idleTime=-1;
+    for (int i=0; i<entries.count(); ++i) {
+        const MpdTraceEntry &e=entries.at(i);
+        if ('C'==e.type) {
+            if ("idle"==e.data || e.data.startsWith("idle ")) {
+                idleTime=e.time;
+            } else if ("noidle"!=e.data && i+1<entries.count() && 'R'==entries.at(i+1).type) {
+                replies[e.data].append(entries.at(i+1).data);
+            }
+        } else if ('I'==e.type) {
+            idleReplies.append(QPair<qint64, QByteArray>(idleTime<0 ? 0 : qMax((qint64)0, e.time-idleTime), e.data));
+            idleTime=-1;
+        }
+    }
+}
+
+ReplayServer::~ReplayServer()
+{
+    delete virtualMpd;
+}
+
+void ReplayServer::setVirtualMpd(VirtualMpd *v)
+{
+    delete virtualMpd;
+    virtualMpd=v;
+}
+
+int ReplayServer::commandCount(const QByteArray &name) const
+{
+    QMutexLocker locker(&countsMutex);
+    return counts.value(name);
+}
+
+void ReplayServer::clearCommandCounts()
+{
+    QMutexLocker locker(&countsMutex);
+    counts.clear();
+}
+
+// Count each command within a command list separately
+void ReplayServer::countCommand(const QByteArray &command)
+{
+    QMutexLocker locker(&countsMutex);
+    for (const QByteArray &line: command.split('\n')) {
+        if (!line.startsWith("command_list_")) {
+            counts[line.split(' ').first()]++;
+        }
+    }
+}
+
+bool ReplayServer::listen(const QString &address)
+{
+    if (address.startsWith(QLatin1Char('/'))) {
+        local=new QLocalServer(this);
+        QLocalServer::removeServer(address);
+        connect(local, SIGNAL(newConnection()), this, SLOT(newLocalConnection()));
+        return local->listen(address);
+    }
+    tcp=new QTcpServer(this);
+    connect(tcp, SIGNAL(newConnection()), this, SLOT(newTcpConnection()));
+    return tcp->listen(QHostAddress::LocalHost, address.toUShort());
+}
+
+quint16 ReplayServer::port() const
+{
+    return tcp ? tcp->serverPort() : 0;
+}
+
+QByteArray ReplayServer::reply(const QByteArray &command)
+{
+    QHash<QByteArray, QList<QByteArray> >::Iterator it=replies.find(command);
+    if (it!=replies.end() && !it.value().isEmpty()) {
+        QByteArray r=it.value().takeFirst();
+        lastReplies.insert(command, r);
+        return r;
+    }
+    QHash<QByteArray, QByteArray>::ConstIterator last=lastReplies.constFind(command);
+    if (last!=lastReplies.constEnd()) {
+        return last.value();
+    }
+    if (virtualMpd) {
+        QByteArray r=virtualMpd->reply(command);
+        if (!r.isEmpty()) {
+            return r;
+        }
+    }
+    QByteArray name=command.split('\n').first().split(' ').first();
+    qWarning() << "No recorded reply for" << command.left(80);
+    return "ACK [5@0] {"+name+"} unknown command \""+name+"\"\n";
+}
+
+bool ReplayServer::nextIdleReply(qint64 &delay, QByteArray &data)
+{
+    if (idleReplies.isEmpty()) {
+        return false;
+    }
+    QPair<qint64, QByteArray> r=idleReplies.takeFirst();
+    delay=idleDelays ? r.first : 0;
+    data=r.second;
+    return true;
+}
+
+void ReplayServer::newTcpConnection()
+{
+    while (tcp->hasPendingConnections()) {
+        new ReplayClient(this, tcp->nextPendingConnection());
+    }
+}
+
+void ReplayServer::newLocalConnection()
+{
+    while (local->hasPendingConnections()) {
+        new ReplayClient(this, local->nextPendingConnection());
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef REPLAY_SERVER_H
+#define REPLAY_SERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QByteArray>
+#include <QMutex>
+#include "mpdtrace.h"
+
+class QIODevice;
+class QTcpServer;
+class QLocalServer;
+class QTimer;
+class ReplayServer;
+class VirtualMpd;
+
+// A single client connection.
+class ReplayClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReplayClient(ReplayServer *s, QIODevice *d);
+    ~ReplayClient() override { }
+
+private Q_SLOTS:
+    void readCommands();
+    void sendIdleReply();
+    void writePending();
+
+private:
+    void handle(const QByteArray &command);
+    void send(const QByteArray &data);
+
+private:
+    ReplayServer *server;
+    QIODevice *dev;
+    QByteArray buffer;
+    QList<QByteArray> commandList;
+    bool inCommandList;
+    bool idling;
+    QTimer *idleTimer;
+    QByteArray idleReply;
+    QTimer *writeTimer;
+    QByteArray pending;
+};
+
+// Serves the responses from an MPD trace. Each command is answered with the next recorded reply to that
+// exact command (the last reply is repeated once these run out), and each "idle" with the next recorded
+// idle data, after the recorded delay. Latency is added before each reply, and replies are written no
+// faster than the bandwidth (bytes per second) - if these are set. Commands with no recorded reply may be
+// answered by a VirtualMpd.
+class ReplayServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ReplayServer(const MpdTrace &trace, QObject *p=nullptr);
+    ~ReplayServer() override;
+
+    // Listen on a local socket if address starts with '/', otherwise on the given port (0 => any free port)
+    bool listen(const QString &address);
+    quint16 port() const;
+    void setLatency(int ms) { latency=ms; }
+    int getLatency() const { return latency; }
+    void setBandwidth(int bytesPerSecond) { bandwidth=bytesPerSecond; }
+    int getBandwidth() const { return bandwidth; }
+    // If false, idle data is served as soon as "idle" is received
+    void setRecordedIdleDelays(bool r) { idleDelays=r; }
+    // Server takes ownership
+    void setVirtualMpd(VirtualMpd *v);
+
+    // Number of times each command (by name) has been received - may be called from any thread
+    int commandCount(const QByteArray &name) const;
+    void clearCommandCounts();
+    void countCommand(const QByteArray &command);
+
+    const QByteArray & greeting() const { return greetingData; }
+    QByteArray reply(const QByteArray &command);
+    bool nextIdleReply(qint64 &delay, QByteArray &data);
+
+private Q_SLOTS:
+    void newTcpConnection();
+    void newLocalConnection();
+
+private:
+    QByteArray greetingData;
+    QHash<QByteArray, QList<QByteArray> > replies;
+    QHash<QByteArray, QByteArray> lastReplies;
+    QList<QPair<qint64, QByteArray> > idleReplies;
+    QTcpServer *tcp;
+    QLocalServer *local;
+    int latency;
+    int bandwidth;
+    bool idleDelays;
+    VirtualMpd *virtualMpd;
+    mutable QMutex countsMutex;
+    QHash<QByteArray, int> counts;
+};
+
+#endif
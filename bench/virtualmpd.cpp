@@ -0,0 +1,304 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "virtualmpd.h"
+#include "mpdtrace.h"
+#include <QSet>
+
+static const QByteArray constLastModified("Last-Modified: 2020-09-13T12:26:40Z\n");
+static const QByteArray constNoSuchDir("ACK [50@0] {lsinfo} No such directory\n");
+static const int constDbUpdate=1600000000;
+
+// Commands that only alter player state
+static const QSet<QByteArray> constPlayerCommands=QSet<QByteArray>()
+        << "play" << "playid" << "pause" << "stop" << "next" << "previous" << "seek" << "seekid" << "seekcur"
+        << "setvol" << "random" << "repeat" << "single" << "consume" << "crossfade" << "replay_gain_mode"
+        << "subscribe" << "channels" << "currentsong" << "clearerror" << "add";
+
+VirtualMpd::VirtualMpd(int queue, int library)
+    : queueLength(queue)
+    , librarySize(library)
+{
+}
+
+QList<QByteArray> VirtualMpd::split(const QByteArray &command)
+{
+    QList<QByteArray> parts;
+    QByteArray current;
+    bool inQuote=false;
+    bool haveArg=false;
+    for (int i=0; i<command.length(); ++i) {
+        char c=command.at(i);
+        if (inQuote) {
+            if ('\\'==c && i+1<command.length()) {
+                current+=command.at(++i);
+            } else if ('\"'==c) {
+                inQuote=false;
+            } else {
+                current+=c;
+            }
+        } else if ('\"'==c) {
+            inQuote=haveArg=true;
+        } else if (' '==c) {
+            if (haveArg || !current.isEmpty()) {
+                parts.append(current);
+            }
+            current.clear();
+            haveArg=false;
+        } else {
+            current+=c;
+        }
+    }
+    if (haveArg || !current.isEmpty()) {
+        parts.append(current);
+    }
+    return parts;
+}
+
+QByteArray VirtualMpd::reply(const QByteArray &command)
+{
+    if (!command.startsWith("command_list_")) {
+        return replyTo(command);
+    }
+
+    QList<QByteArray> lines=command.split('\n');
+    bool listOk="command_list_ok_begin"==lines.first();
+    QByteArray data;
+    for (const QByteArray &line: lines) {
+        if (line.startsWith("command_list_")) {
+            continue;
+        }
+        QByteArray r=replyTo(line);
+        if (r.isEmpty() || r.startsWith("ACK ")) {
+            return r;
+        }
+        data+=r.left(r.length()-3); // Remove "OK\n"
+        if (listOk) {
+            data+="list_OK\n";
+        }
+    }
+    return data+"OK\n";
+}
+
+QByteArray VirtualMpd::replyTo(const QByteArray &command)
+{
+    QList<QByteArray> args=split(command);
+    if (args.isEmpty()) {
+        return QByteArray();
+    }
+    QByteArray name=args.takeFirst();
+    if ("status"==name) {
+        return status();
+    } else if ("stats"==name) {
+        return stats();
+    } else if ("playlistinfo"==name) {
+        return playlistInfo(args);
+    } else if ("list"==name) {
+        return list(args);
+    } else if ("lsinfo"==name) {
+        return lsinfo(args);
+    } else if ("count"==name) {
+        return count(args);
+    } else if ("listall"==name) {
+        return listall(args);
+    } else if ("outputs"==name) {
+        return "outputid: 0\noutputname: Default\nplugin: alsa\noutputenabled: 1\nOK\n";
+    } else if ("listpartitions"==name) {
+        return "partition: default\nOK\n";
+    } else if ("urlhandlers"==name) {
+        return "handler: http://\nhandler: https://\nOK\n";
+    } else if ("tagtypes"==name) {
+        return "tagtype: Artist\ntagtype: AlbumArtist\ntagtype: Album\ntagtype: Title\ntagtype: Track\ntagtype: Genre\n"
+               "tagtype: Date\ntagtype: Disc\nOK\n";
+    } else if ("commands"==name) {
+        QByteArray data;
+        for (const QByteArray &cmd: QList<QByteArray>() << "count" << "list" << "listall" << "lsinfo" << "playlistinfo"
+                                                         << "stats" << "status" << "outputs") {
+            data+="command: "+cmd+'\n';
+        }
+        return data+"OK\n";
+    } else if ("replay_gain_status"==name) {
+        return "replay_gain_mode: off\nOK\n";
+    } else if (constPlayerCommands.contains(name)) {
+        return "OK\n";
+    }
+    return QByteArray();
+}
+
+QByteArray VirtualMpd::status() const
+{
+    return "volume: 50\nrepeat: 0\nrandom: 0\nsingle: 0\nconsume: 0\nplaylist: 2\nplaylistlength: "+
+           QByteArray::number(queueLength)+"\nmixrampdb: 0.000000\nstate: stop\nOK\n";
+}
+
+QByteArray VirtualMpd::stats() const
+{
+    return "artists: "+QByteArray::number((librarySize+99)/100)+"\nalbums: "+QByteArray::number((librarySize+9)/10)+
+           "\nsongs: "+QByteArray::number(librarySize)+"\nuptime: 10\ndb_playtime: "+QByteArray::number(librarySize*200)+
+           "\ndb_update: "+QByteArray::number(constDbUpdate)+"\nplaytime: 10\nOK\n";
+}
+
+// "playlistinfo", or "playlistinfo START:END"
+QByteArray VirtualMpd::playlistInfo(const QList<QByteArray> &args) const
+{
+    int start=0;
+    int end=queueLength;
+    if (!args.isEmpty()) {
+        QList<QByteArray> range=args.first().split(':');
+        start=range.first().toInt();
+        end=range.count()>1 && !range.at(1).isEmpty() ? qMin(range.at(1).toInt(), queueLength) : start+1;
+        if (start<0 || start>=queueLength) {
+            return "ACK [2@0] {playlistinfo} Bad song index\n";
+        }
+    }
+    QByteArray data;
+    for (int i=start; i<end; ++i) {
+        data+=MpdTrace::song(i)+"Pos: "+QByteArray::number(i)+"\nId: "+QByteArray::number(i+1)+'\n';
+    }
+    return data+"OK\n";
+}
+
+QByteArray VirtualMpd::list(const QList<QByteArray> &args) const
+{
+    if (args.isEmpty()) {
+        return "ACK [2@0] {list} too few arguments for \"list\"\n";
+    }
+    int artists=(librarySize+99)/100;
+    QByteArray type=args.first().toLower();
+    QByteArray data;
+    if ("genre"==type) {
+        for (int i=0; i<qMin(artists, 20); ++i) {
+            data+="Genre: Genre "+QByteArray::number(i)+'\n';
+        }
+    } else if ("artist"==type || "albumartist"==type) {
+        for (int i=0; i<artists; ++i) {
+            data+=(("artist"==type) ? "Artist: Artist " : "AlbumArtist: Artist ")+QByteArray::number(i)+'\n';
+        }
+    }
+    return data+"OK\n";
+}
+
+// Range of songs within a folder, returns false if there is no such folder
+bool VirtualMpd::songRange(const QByteArray &dir, int &first, int &last) const
+{
+    QByteArray path=dir;
+    while (path.startsWith('/')) {
+        path=path.mid(1);
+    }
+    while (path.endsWith('/')) {
+        path.chop(1);
+    }
+    if (path.isEmpty()) {
+        first=0;
+        last=librarySize;
+        return true;
+    }
+
+    QList<QByteArray> parts=path.split('/');
+    bool ok=false;
+    if (parts.count()>2 || !parts.at(0).startsWith("Artist ")) {
+        return false;
+    }
+    int artist=parts.at(0).mid(7).toInt(&ok);
+    if (!ok || artist<0 || artist*100>=librarySize) {
+        return false;
+    }
+    if (1==parts.count()) {
+        first=artist*100;
+        last=qMin(first+100, librarySize);
+        return true;
+    }
+    if (!parts.at(1).startsWith("Album ")) {
+        return false;
+    }
+    int album=parts.at(1).mid(6).toInt(&ok);
+    if (!ok || album/10!=artist || album*10>=librarySize) {
+        return false;
+    }
+    first=album*10;
+    last=qMin(first+10, librarySize);
+    return true;
+}
+
+// Folder listing - folders contain either sub-folders (root and artists), or songs (albums)
+QByteArray VirtualMpd::lsinfo(const QList<QByteArray> &args) const
+{
+    QByteArray dir=args.isEmpty() ? QByteArray() : args.first();
+    int first=0;
+    int last=0;
+    if (!songRange(dir, first, last)) {
+        return constNoSuchDir;
+    }
+    QByteArray data;
+    int depth=dir.isEmpty() || "/"==dir ? 0 : dir.count('/')+1;
+    if (depth<2) {
+        int step=0==depth ? 100 : 10;
+        for (int i=first; i<last; i+=step) {
+            data+="directory: Artist "+QByteArray::number(i/100)+(0==depth ? QByteArray() : ("/Album "+QByteArray::number(i/10)))+'\n'+constLastModified;
+        }
+    } else {
+        for (int i=first; i<last; ++i) {
+            data+=MpdTrace::song(i)+constLastModified;
+        }
+    }
+    return data+"OK\n";
+}
+
+// "count (base \"DIR\")"
+QByteArray VirtualMpd::count(const QList<QByteArray> &args) const
+{
+    if (args.isEmpty() || !args.first().startsWith("(base ") || !args.first().endsWith(')')) {
+        return "ACK [2@0] {count} Unsupported filter\n";
+    }
+    QByteArray filter=args.first();
+    QList<QByteArray> base=split(filter.mid(6, filter.length()-7));
+    int first=0;
+    int last=0;
+    if (base.isEmpty() || !songRange(base.first(), first, last)) {
+        return "songs: 0\nplaytime: 0\nOK\n";
+    }
+    return "songs: "+QByteArray::number(last-first)+"\nplaytime: "+QByteArray::number((last-first)*200)+"\nOK\n";
+}
+
+// Every folder and file beneath a folder
+QByteArray VirtualMpd::listall(const QList<QByteArray> &args) const
+{
+    QByteArray dir=args.isEmpty() ? QByteArray() : args.first();
+    int first=0;
+    int last=0;
+    if (!songRange(dir, first, last)) {
+        return "ACK [50@0] {listall} No such directory\n";
+    }
+    QByteArray data;
+    int depth=dir.isEmpty() || "/"==dir ? 0 : dir.count('/')+1;
+    for (int i=first; i<last; ++i) {
+        if (0==depth && 0==i%100) {
+            data+="directory: Artist "+QByteArray::number(i/100)+'\n';
+        }
+        if (depth<2 && 0==i%10) {
+            data+="directory: Artist "+QByteArray::number(i/100)+"/Album "+QByteArray::number(i/10)+'\n';
+        }
+        data+="file: Artist "+QByteArray::number(i/100)+"/Album "+QByteArray::number(i/10)+'/'+QByteArray::number((i%10)+1)+".flac\n";
+    }
+    return data+"OK\n";
+}
@@ -0,0 +1,62 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VIRTUAL_MPD_H
+#define VIRTUAL_MPD_H
+
+#include <QByteArray>
+#include <QList>
+
+// Simulated MPD server, with a synthetic library and play queue - using the same songs as
+// MpdTrace::songs(). Answers the commands that Cantata sends when connecting, loading the play queue
+// (in full, or in pages), and loading or enumerating the library. Songs are in "Artist N/Album M"
+// folders. Commands that only change player state, or add to the play queue, are acknowledged - but
+// otherwise ignored.
+class VirtualMpd
+{
+public:
+    VirtualMpd(int queueLength, int librarySize);
+
+    // Reply to command (or command list), or an empty array if this is not known
+    QByteArray reply(const QByteArray &command);
+
+    // Split command into its name and (unquoted) arguments
+    static QList<QByteArray> split(const QByteArray &command);
+
+private:
+    QByteArray replyTo(const QByteArray &command);
+    QByteArray status() const;
+    QByteArray stats() const;
+    QByteArray playlistInfo(const QList<QByteArray> &args) const;
+    QByteArray list(const QList<QByteArray> &args) const;
+    QByteArray lsinfo(const QList<QByteArray> &args) const;
+    QByteArray count(const QList<QByteArray> &args) const;
+    QByteArray listall(const QList<QByteArray> &args) const;
+    bool songRange(const QByteArray &dir, int &first, int &last) const;
+
+private:
+    int queueLength;
+    int librarySize;
+};
+
+#endif
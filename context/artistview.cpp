@@ -79,17 +79,11 @@ static QString buildUrl(const QString &artist)
     return url.toString();
 }
 
-static QString checkHaveArtist(const QSet<QString> &mpdArtists, const QString &artist)
+static QString checkHaveArtist(const QString &artist)
 {
-    if (mpdArtists.contains(artist)) {
-        return QLatin1String("<a href=\"")+buildUrl(artist)+QLatin1String("\">")+artist+QLatin1String("</a>");
-    } else {
-        // Check for AC/DC -> AC-DC
-        QString mod=artist;
-        mod=mod.replace("/", "-");
-        if (mod!=artist && mpdArtists.contains(mod)) {
-            return QLatin1String("<a href=\"")+buildUrl(mod)+QLatin1String("\">")+artist+QLatin1String("</a>");
-        }
+    QString mpdArtist=MpdLibraryModel::self()->resolveArtist(artist);
+    if (!mpdArtist.isEmpty()) {
+        return QLatin1String("<a href=\"")+buildUrl(mpdArtist)+QLatin1String("\">")+artist+QLatin1String("</a>");
     }
     return QString();
 }
@@ -423,24 +417,13 @@ QStringList ArtistView::parseSimilarResponse(const QByteArray &resp)
 
 void ArtistView::buildSimilar(const QStringList &artists)
 {
-    QSet<QString> mpdArtists=MpdLibraryModel::self()->getArtists();
-    QSet<QString> mpdLowerArtists;
     bool first=true;
     for (QString artist: artists) {
         if (similarArtists.isEmpty()) {
             similarArtists=QLatin1String("<br/>")+View::subHeader(tr("Similar Artists"));
         }
         // Check if we have artist in collection...
-        QString artistLink=checkHaveArtist(mpdArtists, artist);
-        if (artistLink.isEmpty()) {
-            // ...and check case-insensitively...
-            if (mpdLowerArtists.isEmpty()) {
-                for (const QString &a: mpdArtists) {
-                    mpdLowerArtists.insert(a.toLower());
-                }
-            }
-            artistLink=checkHaveArtist(mpdLowerArtists, artist.toLower());
-        }
+        QString artistLink=checkHaveArtist(artist);
         if (!artistLink.isEmpty()) {
             artist=artistLink;
         }
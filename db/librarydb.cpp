@@ -22,17 +22,21 @@
  */
 
 #include "librarydb.h"
+#include "librarydbreader.h"
 #include <QCoreApplication>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QFile>
+#include <QHash>
 #include <QRegExp>
 #include <QRandomGenerator>
+#include <QReadWriteLock>
 #include <QDebug>
 #include <algorithm>
 
 static const int constSchemaVersion=5;
+static const int constMinSampleRebuild=100;
 
 bool LibraryDb::dbgEnabled=false;
 #define DBUG if (dbgEnabled) qWarning() << metaObject()->className() << __FUNCTION__ << (void *)this
@@ -387,6 +391,14 @@ static QString albumSort(const Song &s)
     return Song::sortString(s.album);
 }
 
+// Song values, as stored in the songs table, that are shown in artist and album items, or that these are
+// sorted by. Changes to any of these require the items to be reloaded.
+static QString fileDetails(const QString &album, const QString &sortAlbum, const QString &sortArtist, int year, int origYear, int time)
+{
+    return album+QLatin1Char('\n')+sortAlbum+QLatin1Char('\n')+sortArtist+QLatin1Char('\n')+
+           QString::number(year)+QLatin1Char('\n')+QString::number(origYear)+QLatin1Char('\n')+QString::number(time);
+}
+
 // Code taken from Clementine's LibraryQuery
 class SqlQuery
 {
@@ -502,13 +514,19 @@ LibraryDb::LibraryDb(QObject *p, const QString &name)
     , newVersion(0)
     , db(nullptr)
     , insertSongQuery(nullptr)
+    , dbReader(nullptr)
+    , sampleIndex(new SampleIndex())
+    , artistIndexVersion(0)
+    , trackChanges(false)
 {
     DBUG;
 }
 
 LibraryDb::~LibraryDb()
 {
+    delete dbReader;
     reset();
+    delete sampleIndex;
 }
 
 void LibraryDb::clear()
@@ -523,9 +541,17 @@ void LibraryDb::clear()
 
 void LibraryDb::erase()
 {
+    // Wait for any in-progress asynchronous read, and block new ones, whilst the files are removed
+    QWriteLocker locker(dbReader ? dbReader->fileLock() : nullptr);
+    if (dbReader) {
+        dbReader->closeConnections();
+    }
     reset();
     if (!dbFileName.isEmpty() && QFile::exists(dbFileName)) {
         QFile::remove(dbFileName);
+        // Remove WAL files, otherwise SQLite would apply these to the new DB
+        QFile::remove(dbFileName+QLatin1String("-wal"));
+        QFile::remove(dbFileName+QLatin1String("-shm"));
     }
 }
 
@@ -578,6 +604,7 @@ bool LibraryDb::init(const QString &dbFile)
         DBUG << "Failed to open";
         return false;
     }
+    setPragmas(false);
 
     if (!createTable("versions(collection integer, schema integer)")) {
         DBUG << "Failed to create versions table";
@@ -641,6 +668,104 @@ bool LibraryDb::init(const QString &dbFile)
     return true;
 }
 
+bool LibraryDb::initReadOnly(const QString &dbFile)
+{
+    reset();
+    dbFileName=dbFile;
+    currentVersion=0;
+    db=new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", dbName));
+    if (!db->isValid()) {
+        reset();
+        return false;
+    }
+    db->setDatabaseName(dbFile);
+    db->setConnectOptions(QLatin1String("QSQLITE_OPEN_READONLY"));
+    if (!db->open()) {
+        DBUG << "Failed to open";
+        reset();
+        return false;
+    }
+    setPragmas(true);
+    refreshReadOnly();
+    DBUG << dbFile << currentVersion;
+    return true;
+}
+
+// Re-read the collection version of a read-only connection that is being reused, as the DB may have
+// been updated since it was opened.
+bool LibraryDb::refreshReadOnly()
+{
+    if (!db) {
+        return false;
+    }
+    QSqlQuery query("select collection from versions", *db);
+    currentVersion=query.next() ? query.value(0).toUInt() : 0;
+    return true;
+}
+
+void LibraryDb::setPragmas(bool readOnly)
+{
+    QSqlQuery query(*db);
+    if (readOnly) {
+        query.exec("pragma query_only=1");
+    } else {
+        // WAL allows the async readers to continue whilst the library is being updated
+        query.exec("pragma journal_mode=wal");
+        query.exec("pragma synchronous=normal");
+    }
+    query.exec("pragma cache_size=-8192"); // KiB
+    query.exec("pragma mmap_size=67108864");
+    query.exec("pragma temp_store=memory");
+}
+
+LibraryDb::ReadResult LibraryDb::read(const ReadRequest &req)
+{
+    ReadResult result(req);
+    if (!db) {
+        return result;
+    }
+    switch (req.type) {
+    case Read_Genres:
+        result.genres=getGenres();
+        break;
+    case Read_Artists:
+        result.artists=getArtists();
+        break;
+    case Read_Albums:
+        result.albums=getAlbums(QString(), QString(), req.sort);
+        break;
+    case Read_GenreArtists:
+        result.artists=getArtists(req.genre);
+        break;
+    case Read_ArtistAlbums:
+        result.albums=getAlbums(req.artistId, req.genre, req.sort);
+        break;
+    case Read_AlbumTracks:
+        result.tracks=getTracks(req.artistId, req.albumId, req.genre, req.sort);
+        break;
+    }
+    result.ok=true;
+    return result;
+}
+
+bool LibraryDb::readAsync(ReadRequest &req)
+{
+    // Nothing to read, so no point using a worker
+    if (!db || 0==currentVersion || dbFileName.isEmpty()) {
+        return false;
+    }
+    if (!dbReader) {
+        dbReader=new LibraryDbReader(dbName);
+        connect(dbReader, SIGNAL(retrieved(LibraryDb::ReadResult)), this, SIGNAL(retrieved(LibraryDb::ReadResult)));
+    }
+    req.dbFile=dbFileName;
+    req.filter=filter;
+    req.genreFilter=genreFilter;
+    req.yearFilter=yearFilter;
+    dbReader->request(req);
+    return true;
+}
+
 void LibraryDb::insertSong(const Song &s)
 {
     if (!db) {
@@ -675,6 +800,78 @@ void LibraryDb::insertSong(const Song &s)
     if (!insertSongQuery->exec()) {
         qWarning() << "insert failed" << insertSongQuery->lastError().text() << newVersion << s.file;
     }
+    if (trackChanges) {
+        QString genres;
+        for (int i=0; i<Song::constNumGenres; ++i) {
+            if (i) {
+                genres+=QLatin1Char('\n');
+            }
+            genres+=s.genres[i].isEmpty() ? constNullGenre : s.genres[i];
+        }
+        recordChange(s, FileState(s.lastModified, s.albumArtistOrComposer(), albumId, genres,
+                                  fileDetails(s.album==albumId ? QString() : s.album, albumSort(s), artistSort(s), s.year, s.origYear, s.time)));
+    }
+}
+
+// Read the current state of each file, prior to the songs table being cleared for an update.
+void LibraryDb::readFileStates()
+{
+    QString columns("file, lastModified, artistId, albumId, album, albumSort, artistSort, year, origYear, time");
+    for (int i=0; i<Song::constNumGenres; ++i) {
+        columns+=", genre"+QString::number(i+1);
+    }
+    SqlQuery query(columns, *db);
+    query.exec();
+    DBUG << query.executedQuery();
+    while (query.next()) {
+        QString genres;
+        for (int i=0; i<Song::constNumGenres; ++i) {
+            if (i) {
+                genres+=QLatin1Char('\n');
+            }
+            genres+=query.value(10+i).toString();
+        }
+        prevFiles.insert(query.value(0).toString(), FileState(query.value(1).toUInt(), query.value(2).toString(), query.value(3).toString(), genres,
+                                                              fileDetails(query.value(4).toString(), query.value(5).toString(), query.value(6).toString(),
+                                                                          query.value(7).toInt(), query.value(8).toInt(), query.value(9).toInt())));
+    }
+    DBUG << "previous files" << prevFiles.count() << timer.elapsed();
+}
+
+void LibraryDb::addChangedKeys(const QString &artistId, const QString &albumId, const QString &genres)
+{
+    changes.artists.insert(artistId);
+    changes.albums.insert(qMakePair(artistId, albumId));
+    for (const QString &genre: genres.split(QLatin1Char('\n'))) {
+        if (genre!=constNullGenre) {
+            changes.genres.insert(genre);
+        }
+    }
+}
+
+void LibraryDb::recordChange(const Song &s, const FileState &state)
+{
+    QHash<QString, FileState>::Iterator it=prevFiles.find(s.file);
+    if (it==prevFiles.end()) {
+        changes.added.append(s.file);
+        addChangedKeys(state.artistId, state.albumId, state.genres);
+        return;
+    }
+
+    const FileState &prev=it.value();
+    bool keysChanged=prev.artistId!=state.artistId || prev.albumId!=state.albumId || prev.genres!=state.genres;
+    if (keysChanged || prev.lastModified!=state.lastModified) {
+        changes.modified.append(s.file);
+        if (prev.details!=state.details) {
+            changes.detailsChanged=true;
+        }
+        if (keysChanged) {
+            changes.keysChanged=true;
+            addChangedKeys(prev.artistId, prev.albumId, prev.genres);
+        }
+        addChangedKeys(state.artistId, state.albumId, state.genres);
+    }
+    prevFiles.erase(it);
 }
 
 QList<LibraryDb::Genre> LibraryDb::getGenres()
@@ -1031,32 +1228,284 @@ QList<LibraryDb::Album> LibraryDb::getAlbumsWithArtistOrComposer(const QString &
     return albums;
 }
 
-LibraryDb::Album LibraryDb::getRandomAlbum(const QString &genre, const QString &artist)
+// Albums, and their per-genre and per-artist positions, used to pick random albums without having
+// to sort the songs table on each request. Index lists are kept in ascending order. After an update
+// the index is adjusted for just the albums that have changed; removed albums leave unused slots, which
+// are re-used for added albums.
+struct LibraryDb::SampleIndex
 {
-    Album al;
-    if (0!=currentVersion && db) {
-        SqlQuery query("artistId, albumId", *db);
-        query.setOrder("random()");
-        query.setLimit(1);
-        if (!artist.isEmpty()) {
-            query.addWhere("artistId", artist);
+    SampleIndex() : version(0) { }
+    void clear()
+    {
+        version=0;
+        albums.clear();
+        tracks.clear();
+        albumGenres.clear();
+        keys.clear();
+        unused.clear();
+        all.clear();
+        genres.clear();
+        artists.clear();
+        year=QString();
+        inYear.clear();
+    }
+
+    time_t version;
+    QVector<Album> albums;
+    QVector<int> tracks; // Number of tracks in each album
+    QVector<QStringList> albumGenres;
+    QHash<QString, int> keys;
+    QVector<int> unused;
+    QVector<int> all;
+    QHash<QString, QVector<int> > genres;
+    QHash<QString, QVector<int> > artists;
+    QString year; // yearFilter that inYear was created for
+    QVector<bool> inYear;
+};
+
+static inline QString sampleKey(const QString &artistId, const QString &albumId)
+{
+    return artistId+QLatin1Char('\n')+albumId;
+}
+
+static void insertSorted(QVector<int> &list, int idx)
+{
+    if (list.isEmpty() || list.last()<idx) {
+        list.append(idx);
+    } else {
+        QVector<int>::Iterator it=std::lower_bound(list.begin(), list.end(), idx);
+        if (it==list.end() || *it!=idx) {
+            list.insert(it, idx);
         }
-        if (!genre.isEmpty()) {
-            query.addWhere("genre", genre);
-        } else if (!genreFilter.isEmpty()) {
-            query.addWhere("genre", genreFilter);
+    }
+}
+
+static void removeSorted(QVector<int> &list, int idx)
+{
+    QVector<int>::Iterator it=std::lower_bound(list.begin(), list.end(), idx);
+    if (it!=list.end() && *it==idx) {
+        list.erase(it);
+    }
+}
+
+static QString sampleGenreColumns()
+{
+    QString columns;
+    for (int i=0; i<Song::constNumGenres; ++i) {
+        if (i) {
+            columns+=", ";
         }
-        if (!yearFilter.isEmpty()) {
-            query.addWhere("year", yearFilter);
+        columns+="genre"+QString::number(i+1);
+    }
+    return columns;
+}
+
+// Add genres, and track count, read from query (starting at column 'col') to album's slot
+static void addSampleDetails(QSqlQuery &query, int col, int idx, QVector<int> &tracks, QVector<QStringList> &albumGenres)
+{
+    for (int i=0; i<Song::constNumGenres; ++i) {
+        QString genre=query.value(col+i).toString();
+        if (!genre.isEmpty() && !albumGenres[idx].contains(genre)) {
+            albumGenres[idx].append(genre);
+        }
+    }
+    tracks[idx]+=query.value(col+Song::constNumGenres).toInt();
+}
+
+bool LibraryDb::updateSampleIndex()
+{
+    if (0==currentVersion || !db) {
+        return false;
+    }
+
+    if (sampleIndex->version!=currentVersion) {
+        sampleIndex->clear();
+        QString genreColumns=sampleGenreColumns();
+        QSqlQuery query(*db);
+        query.exec("select artistId, albumId, "+genreColumns+", count(*) from songs group by artistId, albumId, "+genreColumns+
+                   " order by artistId, albumId");
+        DBUG << query.executedQuery();
+        while (query.next()) {
+            QString artistId=query.value(0).toString();
+            QString albumId=query.value(1).toString();
+            QString key=sampleKey(artistId, albumId);
+            QHash<QString, int>::ConstIterator it=sampleIndex->keys.constFind(key);
+            int idx=0;
+            if (it==sampleIndex->keys.constEnd()) {
+                idx=sampleIndex->albums.size();
+                Album al;
+                al.artist=artistId;
+                al.id=albumId;
+                sampleIndex->albums.append(al);
+                sampleIndex->tracks.append(0);
+                sampleIndex->albumGenres.append(QStringList());
+                sampleIndex->keys.insert(key, idx);
+                sampleIndex->all.append(idx);
+                sampleIndex->artists[artistId].append(idx);
+            } else {
+                idx=it.value();
+            }
+            addSampleDetails(query, 2, idx, sampleIndex->tracks, sampleIndex->albumGenres);
         }
+        // Rows are ordered by album, so each genre's list is created in ascending order
+        for (int idx=0; idx<sampleIndex->albums.size(); ++idx) {
+            for (const QString &genre: sampleIndex->albumGenres.at(idx)) {
+                sampleIndex->genres[genre].append(idx);
+            }
+        }
+        sampleIndex->version=currentVersion;
+        DBUG << "albums" << sampleIndex->albums.size() << "genres" << sampleIndex->genres.size();
+    }
+
+    if (yearFilter.isEmpty()) {
+        sampleIndex->year=QString();
+        sampleIndex->inYear.clear();
+    } else if (yearFilter!=sampleIndex->year) {
+        sampleIndex->inYear=QVector<bool>(sampleIndex->albums.size(), false);
+        SqlQuery query("distinct artistId, albumId", *db);
+        query.setFilter(QString(), yearFilter);
         query.exec();
         DBUG << query.executedQuery();
-        if (query.next()) {
-            al.artist=query.value(0).toString();
-            al.id=query.value(1).toString();
+        while (query.next()) {
+            QHash<QString, int>::ConstIterator it=sampleIndex->keys.constFind(sampleKey(query.value(0).toString(), query.value(1).toString()));
+            if (it!=sampleIndex->keys.constEnd()) {
+                sampleIndex->inYear[it.value()]=true;
+            }
+        }
+        sampleIndex->year=yearFilter;
+    }
+    return true;
+}
+
+// Adjust the sampling index, which was created for the previous collection version, for the albums
+// listed in changes. If most albums have changed, then it is quicker to just rebuild the index when next
+// needed.
+void LibraryDb::updateSampleIndex(const Changes &changes)
+{
+    if (changes.albums.size()>qMax(constMinSampleRebuild, sampleIndex->keys.size()/4)) {
+        sampleIndex->clear();
+        return;
+    }
+
+    QString genreColumns=sampleGenreColumns();
+    QSqlQuery query(*db);
+    query.prepare("select "+genreColumns+", count(*) from songs where artistId=:artistId and albumId=:albumId group by "+genreColumns);
+    for (const QPair<QString, QString> &album: changes.albums) {
+        QString key=sampleKey(album.first, album.second);
+        QHash<QString, int>::ConstIterator it=sampleIndex->keys.constFind(key);
+        int idx=-1;
+        if (it!=sampleIndex->keys.constEnd()) {
+            // Remove from genre lists - as genres may have changed
+            idx=it.value();
+            for (const QString &genre: sampleIndex->albumGenres.at(idx)) {
+                QHash<QString, QVector<int> >::Iterator g=sampleIndex->genres.find(genre);
+                if (g!=sampleIndex->genres.end()) {
+                    removeSorted(g.value(), idx);
+                    if (g.value().isEmpty()) {
+                        sampleIndex->genres.erase(g);
+                    }
+                }
+            }
+            sampleIndex->albumGenres[idx].clear();
+            sampleIndex->tracks[idx]=0;
+        }
+
+        query.bindValue(":artistId", album.first);
+        query.bindValue(":albumId", album.second);
+        query.exec();
+        bool exists=false;
+        while (query.next()) {
+            if (-1==idx) {
+                if (sampleIndex->unused.isEmpty()) {
+                    idx=sampleIndex->albums.size();
+                    sampleIndex->albums.append(Album());
+                    sampleIndex->tracks.append(0);
+                    sampleIndex->albumGenres.append(QStringList());
+                } else {
+                    idx=sampleIndex->unused.takeLast();
+                }
+                sampleIndex->albums[idx].artist=album.first;
+                sampleIndex->albums[idx].id=album.second;
+                sampleIndex->keys.insert(key, idx);
+                insertSorted(sampleIndex->all, idx);
+                insertSorted(sampleIndex->artists[album.first], idx);
+            }
+            addSampleDetails(query, 0, idx, sampleIndex->tracks, sampleIndex->albumGenres);
+            exists=true;
+        }
+
+        if (exists) {
+            for (const QString &genre: sampleIndex->albumGenres.at(idx)) {
+                insertSorted(sampleIndex->genres[genre], idx);
+            }
+        } else if (-1!=idx) {
+            // Album has been removed
+            sampleIndex->keys.remove(key);
+            removeSorted(sampleIndex->all, idx);
+            QHash<QString, QVector<int> >::Iterator a=sampleIndex->artists.find(album.first);
+            if (a!=sampleIndex->artists.end()) {
+                removeSorted(a.value(), idx);
+                if (a.value().isEmpty()) {
+                    sampleIndex->artists.erase(a);
+                }
+            }
+            sampleIndex->albums[idx]=Album();
+            sampleIndex->unused.append(idx);
+        }
+    }
+    sampleIndex->version=currentVersion;
+    // Year membership will be re-read on next request
+    sampleIndex->year=QString();
+    sampleIndex->inYear.clear();
+    DBUG << "albums" << sampleIndex->keys.size() << "genres" << sampleIndex->genres.size() << "changed" << changes.albums.size();
+}
+
+// Albums matching genre/artist, and the current genre and year filters. When no filter needs applying
+// the stored list is returned as-is (i.e. shared, not copied).
+QVector<int> LibraryDb::sampleCandidates(const QString &genre, const QString &artist)
+{
+    QString genreConstraint=genre.isEmpty() ? genreFilter : genre;
+    QVector<int> base;
+    QVector<int> genreList;
+
+    if (!artist.isEmpty()) {
+        base=sampleIndex->artists.value(artist);
+        if (!genreConstraint.isEmpty()) {
+            genreList=sampleIndex->genres.value(genreConstraint);
+            if (genreList.isEmpty()) {
+                return QVector<int>();
+            }
+        }
+    } else if (!genreConstraint.isEmpty()) {
+        base=sampleIndex->genres.value(genreConstraint);
+    } else {
+        base=sampleIndex->all;
+    }
+
+    if (genreList.isEmpty() && sampleIndex->inYear.isEmpty()) {
+        return base;
+    }
+
+    QVector<int> filtered;
+    for (int idx: base) {
+        if ((genreList.isEmpty() || std::binary_search(genreList.constBegin(), genreList.constEnd(), idx)) &&
+            (sampleIndex->inYear.isEmpty() || sampleIndex->inYear.at(idx))) {
+            filtered.append(idx);
         }
     }
-    return al;
+    return filtered;
+}
+
+LibraryDb::Album LibraryDb::getRandomAlbum(const QString &genre, const QString &artist)
+{
+    if (!updateSampleIndex()) {
+        return Album();
+    }
+    QVector<int> candidates=sampleCandidates(genre, artist);
+    if (candidates.isEmpty()) {
+        return Album();
+    }
+    return sampleIndex->albums.at(candidates.at(QRandomGenerator::global()->bounded(candidates.size())));
 }
 
 LibraryDb::Album LibraryDb::getRandomAlbum(const QStringList &genres, const QStringList &artists)
@@ -1064,22 +1513,183 @@ LibraryDb::Album LibraryDb::getRandomAlbum(const QStringList &genres, const QStr
     if (genres.isEmpty() && artists.isEmpty()) {
         return getRandomAlbum(QString(), QString());
     }
+    if (!updateSampleIndex()) {
+        return Album();
+    }
 
-    QList<Album> albums;
-
+    // Each genre, or artist, that has matching albums is equally likely to be chosen
+    QList<QVector<int> > lists;
     for (const QString &genre: genres) {
-        albums.append(getRandomAlbum(genre, QString()));
+        QVector<int> candidates=sampleCandidates(genre, QString());
+        if (!candidates.isEmpty()) {
+            lists.append(candidates);
+        }
     }
 
     for (const QString &artist: artists) {
-        albums.append(getRandomAlbum(QString(), artist));
+        QVector<int> candidates=sampleCandidates(QString(), artist);
+        if (!candidates.isEmpty()) {
+            lists.append(candidates);
+        }
     }
 
-    if (albums.isEmpty()) {
+    if (lists.isEmpty()) {
         return Album();
     }
 
-    return albums.at(QRandomGenerator::global()->bounded(albums.count()));
+    const QVector<int> &candidates=lists.at(QRandomGenerator::global()->bounded(lists.count()));
+    return sampleIndex->albums.at(candidates.at(QRandomGenerator::global()->bounded(candidates.size())));
+}
+
+// Pick 'count' distinct positions from [0, size) - sparse Fisher-Yates, so O(count) regardless of size.
+static QVector<int> samplePositions(int size, int count)
+{
+    QVector<int> positions;
+    QHash<int, int> swapped;
+    count=qMin(count, size);
+    positions.reserve(count);
+    for (int i=0; i<count; ++i) {
+        int j=i+QRandomGenerator::global()->bounded(size-i);
+        positions.append(swapped.value(j, j));
+        swapped[j]=swapped.value(i, i);
+    }
+    return positions;
+}
+
+// Pick 'count' distinct positions from candidates, each weighted by its album's number of tracks. Each pick
+// is a binary search of the cumulative track counts; if too many picks are of albums already picked, then
+// the counts are recalculated without these.
+static QVector<int> weightedPositions(const QVector<int> &candidates, const QVector<int> &tracks, int count)
+{
+    if (count>=candidates.size()) {
+        return samplePositions(candidates.size(), candidates.size());
+    }
+
+    QVector<int> positions;
+    QSet<int> picked;
+    QVector<int> remaining;
+    QVector<quint32> cumulative;
+    int repicks=count; // Forces initial calculation
+    positions.reserve(count);
+    while (positions.size()<count) {
+        if (repicks>=count) {
+            quint32 total=0;
+            remaining.clear();
+            cumulative.clear();
+            for (int i=0; i<candidates.size(); ++i) {
+                if (!picked.contains(i)) {
+                    total+=qMax(1, tracks.at(candidates.at(i)));
+                    remaining.append(i);
+                    cumulative.append(total);
+                }
+            }
+            repicks=0;
+        }
+        quint32 r=QRandomGenerator::global()->bounded(cumulative.last());
+        int pos=remaining.at(std::upper_bound(cumulative.constBegin(), cumulative.constEnd(), r)-cumulative.constBegin());
+        if (picked.contains(pos)) {
+            repicks++;
+        } else {
+            picked.insert(pos);
+            positions.append(pos);
+        }
+    }
+    return positions;
+}
+
+// Pick up to 'count' distinct albums from those matching any of the genres or artists. Albums are either
+// equally likely, or weighted by their number of tracks - so that each track is equally likely.
+QList<LibraryDb::Album> LibraryDb::getRandomAlbums(const QStringList &genres, const QStringList &artists, int count, bool weightByTracks)
+{
+    QList<Album> albums;
+    if (count<=0 || !updateSampleIndex()) {
+        return albums;
+    }
+
+    QVector<int> candidates;
+    if (genres.isEmpty() && artists.isEmpty()) {
+        candidates=sampleCandidates(QString(), QString());
+    } else if (1==genres.count()+artists.count()) {
+        candidates=genres.isEmpty() ? sampleCandidates(QString(), artists.first()) : sampleCandidates(genres.first(), QString());
+    } else {
+        for (const QString &genre: genres) {
+            candidates+=sampleCandidates(genre, QString());
+        }
+        for (const QString &artist: artists) {
+            candidates+=sampleCandidates(QString(), artist);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    QVector<int> positions=weightByTracks
+                            ? weightedPositions(candidates, sampleIndex->tracks, count)
+                            : samplePositions(candidates.size(), count);
+    for (int pos: positions) {
+        albums.append(sampleIndex->albums.at(candidates.at(pos)));
+    }
+    return albums;
+}
+
+// Fold an artist name for matching - e.g. "The Beatles", "beatles", and "Beätles" all
+// become "beatles", and "AC/DC" and "AC-DC" both become "acdc"
+QString LibraryDb::foldArtist(const QString &name)
+{
+    static const QLatin1String constThe("The ");
+    QString str=name.trimmed();
+    if (str.length()>constThe.size() && str.startsWith(constThe, Qt::CaseInsensitive)) {
+        str=str.mid(constThe.size());
+    }
+    str=str.normalized(QString::NormalizationForm_D);
+
+    QString folded;
+    folded.reserve(str.length());
+    for (const QChar &c: str) {
+        // Accents are now separate (Mark) characters, and so are skipped along with punctuation and spaces
+        if (c.isLetterOrNumber()) {
+            folded+=c.toCaseFolded();
+        }
+    }
+    return folded.isEmpty() ? name.toLower() : folded;
+}
+
+// Return the album artist in the library matching name, or an empty string if there is none.
+QString LibraryDb::resolveArtist(const QString &name)
+{
+    if (name.isEmpty()) {
+        return QString();
+    }
+    if (get("albumArtist").contains(name)) {
+        return name;
+    }
+    updateArtistIndex();
+    QHash<QString, QString>::ConstIterator it=artistIndex.constFind(foldArtist(name));
+    return it==artistIndex.constEnd() ? QString() : it.value();
+}
+
+void LibraryDb::updateArtistIndex()
+{
+    if (0==currentVersion || !db) {
+        artistIndex.clear();
+        artistIndexVersion=0;
+        return;
+    }
+    if (artistIndexVersion==currentVersion) {
+        return;
+    }
+
+    artistIndex.clear();
+    QStringList artists=get("albumArtist").values();
+    // Sort, so that clashes always resolve to the same name
+    std::sort(artists.begin(), artists.end());
+    for (const QString &artist: artists) {
+        QString key=foldArtist(artist);
+        if (!artistIndex.contains(key)) {
+            artistIndex.insert(key, artist);
+        }
+    }
+    artistIndexVersion=currentVersion;
+    DBUG << "artists" << artistIndex.count();
 }
 
 QSet<QString> LibraryDb::get(const QString &type)
@@ -1229,7 +1839,12 @@ void LibraryDb::updateStarted(time_t ver)
     newVersion=ver;
     timer.start();
     db->transaction();
+    prevFiles.clear();
+    changes=Changes();
+    // Can only determine what has changed if we have the previous contents
+    trackChanges=currentVersion>0;
     if (currentVersion>0) {
+        readFileStates();
         clearSongs(false);
     }
 }
@@ -1259,9 +1874,36 @@ void LibraryDb::updateFinished()
     QSqlQuery(*db).exec("update versions set collection ="+QString::number(newVersion));
     DBUG << "commit" << timer.elapsed();
     db->commit();
+    time_t prevVersion=currentVersion;
     currentVersion=newVersion;
-    DBUG << "complete" << timer.elapsed();
-    emit libraryUpdated();
+
+    // Anything not re-inserted has been removed
+    if (trackChanges) {
+        QHash<QString, FileState>::ConstIterator it=prevFiles.constBegin();
+        QHash<QString, FileState>::ConstIterator end=prevFiles.constEnd();
+        for (; it!=end; ++it) {
+            changes.removed.append(it.key());
+            addChangedKeys(it.value().artistId, it.value().albumId, it.value().genres);
+        }
+        changes.complete=true;
+    }
+    Changes c=changes;
+    if (c.complete && 0!=prevVersion && sampleIndex->version==prevVersion) {
+        updateSampleIndex(c);
+    } else {
+        sampleIndex->clear();
+    }
+    // Tag edits that leave artist, album, and genres unchanged cannot alter the artist names
+    if (c.complete && !c.isStructural() && 0!=prevVersion && artistIndexVersion==prevVersion) {
+        artistIndexVersion=currentVersion;
+    } else {
+        artistIndexVersion=0;
+    }
+    prevFiles.clear();
+    changes=Changes();
+    trackChanges=false;
+    DBUG << "complete" << timer.elapsed() << c.complete << c.added.count() << c.removed.count() << c.modified.count();
+    emit libraryChanged(c);
 }
 
 void LibraryDb::abortUpdate()
@@ -1269,6 +1911,9 @@ void LibraryDb::abortUpdate()
     if (db) {
         db->rollback();
     }
+    prevFiles.clear();
+    changes=Changes();
+    trackChanges=false;
 }
 
 bool LibraryDb::createTable(const QString &q)
@@ -1337,6 +1982,9 @@ void LibraryDb::reset()
 
     insertSongQuery=nullptr;
     db=nullptr;
+    sampleIndex->clear();
+    artistIndex.clear();
+    artistIndexVersion=0;
     if (removeDb) {
         QSqlDatabase::removeDatabase(dbName);
     }
@@ -27,12 +27,17 @@
 #include <QObject>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QVector>
 #include <QElapsedTimer>
 #include "mpd-interface/song.h"
 #include <time.h>
 
 class QSqlDatabase;
 class QSqlQuery;
+class LibraryDbReader;
 
 class LibraryDb : public QObject
 {
@@ -111,12 +116,79 @@ public:
         bool identifyById; // Should we jsut use albumId to locate tracks - Issue #1025
     };
 
+    enum ReadType {
+        Read_Genres,
+        Read_Artists,
+        Read_Albums,
+        // Children of a genre, artist, or album item
+        Read_GenreArtists,
+        Read_ArtistAlbums,
+        Read_AlbumTracks
+    };
+
+    // Listing, which may be read via LibraryDbReader. Results are tagged with the request's
+    // generation, so that callers can discard any that have been superseded.
+    struct ReadRequest
+    {
+        ReadRequest() : generation(0), type(Read_Artists), sort(AS_YrAlAr) { }
+        quint32 generation;
+        ReadType type;
+        AlbumSort sort;
+        // Parent item, for child listings
+        QString genre;
+        QString artistId;
+        QString albumId;
+        // Set by readAsync()
+        QString dbFile;
+        QString filter;
+        QString genreFilter;
+        QString yearFilter;
+    };
+
+    struct ReadResult
+    {
+        ReadResult(const ReadRequest &r=ReadRequest())
+            : generation(r.generation), type(r.type), genre(r.genre), artistId(r.artistId), albumId(r.albumId), ok(false) { }
+        quint32 generation;
+        ReadType type;
+        QString genre;
+        QString artistId;
+        QString albumId;
+        bool ok;
+        QList<Genre> genres;
+        QList<Artist> artists;
+        QList<Album> albums;
+        QList<Song> tracks;
+    };
+
+    // Difference between the previous and current contents, as found by an update. Emitted via
+    // libraryChanged(), so that views can update only the affected items.
+    struct Changes
+    {
+        Changes() : complete(false), keysChanged(false), detailsChanged(false) { }
+        bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && modified.isEmpty(); }
+        // Whether tracks have been added or removed, moved to another artist, album, or genre, or have
+        // changed details that are shown in (or used to sort) artist and album items
+        bool isStructural() const { return keysChanged || detailsChanged || !added.isEmpty() || !removed.isEmpty(); }
+        bool complete; // false if previous contents were not known, in which case everything must be reloaded
+        bool keysChanged;
+        bool detailsChanged; // Album name, year, or duration - or artist/album sort - changed
+        QStringList added;
+        QStringList removed;
+        QStringList modified;
+        QSet<QString> artists;
+        QSet<QPair<QString, QString> > albums; // artistId, albumId
+        QSet<QString> genres;
+    };
+
     LibraryDb(QObject *p, const QString &name);
     ~LibraryDb() override;
 
     void clear();
     void erase();
     virtual bool init(const QString &dbFile);
+    bool initReadOnly(const QString &dbFile);
+    bool refreshReadOnly();
     void insertSong(const Song &s);
     QList<Genre> getGenres();
     QList<Artist> getArtists(const QString &genre=QString());
@@ -128,16 +200,25 @@ public:
     QList<Album> getAlbumsWithArtistOrComposer(const QString &artist);
     Album getRandomAlbum(const QString &genre, const QString &artist);
     Album getRandomAlbum(const QStringList &genres, const QStringList &artists);
+    QList<Album> getRandomAlbums(const QStringList &genres, const QStringList &artists, int count, bool weightByTracks=false);
     QSet<QString> get(const QString &type);
+    static QString foldArtist(const QString &name);
+    QString resolveArtist(const QString &name);
     void getDetails(QSet<QString> &artists, QSet<QString> &albumArtists, QSet<QString> &composers, QSet<QString> &albums, QSet<QString> &genres);
     bool songExists(const Song &song);
     bool setFilter(const QString &f, const QString &genre=QString());
     const QString & getFilter() const { return filter; }
+    void setFilters(const QString &f, const QString &genre, const QString &year) { filter=f; genreFilter=genre; yearFilter=year; }
+    ReadResult read(const ReadRequest &req);
+    bool readAsync(ReadRequest &req);
     int getCurrentVersion() const { return currentVersion; }
+    const QString & getFileName() const { return dbFileName; }
 
 Q_SIGNALS:
     void libraryUpdated();
+    void libraryChanged(const LibraryDb::Changes &changes);
     void error(const QString &str);
+    void retrieved(const LibraryDb::ReadResult &result);
 
 public Q_SLOTS:
     void updateStarted(time_t ver);
@@ -147,12 +228,35 @@ public Q_SLOTS:
 
 protected:
     bool createTable(const QString &q);
+    void setPragmas(bool readOnly);
     static Song getSong(const QSqlQuery &query);
 
 protected:
     virtual void reset();
     void clearSongs(bool startTransaction=true);
 
+private:
+    struct FileState
+    {
+        FileState(time_t m=0, const QString &ar=QString(), const QString &al=QString(), const QString &g=QString(), const QString &d=QString())
+            : lastModified(m), artistId(ar), albumId(al), genres(g), details(d) { }
+        time_t lastModified;
+        QString artistId;
+        QString albumId;
+        QString genres;
+        QString details; // Values that affect artist and album items
+    };
+
+    void readFileStates();
+    void addChangedKeys(const QString &artistId, const QString &albumId, const QString &genres);
+    void recordChange(const Song &s, const FileState &state);
+
+    struct SampleIndex;
+    bool updateSampleIndex();
+    void updateSampleIndex(const Changes &changes);
+    QVector<int> sampleCandidates(const QString &genre, const QString &artist);
+    void updateArtistIndex();
+
 protected:
     static bool dbgEnabled;
 
@@ -167,6 +271,17 @@ protected:
     QString genreFilter;
     QString yearFilter;
     QMap<QString, QSet<QString> > detailsCache;
+    LibraryDbReader *dbReader;
+    SampleIndex *sampleIndex;
+    time_t artistIndexVersion;
+    QHash<QString, QString> artistIndex; // Folded name -> album artist
+    bool trackChanges;
+    QHash<QString, FileState> prevFiles; // Contents prior to update, less any files since re-inserted
+    Changes changes;
 };
 
+Q_DECLARE_METATYPE(LibraryDb::ReadRequest)
+Q_DECLARE_METATYPE(LibraryDb::ReadResult)
+Q_DECLARE_METATYPE(LibraryDb::Changes)
+
 #endif
@@ -0,0 +1,134 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2017-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "librarydbreader.h"
+#include "support/thread.h"
+#include <QReadLocker>
+#include <QDebug>
+
+#define DBUG if (LibraryDb::debugEnabled()) qWarning() << metaObject()->className() << __FUNCTION__
+
+LibraryDbReader::LibraryDbReader(const QString &name, int numWorkers)
+    : shared(new Shared)
+    , next(0)
+{
+    qRegisterMetaType<LibraryDb::ReadRequest>("LibraryDb::ReadRequest");
+    qRegisterMetaType<LibraryDb::ReadResult>("LibraryDb::ReadResult");
+    for (int i=0; i<numWorkers; ++i) {
+        LibraryDbReaderWorker *worker=new LibraryDbReaderWorker(shared, name+QLatin1String("-reader")+QString::number(i));
+        connect(worker, SIGNAL(retrieved(LibraryDb::ReadResult)), this, SIGNAL(retrieved(LibraryDb::ReadResult)), Qt::QueuedConnection);
+        workers.append(worker);
+    }
+}
+
+LibraryDbReader::~LibraryDbReader()
+{
+    for (LibraryDbReaderWorker *worker: workers) {
+        worker->stop();
+    }
+}
+
+void LibraryDbReader::closeConnections()
+{
+    DBUG;
+    for (LibraryDbReaderWorker *worker: workers) {
+        worker->closeConnection();
+    }
+}
+
+void LibraryDbReader::request(const LibraryDb::ReadRequest &req)
+{
+    DBUG << req.generation << req.type;
+    shared->latest.storeRelease((int)req.generation);
+    // Round-robin, so that a new request is not queued behind a slow (and now superseded) one
+    LibraryDbReaderWorker *worker=workers.at(next);
+    next=(next+1)%workers.count();
+    QMetaObject::invokeMethod(worker, "read", Qt::QueuedConnection, Q_ARG(LibraryDb::ReadRequest, req));
+}
+
+LibraryDbReaderWorker::LibraryDbReaderWorker(const QSharedPointer<LibraryDbReader::Shared> &s, const QString &name)
+    : shared(s)
+    , connectionName(name)
+    , db(nullptr)
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    // Emitted from the thread itself, just before it exits - so connection is closed in the thread that opened it
+    connect(thread, SIGNAL(finished()), this, SLOT(close()), Qt::DirectConnection);
+    thread->start();
+}
+
+void LibraryDbReaderWorker::stop()
+{
+    thread->stop();
+}
+
+void LibraryDbReaderWorker::closeConnection()
+{
+    if (thread->isRunning()) {
+        // read() only ever tries to lock the DB files, so this cannot deadlock with our caller's write lock
+        QMetaObject::invokeMethod(this, "close", Qt::BlockingQueuedConnection);
+    }
+}
+
+void LibraryDbReaderWorker::close()
+{
+    delete db;
+    db=nullptr;
+}
+
+void LibraryDbReaderWorker::read(const LibraryDb::ReadRequest &req)
+{
+    if ((int)req.generation!=shared->latest.loadAcquire()) {
+        DBUG << "skip" << req.generation;
+        return;
+    }
+
+    LibraryDb::ReadResult result(req);
+    // Files are being removed, so report failure - caller will then read directly
+    if (!shared->lock.tryLockForRead()) {
+        DBUG << "locked" << req.generation;
+        emit retrieved(result);
+        return;
+    }
+    if (db && db->getFileName()!=req.dbFile) {
+        close();
+    }
+    if (!db) {
+        db=new LibraryDb(nullptr, connectionName);
+        if (!db->initReadOnly(req.dbFile)) {
+            close();
+        }
+    } else {
+        db->refreshReadOnly();
+    }
+    if (db) {
+        db->setFilters(req.filter, req.genreFilter, req.yearFilter);
+        result=db->read(req);
+    }
+    shared->lock.unlock();
+    DBUG << req.generation << req.type << result.ok;
+    emit retrieved(result);
+}
+
+#include "moc_librarydbreader.cpp"
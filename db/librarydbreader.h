@@ -0,0 +1,96 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2017-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef LIBRARY_DB_READER_H
+#define LIBRARY_DB_READER_H
+
+#include "librarydb.h"
+#include <QObject>
+#include <QAtomicInt>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+
+class Thread;
+class LibraryDbReaderWorker;
+
+// Pool of worker threads used to read listings from a LibraryDb file, so that the GUI thread does not
+// block on SQLite - and (as the DB uses WAL) readers do not wait for an update to be committed. Each
+// worker keeps one read-only connection open between requests. Requests that have been superseded (by
+// one with a later generation) before a worker gets to them are skipped.
+class LibraryDbReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Shared
+    {
+        QAtomicInt latest;
+        // Held for read whilst a connection is open, and for write whilst the DB files are removed
+        QReadWriteLock lock;
+    };
+
+    LibraryDbReader(const QString &name, int numWorkers=2);
+    ~LibraryDbReader() override;
+
+    void request(const LibraryDb::ReadRequest &req);
+    QReadWriteLock * fileLock() { return &shared->lock; }
+    // Must be called with fileLock() held for write, prior to the DB files being removed
+    void closeConnections();
+
+Q_SIGNALS:
+    void retrieved(const LibraryDb::ReadResult &result);
+
+private:
+    QSharedPointer<Shared> shared;
+    QList<LibraryDbReaderWorker *> workers;
+    int next;
+};
+
+class LibraryDbReaderWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    LibraryDbReaderWorker(const QSharedPointer<LibraryDbReader::Shared> &s, const QString &name);
+    ~LibraryDbReaderWorker() override { }
+
+    void stop();
+    void closeConnection();
+
+Q_SIGNALS:
+    void retrieved(const LibraryDb::ReadResult &result);
+
+public Q_SLOTS:
+    void read(const LibraryDb::ReadRequest &req);
+
+private Q_SLOTS:
+    void close();
+
+private:
+    QSharedPointer<LibraryDbReader::Shared> shared;
+    QString connectionName;
+    Thread *thread;
+    LibraryDb *db; // Only accessed from worker thread
+};
+
+#endif
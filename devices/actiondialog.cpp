@@ -574,6 +574,11 @@ void ActionDialog::doNext()
                     destFile=dev->path()+dev->options().createFilename(currentSong);
                     currentSong.file=currentSong.filePath(MPDConnection::self()->getDetails().dir);
                     dev->addSong(currentSong, overwrite->isChecked(), !copiedCovers.contains(Utils::getDir(destFile)));
+                    if (!songsToAction.isEmpty()) {
+                        Song next=songsToAction.first();
+                        next.file=next.filePath(MPDConnection::self()->getDetails().dir);
+                        dev->prefetchSong(next);
+                    }
                 } else {
                     Song copy=currentSong;
                     if (dev->options().fixVariousArtists && currentSong.isVariousArtists()) {
@@ -22,6 +22,7 @@
  */
 
 #include "audiocddevice.h"
+#include "cdalbumcache.h"
 #ifdef CDDB_FOUND
 #include "cddbinterface.h"
 #endif
@@ -339,6 +340,13 @@ void AudioCdDevice::setDetails(const CdAlbum &a)
 {
     bool differentAlbum=album!=a.name || artist!=a.artist;
     lookupInProcess=false;
+    if (!a.cacheKey.isEmpty()) {
+        cacheKey=a.cacheKey;
+    }
+    if (!a.isDefault) {
+        // Remember selection, or edits, so that these are used next time disc is inserted.
+        CdAlbumCache::setSelection(cacheKey, a);
+    }
     setData(a.artist);
     album=a.name;
     artist=a.artist;
@@ -356,7 +364,11 @@ void AudioCdDevice::setDetails(const CdAlbum &a)
     setStatusMessage(QString());
     detailsString=tr("%n Tracks (%1)", "", a.tracks.count()).arg(Utils::formatTime(totalDuration));
     emit updating(id(), false);
-    if (differentAlbum && !a.isDefault) {
+    QString cachedCover=differentAlbum && !a.isDefault ? CdAlbumCache::coverFile(cacheKey) : QString();
+    QImage cachedImg=cachedCover.isEmpty() ? QImage() : QImage(cachedCover);
+    if (!cachedImg.isNull()) {
+        setCover(Covers::Image(cachedImg, cachedCover));
+    } else if (differentAlbum && !a.isDefault) {
         Song s;
         s.artist=s.albumartist=artist;
         s.album=album;
@@ -391,6 +403,7 @@ void AudioCdDevice::cdMatches(const QList<CdAlbum> &albums)
 void AudioCdDevice::setCover(const Covers::Image &img)
 {
     coverImage=img;
+    CdAlbumCache::storeCover(cacheKey, img.fileName);
     updateStatus();
 }
 
@@ -119,6 +119,7 @@ private:
     QString genre;
     QString device;
     QString devPath;
+    QString cacheKey;
     int year;
     int disc;
     quint32 time;
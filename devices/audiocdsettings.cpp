@@ -52,6 +52,7 @@ AudioCdSettings::AudioCdSettings(QWidget *p)
 void AudioCdSettings::load()
 {
     cdAuto->setChecked(Settings::self()->cdAuto());
+    cdCacheDays->setValue(Settings::self()->cdCacheDays());
     #if defined CDDB_FOUND
     cddbHost->setText(Settings::self()->cddbHost());
     cddbPort->setValue(Settings::self()->cddbPort());
@@ -72,6 +73,7 @@ void AudioCdSettings::load()
 void AudioCdSettings::save()
 {
     Settings::self()->saveCdAuto(cdAuto->isChecked());
+    Settings::self()->saveCdCacheDays(cdCacheDays->value());
     #if defined CDDB_FOUND
     Settings::self()->saveCddbHost(cddbHost->text().trimmed());
     Settings::self()->saveCddbPort(cddbPort->value());
@@ -39,6 +39,7 @@ struct CdAlbum {
     int year;
     int disc;
     QList<Song> tracks;
+    QString cacheKey;
 };
 
 #endif
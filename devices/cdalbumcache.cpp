@@ -0,0 +1,185 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "cdalbumcache.h"
+#include "gui/settings.h"
+#include "support/utils.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+
+static const QLatin1String constCacheDir("cdalbums/");
+static const QLatin1String constExtension(".cache");
+static const QLatin1String constCoverExtension(".jpg");
+static const quint32 constVersion=1;
+static QMutex mutex;
+
+static QDataStream & operator<<(QDataStream &stream, const CdAlbum &album)
+{
+    stream << album.name << album.artist << album.composer << album.genre << (qint32)album.year << (qint32)album.disc << album.tracks;
+    return stream;
+}
+
+static QDataStream & operator>>(QDataStream &stream, CdAlbum &album)
+{
+    qint32 year;
+    qint32 disc;
+    stream >> album.name >> album.artist >> album.composer >> album.genre >> year >> disc >> album.tracks;
+    album.year=year;
+    album.disc=disc;
+    return stream;
+}
+
+static QString cacheFile(const QString &key, const QString &ext, bool create)
+{
+    QString dir=Utils::cacheDir(constCacheDir, create);
+    return dir.isEmpty() ? QString() : (dir+key+ext);
+}
+
+static CdAlbumCache::Entry read(const QString &key)
+{
+    CdAlbumCache::Entry entry;
+    QFile f(cacheFile(key, constExtension, false));
+    if (!f.open(QIODevice::ReadOnly)) {
+        return entry;
+    }
+
+    QDataStream stream(&f);
+    quint32 version=0;
+    bool haveSelection=false;
+    stream >> version;
+    if (constVersion!=version) {
+        return entry;
+    }
+    stream >> entry.timestamp >> entry.albums >> haveSelection;
+    if (haveSelection) {
+        stream >> entry.selection;
+    }
+    if (QDataStream::Ok!=stream.status()) {
+        return CdAlbumCache::Entry();
+    }
+    for (CdAlbum &a: entry.albums) {
+        a.cacheKey=key;
+    }
+    entry.selection.cacheKey=key;
+    return entry;
+}
+
+static void write(const QString &key, const CdAlbumCache::Entry &entry)
+{
+    QString fileName=cacheFile(key, constExtension, true);
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&f);
+    stream << constVersion << entry.timestamp << entry.albums << !entry.selection.isNull();
+    if (!entry.selection.isNull()) {
+        stream << entry.selection;
+    }
+}
+
+bool CdAlbumCache::Entry::isExpired() const
+{
+    return QDateTime::currentMSecsSinceEpoch()/1000 > timestamp+(Settings::self()->cdCacheDays()*24*60*60);
+}
+
+QString CdAlbumCache::cddbKey(unsigned int discId)
+{
+    return QLatin1String("cddb-")+QString::number(discId, 16).rightJustified(8, QLatin1Char('0'));
+}
+
+QString CdAlbumCache::musicBrainzKey(const QString &discId)
+{
+    return discId.isEmpty() ? QString() : (QLatin1String("mb-")+discId);
+}
+
+CdAlbumCache::Entry CdAlbumCache::get(const QString &key)
+{
+    if (key.isEmpty()) {
+        return Entry();
+    }
+    QMutexLocker locker(&mutex);
+    return read(key);
+}
+
+void CdAlbumCache::store(const QString &key, const QList<CdAlbum> &albums)
+{
+    if (key.isEmpty() || albums.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    // Keep any previous selection, this is the user's choice - or their edits.
+    Entry entry=read(key);
+    entry.albums=albums;
+    entry.timestamp=QDateTime::currentMSecsSinceEpoch()/1000;
+    write(key, entry);
+}
+
+void CdAlbumCache::setSelection(const QString &key, const CdAlbum &album)
+{
+    if (key.isEmpty() || album.isNull()) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    Entry entry=read(key);
+    if (entry.isEmpty()) {
+        entry.albums.append(album);
+        entry.timestamp=QDateTime::currentMSecsSinceEpoch()/1000;
+    }
+    if (!entry.selection.isNull() && (entry.selection.name!=album.name || entry.selection.artist!=album.artist)) {
+        // Different album chosen, so previous cover no longer applies.
+        QFile::remove(cacheFile(key, constCoverExtension, false));
+    }
+    entry.selection=album;
+    write(key, entry);
+}
+
+QString CdAlbumCache::coverFile(const QString &key)
+{
+    if (key.isEmpty()) {
+        return QString();
+    }
+    QString fileName=cacheFile(key, constCoverExtension, false);
+    return QFile::exists(fileName) ? fileName : QString();
+}
+
+void CdAlbumCache::storeCover(const QString &key, const QString &file)
+{
+    if (key.isEmpty() || file.isEmpty()) {
+        return;
+    }
+    QString fileName=cacheFile(key, constCoverExtension, true);
+    if (fileName.isEmpty() || fileName==file) {
+        return;
+    }
+    QMutexLocker locker(&mutex);
+    QFile::remove(fileName);
+    QFile::copy(file, fileName);
+}
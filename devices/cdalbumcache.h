@@ -0,0 +1,54 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef CDALBUMCACHE_H
+#define CDALBUMCACHE_H
+
+#include "cdalbum.h"
+#include <QString>
+#include <QList>
+
+// Persistent cache of CDDB/MusicBrainz lookups, so that re-inserting a disc (or using Cantata
+// whilst offline) does not require another remote query.
+namespace CdAlbumCache
+{
+    struct Entry {
+        Entry() : timestamp(0) { }
+        bool isEmpty() const { return albums.isEmpty(); }
+        bool isExpired() const;
+        CdAlbum current() const { return selection.isNull() ? albums.first() : selection; }
+        QList<CdAlbum> albums;
+        CdAlbum selection;
+        qint64 timestamp;
+    };
+
+    extern QString cddbKey(unsigned int discId);
+    extern QString musicBrainzKey(const QString &discId);
+    extern Entry get(const QString &key);
+    extern void store(const QString &key, const QList<CdAlbum> &albums);
+    extern void setSelection(const QString &key, const CdAlbum &album);
+    extern QString coverFile(const QString &key);
+    extern void storeCover(const QString &key, const QString &file);
+}
+
+#endif
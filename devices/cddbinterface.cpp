@@ -22,6 +22,7 @@
  */
 
 #include "cddbinterface.h"
+#include "cdalbumcache.h"
 #include "gui/settings.h"
 #include "network/networkproxyfactory.h"
 #include "support/thread.h"
@@ -267,34 +268,81 @@ void CddbInterface::lookup(bool full)
         readDisc();
     }
 
-    if (!disc || !full) {
+    if (!disc) {
         // Errors already logged in readDisc
         return;
     }
 
-    CddbConnection cddb(disc);
-    if (!cddb) {
-        emit error(tr("Failed to create CDDB connection"));
-        return;
+    // If we have cached details, use these for the initial listing - and only
+    // contact the server (to refresh the cache) once these have expired.
+    QString key=CdAlbumCache::cddbKey(cddb_disc_get_discid(disc));
+    CdAlbumCache::Entry cached=CdAlbumCache::get(key);
+    bool refresh=isInitial && !cached.isEmpty();
+    if (refresh) {
+        emit initialDetails(cached.current());
+        if (!cached.isExpired()) {
+            return;
+        }
     }
 
-    if (!checkConnection()) {
-        emit error(tr("Failed to contact CDDB server, please check CDDB and network settings"));
+    if (!full) {
         return;
     }
 
-    if (cddb.query()<1) {
-        if (!isInitial) {
+    QString errorMsg;
+    QList<CdAlbum> m=query(errorMsg);
+
+    if (m.isEmpty()) {
+        if (refresh) {
+            return;
+        }
+        if (!isInitial && !cached.isEmpty()) {
+            // Server unavailable, or no longer matching, so use previous results
+            emit matches(cached.albums);
+        } else if (!errorMsg.isEmpty()) {
+            emit error(errorMsg);
+        } else if (!isInitial) {
             emit error(tr("No matches found in CDDB"));
         }
         return;
     }
 
+    for (CdAlbum &album: m) {
+        album.cacheKey=key;
+    }
+    CdAlbumCache::store(key, m);
+
+    if (refresh) {
+        return;
+    } else if (isInitial) {
+        emit initialDetails(m.first());
+    } else {
+        emit matches(m);
+    }
+}
+
+QList<CdAlbum> CddbInterface::query(QString &errorMsg)
+{
     QList<CdAlbum> m;
+    CddbConnection cddb(disc);
+    if (!cddb) {
+        errorMsg=tr("Failed to create CDDB connection");
+        return m;
+    }
+
+    if (!checkConnection()) {
+        errorMsg=tr("Failed to contact CDDB server, please check CDDB and network settings");
+        return m;
+    }
+
+    if (cddb.query()<1) {
+        return m;
+    }
+
     for (;;) {
         if (!cddb.read()) {
-            emit error(tr("CDDB error: %1", cddb.error()));
-            return;
+            errorMsg=tr("CDDB error: %1", cddb.error());
+            return QList<CdAlbum>();
         }
         int numTracks=cddb.trackCount();
         if (numTracks<=0) {
@@ -309,16 +357,7 @@ void CddbInterface::lookup(bool full)
             break;
         }
     }
-
-    if (m.isEmpty()) {
-        if (!isInitial) {
-            emit error(tr("No matches found in CDDB"));
-        }
-    } else if (isInitial) {
-        emit initialDetails(m.first());
-    } else {
-        emit matches(m);
-    }
+    return m;
 }
 
 bool CddbInterface::checkConnection()
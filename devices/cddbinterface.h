@@ -52,6 +52,7 @@ Q_SIGNALS:
 
 private:
     void readDisc();
+    QList<CdAlbum> query(QString &errorMsg);
     bool checkConnection();
 
 private:
@@ -121,6 +121,8 @@ public:
     virtual void configure(QWidget *) { }
     virtual QString path() const =0;
     virtual void addSong(const Song &s, bool overwrite, bool copyCover)=0;
+    // Hint that s is likely to be the next song passed to addSong()
+    virtual void prefetchSong(const Song &) { }
     virtual void copySongTo(const Song &s, const QString &musicPath, bool overwrite, bool copyCover)=0;
     virtual void removeSong(const Song &s)=0;
     virtual void cleanDirs(const QSet<QString> &dirs)=0;
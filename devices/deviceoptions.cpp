@@ -37,30 +37,60 @@ static QString cleanPath(const QString &path)
         * Those can be found in the Unicode tables listed at:
         * http://en.wikipedia.org/w/index.php?title=Combining_character&oldid=255990982
         * Removing those characters removes accents. :)                                   */
-    QString result = path;
-
-    // German umlauts
-    result.replace(QChar(0x00e4), "ae").replace(QChar(0x00c4), "Ae");
-    result.replace(QChar(0x00f6), "oe").replace(QChar(0x00d6), "Oe");
-    result.replace(QChar(0x00fc), "ue").replace(QChar(0x00dc), "Ue");
-    result.replace(QChar(0x00df), "ss");
+    static QHash<QChar, QString> special;
+
+    if (special.isEmpty()) {
+        // German umlauts
+        special.insert(QChar(0x00e4), QLatin1String("ae"));
+        special.insert(QChar(0x00c4), QLatin1String("Ae"));
+        special.insert(QChar(0x00f6), QLatin1String("oe"));
+        special.insert(QChar(0x00d6), QLatin1String("Oe"));
+        special.insert(QChar(0x00fc), QLatin1String("ue"));
+        special.insert(QChar(0x00dc), QLatin1String("Ue"));
+        special.insert(QChar(0x00df), QLatin1String("ss"));
+
+        // other special cases
+        special.insert(QChar(0x00C6), QLatin1String("AE"));
+        special.insert(QChar(0x00E6), QLatin1String("ae"));
+        special.insert(QChar(0x00D8), QLatin1String("OE"));
+        special.insert(QChar(0x00F8), QLatin1String("oe"));
+    }
 
-    // other special cases
-    result.replace(QChar(0x00C6), "AE");
-    result.replace(QChar(0x00E6), "ae");
+    bool ascii=true;
+    for (const QChar &c: path) {
+        if (c.unicode()>0x7f) {
+            ascii=false;
+            break;
+        }
+    }
+    if (ascii) {
+        return path;
+    }
 
-    result.replace(QChar(0x00D8), "OE");
-    result.replace(QChar(0x00F8), "oe");
+    QString result;
+    result.reserve(path.length()+8);
+    for (const QChar &c: path) {
+        QHash<QChar, QString>::ConstIterator it=special.constFind(c);
+        if (special.constEnd()==it) {
+            result+=c;
+        } else {
+            result+=it.value();
+        }
+    }
 
     // normalize in a form where accents are separate characters
     result = result.normalized(QString::NormalizationForm_D);
 
     // remove accents from table "Combining Diacritical Marks"
-    for (int i = 0x0300; i <= 0x036F; i++)  {
-        result.remove(QChar(i));
+    QString stripped;
+    stripped.reserve(result.length());
+    for (const QChar &c: result) {
+        if (c.unicode()<0x0300 || c.unicode()>0x036F) {
+            stripped+=c;
+        }
     }
 
-    return result;
+    return stripped;
 }
 
 static QString asciiPath(const QString &path)
@@ -200,6 +230,7 @@ DeviceOptions::DeviceOptions()
     , coverName(cvrName)
     , coverMaxSize(0)
     #endif
+    , compiledFlags(-1)
 {
 }
 
@@ -342,7 +373,11 @@ QString DeviceOptions::clean(const QString &str) const
 
     result=result.simplified();
     if (replaceSpaces) {
-        result.replace(QRegExp("\\s"), "_");
+        for (int i=0; i<result.length(); ++i) {
+            if (result.at(i).isSpace()) {
+                result[i]='_';
+            }
+        }
     }
     if (vfatSafe) {
         result = vfatPath(result);
@@ -371,12 +406,27 @@ Song DeviceOptions::clean(const Song &s) const
     return copy;
 }
 
-QString DeviceOptions::createFilename(const Song &s) const
+void DeviceOptions::compileScheme() const
 {
-    QString path=scheme;
+    int flags=(vfatSafe ? 0x01 : 0)|(asciiOnly ? 0x02 : 0)|(ignoreThe ? 0x04 : 0)|(replaceSpaces ? 0x08 : 0);
+    if (flags==compiledFlags && scheme==compiledScheme) {
+        return;
+    }
+
+    static QHash<QString, SchemeToken::Type> tokens;
     static QStringList ignore;
 
-    if (ignore.isEmpty()) {
+    if (tokens.isEmpty()) {
+        tokens.insert(constAlbumArtist, SchemeToken::AlbumArtist);
+        tokens.insert(constComposer, SchemeToken::Composer);
+        tokens.insert(constAlbumTitle, SchemeToken::AlbumTitle);
+        tokens.insert(constTrackArtist, SchemeToken::TrackArtist);
+        tokens.insert(constTrackTitle, SchemeToken::TrackTitle);
+        tokens.insert(constTrackArtistAndTitle, SchemeToken::TrackArtistAndTitle);
+        tokens.insert(constTrackNumber, SchemeToken::TrackNumber);
+        tokens.insert(constCdNumber, SchemeToken::CdNumber);
+        tokens.insert(constGenre, SchemeToken::Genre);
+        tokens.insert(constYear, SchemeToken::Year);
         ignore << QLatin1String("%comment%")
                << QLatin1String("%filetype%")
                << QLatin1String("%ignore%")
@@ -384,29 +434,148 @@ QString DeviceOptions::createFilename(const Song &s) const
                << QLatin1String("%initial%");
     }
 
+    compiledTokens.clear();
+    cleanedStrings.clear();
+    compiledFlags=flags;
+    compiledScheme=scheme;
+
+    QString path=scheme;
     for (const QString &i: ignore) {
         path.replace(i, QLatin1String(""));
     }
     if (replaceSpaces) {
-        path.replace(QRegExp("\\s"), "_");
+        for (int i=0; i<path.length(); ++i) {
+            if (path.at(i).isSpace()) {
+                path[i]='_';
+            }
+        }
     }
 
-    Song copy=clean(s);
+    // Split scheme into text and field tokens. Unknown %xxx% sequences are left as text, and the
+    // closing % is allowed to start the next field - to match how QString::replace would treat them.
+    QString text;
+    int pos=0;
+    while (pos<path.length()) {
+        int start=path.indexOf(QLatin1Char('%'), pos);
+        int end=-1==start ? -1 : path.indexOf(QLatin1Char('%'), start+1);
+        if (-1==end) {
+            text+=path.mid(pos);
+            break;
+        }
+        QHash<QString, SchemeToken::Type>::ConstIterator it=tokens.constFind(path.mid(start, end-start+1));
+        if (tokens.constEnd()==it) {
+            text+=path.mid(pos, end-pos);
+            pos=end;
+        } else {
+            text+=path.mid(pos, start-pos);
+            if (!text.isEmpty()) {
+                compiledTokens.append(SchemeToken(SchemeToken::Text, text));
+                text.clear();
+            }
+            compiledTokens.append(SchemeToken(it.value()));
+            pos=end+1;
+        }
+    }
+    if (!text.isEmpty()) {
+        compiledTokens.append(SchemeToken(SchemeToken::Text, text));
+    }
+}
 
-    path.replace(constAlbumArtist, copy.albumArtist());
-    path.replace(constComposer, copy.composer());
-    path.replace(constAlbumTitle, copy.album);
-    path.replace(constTrackArtist, copy.artist);
-    path.replace(constTrackTitle, copy.title);
-    path.replace(constTrackArtistAndTitle, clean(copy.displayTitle()));
-    QString track(QString::number(copy.track));
-    if (copy.track<10) {
-        track=QChar('0')+track;
+QString DeviceOptions::cleanCached(const QString &str) const
+{
+    static const int constMaxCached=4096;
+
+    if (str.isEmpty()) {
+        return str;
+    }
+    QHash<QString, QString>::ConstIterator it=cleanedStrings.constFind(str);
+    if (cleanedStrings.constEnd()!=it) {
+        return it.value();
+    }
+    if (cleanedStrings.count()>=constMaxCached) {
+        cleanedStrings.clear();
+    }
+    QString cleaned=clean(str);
+    cleanedStrings.insert(str, cleaned);
+    return cleaned;
+}
+
+QString DeviceOptions::cleanArtist(const QString &str) const
+{
+    if (ignoreThe) {
+        QString copy=str;
+        manipulateThe(copy, true);
+        return cleanCached(copy);
+    }
+    return cleanCached(str);
+}
+
+QString DeviceOptions::createFilename(const Song &s) const
+{
+    compileScheme();
+
+    // Fields are cleaned as they would be via clean(Song) - but only those used by the scheme.
+    QString path;
+    QString artist;
+    QString albumArtist;
+    bool haveArtist=false;
+    bool haveAlbumArtist=false;
+
+    for (const SchemeToken &t: compiledTokens) {
+        if (!haveArtist && (SchemeToken::AlbumArtist==t.type || SchemeToken::TrackArtist==t.type || SchemeToken::TrackArtistAndTitle==t.type)) {
+            artist=cleanArtist(s.artist);
+            haveArtist=true;
+        }
+        if (!haveAlbumArtist && (SchemeToken::AlbumArtist==t.type || SchemeToken::TrackArtistAndTitle==t.type)) {
+            albumArtist=cleanArtist(s.albumartist);
+            haveAlbumArtist=true;
+        }
+
+        switch (t.type) {
+        case SchemeToken::Text:
+            path+=t.text;
+            break;
+        case SchemeToken::AlbumArtist:
+            path+=albumArtist.isEmpty() ? artist : albumArtist;
+            break;
+        case SchemeToken::Composer:
+            path+=s.composer();
+            break;
+        case SchemeToken::AlbumTitle:
+            path+=cleanCached(s.album);
+            break;
+        case SchemeToken::TrackArtist:
+            path+=artist;
+            break;
+        case SchemeToken::TrackTitle:
+            path+=cleanCached(s.title);
+            break;
+        case SchemeToken::TrackArtistAndTitle: {
+            QString title=cleanCached(s.title);
+            path+=clean(!albumArtist.isEmpty() && albumArtist!=artist ? title+Song::constSep+artist : title);
+            break;
+        }
+        case SchemeToken::TrackNumber:
+            if (s.track<10) {
+                path+=QChar('0');
+            }
+            path+=QString::number(s.track);
+            break;
+        case SchemeToken::CdNumber:
+            if (s.disc>=1) {
+                path+=QString::number(s.disc);
+            }
+            break;
+        case SchemeToken::Genre:
+            path+=s.genres[0].isEmpty() ? Song::unknown() : s.genres[0];
+            break;
+        case SchemeToken::Year:
+            if (s.year>=1) {
+                path+=QString::number(s.year);
+            }
+            break;
+        }
     }
-    path.replace(constTrackNumber, track);
-    path.replace(constCdNumber, copy.disc<1 ? QLatin1String("") : QString::number(copy.disc));
-    path.replace(constGenre, copy.genres[0].isEmpty() ? Song::unknown() : copy.genres[0]);
-    path.replace(constYear, copy.year<1 ? QLatin1String("") : QString::number(copy.year));
 
     // For songs about to be downloaded from streams, we hide the filetype in genre...
     if (s.file.startsWith("http:/")) {
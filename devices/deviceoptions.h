@@ -25,6 +25,8 @@
 #define DEVICE_OPTIONS_H
 
 #include <QString>
+#include <QList>
+#include <QHash>
 #include "config.h"
 #ifdef ENABLE_DEVICES_SUPPORT
 #include "encoders.h"
@@ -112,6 +114,37 @@ struct DeviceOptions {
     unsigned int coverMaxSize;
     QString volumeId;
     #endif
+
+private:
+    struct SchemeToken {
+        enum Type {
+            Text,
+            AlbumArtist,
+            Composer,
+            AlbumTitle,
+            TrackArtist,
+            TrackTitle,
+            TrackArtistAndTitle,
+            TrackNumber,
+            CdNumber,
+            Genre,
+            Year
+        };
+        SchemeToken(Type t=Text, const QString &s=QString()) : type(t), text(s) { }
+        Type type;
+        QString text;
+    };
+
+    void compileScheme() const;
+    QString cleanCached(const QString &str) const;
+    QString cleanArtist(const QString &str) const;
+
+    // Compiled version of 'scheme', and cache of cleaned strings. These are regenerated
+    // whenever the scheme, or any of the cleaning options, change.
+    mutable QList<SchemeToken> compiledTokens;
+    mutable QString compiledScheme;
+    mutable int compiledFlags;
+    mutable QHash<QString, QString> cleanedStrings;
 };
 
 #endif
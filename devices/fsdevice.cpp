@@ -59,10 +59,16 @@ const QLatin1String FsDevice::constUseCacheKey("use_cache"); // Cantata extensio
 const QLatin1String FsDevice::constDefCoverFileName("cover.jpg");
 const QLatin1String FsDevice::constAutoScanKey("auto_scan"); // Cantata extension!
 
-MusicScanner::MusicScanner(const QString &id)
+MusicScanner::MusicScanner(const QString &id, int readAhead, int workers)
     : QObject(nullptr)
     , stopRequested(false)
     , count(0)
+    , readAhead(qMax(1, readAhead))
+    , workers(qMax(1, workers))
+    , toRead(0)
+    , library(nullptr)
+    , artistItem(nullptr)
+    , albumItem(nullptr)
 {
     thread=new Thread(metaObject()->className()+QLatin1String("::")+id);
     moveToThread(thread);
@@ -95,11 +101,16 @@ void MusicScanner::scan(const QString &folder, const QString &cacheFile, bool re
         return;
     }
     count=0;
-    MusicLibraryItemRoot *library = new MusicLibraryItemRoot;
+    library = new MusicLibraryItemRoot;
+    artistItem = nullptr;
+    albumItem = nullptr;
     QString topLevel=Utils::fixPath(QDir(folder).absolutePath());
     QSet<FileOnlySong> existing=existingSongs;
     timer.start();
-    scanFolder(library, topLevel, topLevel, existing, 0);
+    scanFolder(topLevel, topLevel, existing, 0);
+    readPending();
+    artistItem = nullptr;
+    albumItem = nullptr;
 
     if (!stopRequested) {
         if (!cacheFile.isEmpty()) {
@@ -110,6 +121,7 @@ void MusicScanner::scan(const QString &folder, const QString &cacheFile, bool re
     } else {
         delete library;
     }
+    library = nullptr;
 }
 
 void MusicScanner::saveCache(const QString &cache, MusicLibraryItemRoot *lib)
@@ -126,8 +138,7 @@ void MusicScanner::stop()
     thread=nullptr;
 }
 
-void MusicScanner::scanFolder(MusicLibraryItemRoot *library, const QString &topLevel, const QString &f,
-                              QSet<FileOnlySong> &existing, int level)
+void MusicScanner::scanFolder(const QString &topLevel, const QString &f, QSet<FileOnlySong> &existing, int level)
 {
     if (stopRequested) {
         return;
@@ -135,53 +146,96 @@ void MusicScanner::scanFolder(MusicLibraryItemRoot *library, const QString &topL
     if (level<4) {
         QDir d(f);
         QFileInfoList entries=d.entryInfoList(QDir::Files|QDir::NoSymLinks|QDir::Dirs|QDir::NoDotAndDotDot);
-        MusicLibraryItemArtist *artistItem = nullptr;
-        MusicLibraryItemAlbum *albumItem = nullptr;
         for (const QFileInfo &info: entries) {
             if (stopRequested) {
                 return;
             }
             if (info.isDir()) {
-                scanFolder(library, topLevel, info.absoluteFilePath(), existing, level+1);
+                scanFolder(topLevel, info.absoluteFilePath(), existing, level+1);
             } else if(info.isReadable()) {
-                Song song;
+                PendingFile file;
                 QString fname=info.absoluteFilePath().mid(topLevel.length());
 
                 if (fname.endsWith(".jpg", Qt::CaseInsensitive) || fname.endsWith(".png", Qt::CaseInsensitive) ||
                     fname.endsWith(".lyrics", Qt::CaseInsensitive) || fname.endsWith(".pamp", Qt::CaseInsensitive)) {
                     continue;
                 }
-                song.file=fname;
-                QSet<FileOnlySong>::iterator it=existing.find(song);
+                file.song.file=fname;
+                file.size=info.size();
+                QSet<FileOnlySong>::iterator it=existing.find(file.song);
                 if (existing.end()==it) {
-                    song=Tags::read(info.absoluteFilePath());
-                    song.file=fname;
+                    file.path=info.absoluteFilePath();
+                    toRead++;
                 } else {
-                    song=*it;
+                    file.song=*it;
                     existing.erase(it);
                 }
-                if (song.isEmpty()) {
-                    continue;
-                }
-                count++;
-                if (timer.elapsed()>=1500 || 0==(count%5)) {
-                    timer.restart();
-                    emit songCount(count);
+                pending.append(file);
+                if (toRead>=readAhead) {
+                    readPending();
                 }
+            }
+        }
+    }
+}
 
-                song.fillEmptyFields();
-                song.populateSorts();
-                song.size=info.size();
-                if (!artistItem || song.albumArtistOrComposer()!=artistItem->data()) {
-                    artistItem = library->artist(song);
-                }
-                if (!albumItem || albumItem->parentItem()!=artistItem || song.albumName()!=albumItem->data()) {
-                    albumItem = artistItem->album(song);
-                }
-                albumItem->append(new MusicLibraryItemSong(song, albumItem));
+// Read tags of all queued files in one request to the tag helper, and then add
+// the queued songs to the library - in the order they were found.
+void MusicScanner::readPending()
+{
+    if (stopRequested) {
+        pending.clear();
+        toRead=0;
+        return;
+    }
+    if (toRead>0) {
+        QStringList files;
+        for (const PendingFile &file: pending) {
+            if (!file.path.isEmpty()) {
+                files.append(file.path);
             }
         }
+        QList<Song> songs=Tags::read(files, workers);
+        // If the helper failed part way through the batch (e.g. crashed on a file) then the results
+        // cannot be matched to files, so read each file separately - only losing any that fail.
+        bool perFile=songs.count()!=files.count();
+        int s=0;
+        for (PendingFile &file: pending) {
+            if (!file.path.isEmpty()) {
+                QString fname=file.song.file;
+                file.song=perFile ? Tags::read(file.path) : songs.at(s++);
+                file.song.file=fname;
+            }
+        }
+    }
+
+    for (PendingFile &file: pending) {
+        if (!file.song.isEmpty()) {
+            addSong(file.song, file.size);
+        }
+    }
+    pending.clear();
+    toRead=0;
+}
+
+void MusicScanner::addSong(Song &song, qint64 size)
+{
+    count++;
+    if (timer.elapsed()>=1500 || 0==(count%5)) {
+        timer.restart();
+        emit songCount(count);
+    }
+
+    song.fillEmptyFields();
+    song.populateSorts();
+    song.size=size;
+    if (!artistItem || song.albumArtistOrComposer()!=artistItem->data()) {
+        artistItem = library->artist(song);
+    }
+    if (!albumItem || albumItem->parentItem()!=artistItem || song.albumName()!=albumItem->data()) {
+        albumItem = artistItem->album(song);
     }
+    albumItem->append(new MusicLibraryItemSong(song, albumItem));
 }
 
 void MusicScanner::readProgress(double pc)
@@ -651,7 +705,7 @@ void FsDevice::initScaner()
              qRegisterMetaType<QSet<FileOnlySong> >("QSet<FileOnlySong>");
              registeredTypes=true;
         }
-        scanner=new MusicScanner(data());
+        scanner=new MusicScanner(data(), scanReadAhead(), scanWorkers());
         connect(scanner, SIGNAL(libraryUpdated(MusicLibraryItemRoot *)), this, SLOT(libraryUpdated(MusicLibraryItemRoot *)));
         connect(scanner, SIGNAL(songCount(int)), this, SLOT(songCount(int)));
         connect(scanner, SIGNAL(cacheSaved()), this, SLOT(savedCache()));
@@ -34,6 +34,8 @@
 #include <QElapsedTimer>
 
 class Thread;
+class MusicLibraryItemArtist;
+class MusicLibraryItemAlbum;
 
 struct FileOnlySong : public Song
 {
@@ -52,7 +54,7 @@ class MusicScanner : public QObject, public MusicLibraryProgressMonitor
     Q_OBJECT
 
 public:
-    MusicScanner(const QString &id);
+    MusicScanner(const QString &id, int readAhead, int workers);
     ~MusicScanner() override;
 
     void stop();
@@ -72,13 +74,29 @@ Q_SIGNALS:
     void savingCache(int pc);
 
 private:
-    void scanFolder(MusicLibraryItemRoot *library, const QString &topLevel, const QString &f, QSet<FileOnlySong> &existing, int level);
+    struct PendingFile
+    {
+        QString path; // Empty if song was already known
+        Song song;
+        qint64 size;
+    };
+
+    void scanFolder(const QString &topLevel, const QString &f, QSet<FileOnlySong> &existing, int level);
+    void readPending();
+    void addSong(Song &song, qint64 size);
 
 private:
     Thread *thread;
     bool stopRequested;
     int count;
+    int readAhead;
+    int workers;
     QElapsedTimer timer;
+    QList<PendingFile> pending;
+    int toRead;
+    MusicLibraryItemRoot *library;
+    MusicLibraryItemArtist *artistItem;
+    MusicLibraryItemAlbum *albumItem;
 };
 
 class FsDevice : public Device
@@ -137,6 +155,10 @@ Q_SIGNALS:
     void saveCache(const QString &cacheFile, MusicLibraryItemRoot *lib);
 
 protected:
+    // Number of files to queue before reading their tags, and number of threads the
+    // tag helper may use to read them.
+    virtual int scanReadAhead() const { return 64; }
+    virtual int scanWorkers() const { return 2; }
     void initScaner();
     void startScanner(bool fullScan=true);
     void stopScanner();
@@ -1188,7 +1188,6 @@ MtpDevice::MtpDevice(MusicLibraryModel *m, Solid::Device &dev, unsigned int busN
              #endif
              )
     , pmp(dev.as<Solid::PortableMediaPlayer>())
-    , tempFile(0)
     , mtpUpdating(false)
 {
     static bool registeredTypes=false;
@@ -1306,6 +1305,13 @@ void MtpDevice::rescan(bool full)
     emit updateLibrary(opts);
 }
 
+static bool needsTranscode(const DeviceOptions &opts, const Encoders::Encoder &encoder, const Song &s)
+{
+    return !opts.transcoderCodec.isEmpty() &&
+           (DeviceOptions::TW_IfDifferent!=opts.transcoderWhen || encoder.isDifferent(s.file)) &&
+           (DeviceOptions::TW_IfLossess!=opts.transcoderWhen || Device::isLossless(s.file));
+}
+
 void MtpDevice::addSong(const Song &s, bool overwrite, bool copyCover)
 {
     requestAbort(false);
@@ -1323,12 +1329,14 @@ void MtpDevice::addSong(const Song &s, bool overwrite, bool copyCover)
             Device::fixVariousArtists(QString(), check, true);
         }
         if (songExists(check)) {
+            discardPrefetch(prefetched.take(s.file));
             emit actionStatus(SongExists);
             return;
         }
     }
 
     if (!QFile::exists(s.file)) {
+        discardPrefetch(prefetched.take(s.file));
         emit actionStatus(SourceFileDoesNotExist);
         return;
     }
@@ -1344,26 +1352,38 @@ void MtpDevice::addSong(const Song &s, bool overwrite, bool copyCover)
         }
     }
 
-    transcoding = !opts.transcoderCodec.isEmpty() &&
-            (DeviceOptions::TW_IfDifferent!=opts.transcoderWhen || encoder.isDifferent(s.file)) &&
-            (DeviceOptions::TW_IfLossess!=opts.transcoderWhen || Device::isLossless(s.file));
+    transcoding = needsTranscode(opts, encoder, s);
 
     if (transcoding) {
         deleteTemp();
-        tempFile=new QTemporaryFile("cantata_XXXXXX."+encoder.extension);
-        tempFile->setAutoRemove(false);
+        QMap<QString, Prefetch>::Iterator it=prefetched.find(s.file);
+        if (it!=prefetched.end()) {
+            Prefetch p=it.value();
+            prefetched.erase(it);
+            DBUG << "Using prefetched" << s.file << p.file << (void *)p.job << p.status;
+            tempFile=p.file;
+            currentSong.setExtraField(constOrigFileName, currentSong.file);
+            currentSong.file=tempFile;
+            if (p.job) {
+                // Still transcoding, so adopt job - transcodeSongResult() will then send the song
+                p.job->setProperty("prefetch", false);
+                p.job->setProperty("overwrite", overwrite);
+                p.job->setProperty("copyCover", copyCover);
+            } else if (Ok==p.status) {
+                emit putSong(currentSong, needToFixVa, opts, overwrite, copyCover);
+            } else {
+                deleteTemp();
+                emit actionStatus(p.status);
+            }
+            return;
+        }
 
-        if (!tempFile->open()) {
-            deleteTemp();
+        QString destFile=createTempFile(encoder.extension);
+        if (destFile.isEmpty()) {
             emit actionStatus(FailedToCreateTempFile);
             return;
         }
-        QString destFile=tempFile->fileName();
-        tempFile->close();
-        if (QFile::exists(destFile)) {
-            QFile::remove(destFile);
-        }
-        transcoding=true;
+        tempFile=destFile;
         TranscodingJob *job=new TranscodingJob(encoder, opts.transcoderValue, s.file, destFile);
         job->setProperty("overwrite", overwrite);
         job->setProperty("copyCover", copyCover);
@@ -1377,6 +1397,43 @@ void MtpDevice::addSong(const Song &s, bool overwrite, bool copyCover)
     }
 }
 
+/*
+ * Sending to an MTP device, and transcoding, are both slow. So, whilst one song is being sent
+ * transcode the next - the USB link and CPU are then both kept busy. At most constMaxPrefetch
+ * songs are transcoded ahead, to limit the number of temporary files.
+ */
+static const int constMaxPrefetch=2;
+
+void MtpDevice::prefetchSong(const Song &s)
+{
+    if (jobAbortRequested || opts.transcoderCodec.isEmpty() || prefetched.count()>=constMaxPrefetch ||
+        prefetched.contains(s.file) || s.file==currentSong.extraField(constOrigFileName) || !QFile::exists(s.file)) {
+        return;
+    }
+    Encoders::Encoder encoder=Encoders::getEncoder(opts.transcoderCodec);
+    if (encoder.codec.isEmpty() || !needsTranscode(opts, encoder, s)) {
+        return;
+    }
+    QString destFile=createTempFile(encoder.extension);
+    if (destFile.isEmpty()) {
+        return;
+    }
+    DBUG << s.file << destFile;
+    TranscodingJob *job=new TranscodingJob(encoder, opts.transcoderValue, s.file, destFile);
+    job->setProperty("prefetch", true);
+    job->setProperty("destFile", destFile);
+    connect(job, SIGNAL(result(int)), SLOT(transcodeSongResult(int)));
+    connect(job, SIGNAL(percent(int)), SLOT(transcodePercent(int)));
+    prefetched.insert(s.file, Prefetch(job, destFile));
+    job->start();
+}
+
+void MtpDevice::abortJob()
+{
+    requestAbort(true);
+    clearPrefetched();
+}
+
 void MtpDevice::copySongTo(const Song &s, const QString &musicPath, bool overwrite, bool copyCover)
 {
     requestAbort(false);
@@ -1485,6 +1542,24 @@ void MtpDevice::transcodeSongResult(int status)
         return;
     }
     FileJob::finished(job);
+    if (job->property("prefetch").toBool()) {
+        QMap<QString, Prefetch>::Iterator it=prefetched.begin();
+        QMap<QString, Prefetch>::Iterator end=prefetched.end();
+        for (; it!=end; ++it) {
+            if (it.value().job==job) {
+                DBUG << "Prefetched" << it.key() << status;
+                it.value().job=nullptr;
+                it.value().status=status;
+                if (Ok!=status) {
+                    QFile::remove(it.value().file);
+                }
+                return;
+            }
+        }
+        // No longer wanted...
+        QFile::remove(job->property("destFile").toString());
+        return;
+    }
     if (jobAbortRequested) {
         deleteTemp();
         return;
@@ -1498,6 +1573,9 @@ void MtpDevice::transcodeSongResult(int status)
 
 void MtpDevice::transcodePercent(int percent)
 {
+    if (sender() && sender()->property("prefetch").toBool()) {
+        return;
+    }
     if (jobAbortRequested) {
         FileJob *job=qobject_cast<FileJob *>(sender());
         if (job) {
@@ -1632,12 +1710,44 @@ void MtpDevice::saveOptions()
     }
 }
 
+QString MtpDevice::createTempFile(const QString &extension) const
+{
+    QTemporaryFile temp("cantata_XXXXXX."+extension);
+    temp.setAutoRemove(false);
+    if (!temp.open()) {
+        return QString();
+    }
+    QString fileName=temp.fileName();
+    temp.close();
+    if (QFile::exists(fileName)) {
+        QFile::remove(fileName);
+    }
+    return fileName;
+}
+
+void MtpDevice::discardPrefetch(const Prefetch &p)
+{
+    if (p.job) {
+        // Job will be deleted, and its file removed, when it reports its result
+        p.job->stop();
+    } else if (!p.file.isEmpty()) {
+        QFile::remove(p.file);
+    }
+}
+
+void MtpDevice::clearPrefetched()
+{
+    for (const Prefetch &p: prefetched) {
+        discardPrefetch(p);
+    }
+    prefetched.clear();
+}
+
 void MtpDevice::deleteTemp()
 {
-    if (tempFile) {
-        tempFile->remove();
-        delete tempFile;
-        tempFile=0;
+    if (!tempFile.isEmpty()) {
+        QFile::remove(tempFile);
+        tempFile=QString();
     }
 }
 
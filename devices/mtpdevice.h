@@ -32,7 +32,7 @@
 
 class MusicLibraryItemRoot;
 class Thread;
-class QTemporaryFile;
+class TranscodingJob;
 
 class MtpConnection : public QObject
 {
@@ -165,7 +165,8 @@ public:
     qint64 freeSpace();
     DevType devType() const { return Mtp; }
     void saveOptions();
-    void abortJob() { requestAbort(true); }
+    void abortJob();
+    void prefetchSong(const Song &s);
 
 Q_SIGNALS:
     // These are for talking to connection thread...
@@ -192,13 +193,26 @@ private Q_SLOTS:
     void saveProperties();
 
 private:
+    // A song that is being, or has been, transcoded ahead of being added
+    struct Prefetch
+    {
+        Prefetch(TranscodingJob *j=nullptr, const QString &f=QString()) : job(j), file(f), status(Ok) { }
+        TranscodingJob *job; // Set whilst still transcoding
+        QString file;
+        int status;
+    };
+
+    QString createTempFile(const QString &extension) const;
+    void discardPrefetch(const Prefetch &p);
+    void clearPrefetched();
     void deleteTemp();
     void requestAbort(bool r) { if (connection) connection->requestAbort(r); jobAbortRequested=r; }
 
 private:
     Solid::PortableMediaPlayer *pmp;
     MtpConnection *connection;
-    QTemporaryFile *tempFile;
+    QString tempFile;
+    QMap<QString, Prefetch> prefetched; // Source file -> prefetch details
     Song currentSong;
     bool mtpUpdating;
     QString serial;
@@ -24,6 +24,7 @@
 */
 
 #include "musicbrainz.h"
+#include "cdalbumcache.h"
 #include "network/networkproxyfactory.h"
 #include <QNetworkProxy>
 #include <QCryptographicHash>
@@ -241,9 +242,53 @@ void MusicBrainz::lookup(bool full)
         readDisc();
     }
 
+    // If we have cached details, use these for the initial listing - and only
+    // contact the server (to refresh the cache) once these have expired.
+    QString key=CdAlbumCache::musicBrainzKey(discId);
+    CdAlbumCache::Entry cached=CdAlbumCache::get(key);
+    bool refresh=isInitial && !cached.isEmpty();
+    if (refresh) {
+        emit initialDetails(cached.current());
+        if (!cached.isExpired()) {
+            return;
+        }
+    }
+
     if (!full) {
         return;
     }
+
+    QList<CdAlbum> m=query();
+
+    if (m.isEmpty()) {
+        if (refresh) {
+            return;
+        }
+        if (!isInitial && !cached.isEmpty()) {
+            // Server unavailable, or no longer matching, so use previous results
+            emit matches(cached.albums);
+        } else if (!isInitial) {
+            emit error(tr("No matches found in MusicBrainz"));
+        }
+        return;
+    }
+
+    for (CdAlbum &album: m) {
+        album.cacheKey=key;
+    }
+    CdAlbumCache::store(key, m);
+
+    if (refresh) {
+        return;
+    } else if (isInitial) {
+        emit initialDetails(m.first());
+    } else {
+        emit matches(m);
+    }
+}
+
+QList<CdAlbum> MusicBrainz::query()
+{
     DBUG << "Should lookup " << discId;
 
     MusicBrainz5::CQuery Query("cantata-" PACKAGE_VERSION_STRING);
@@ -376,15 +421,7 @@ void MusicBrainz::lookup(bool full)
         DBUG << "MusicBrainz error - %1" << e.what();
     }
 
-    if (m.isEmpty()) {
-        if (!isInitial) {
-            emit error(tr("No matches found in MusicBrainz"));
-        }
-    } else if (isInitial) {
-        emit initialDetails(m.first());
-    } else {
-        emit matches(m);
-    }
+    return m;
 }
 
 #include "moc_musicbrainz.cpp"
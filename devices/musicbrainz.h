@@ -49,6 +49,7 @@ Q_SIGNALS:
 
 private:
     void readDisc();
+    QList<CdAlbum> query();
 
 private:
     Thread *thread;
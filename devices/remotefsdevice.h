@@ -99,6 +99,10 @@ protected:
     void load();
     void setup();
     void setAudioFolder() const override;
+    // Remote reads are latency bound, so keep more requests in flight - but in smaller
+    // batches, so that progress is still reported regularly.
+    int scanReadAhead() const override { return details.isLocalFile() ? FsDevice::scanReadAhead() : 16; }
+    int scanWorkers() const override { return details.isLocalFile() ? FsDevice::scanWorkers() : 4; }
 
 private:
     bool isOldSshfs();
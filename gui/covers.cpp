@@ -25,6 +25,7 @@
 #include "mpd-interface/song.h"
 #include "support/utils.h"
 #include "mpd-interface/mpdconnection.h"
+#include "mpd-interface/mpdstats.h"
 #include "network/networkaccessmanager.h"
 #include "settings.h"
 #include "config.h"
@@ -42,6 +43,9 @@
 #include "support/globalstatic.h"
 #include "widgets/icons.h"
 #include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QUrl>
 #include <QUrlQuery>
@@ -49,7 +53,11 @@
 #include <qglobal.h>
 #include <QIcon>
 #include <QImage>
-#include <QImage>
+#include <QImageReader>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#include <QBuffer>
 #include <QPainter>
 #include <QFont>
 #include <QXmlStreamReader>
@@ -94,6 +102,10 @@ static const char * constExtensions[]={".jpg", ".png", nullptr};
 static bool saveInMpdDir=true;
 static bool fetchCovers=true;
 static QString constNoCover=QLatin1String("{nocover}");
+static const QLatin1String constNoCoverFile("nocover.dat");
+static const quint32 constNoCoverFileVersion=2;
+// How long to trust that an album has no cover
+static const time_t constNoCoverTtl=7*24*60*60;
 
 static double devicePixelRatio=1.0;
 // Only scale images to device pixel ratio if un-scaled size is less then 300pixels.
@@ -200,6 +212,29 @@ static QImage loadImage(const QString &fileName)
     return img;
 }
 
+// Decode downloaded image data. Large JPEGs are decoded directly at (roughly) constMaxSize, as
+// libjpeg can do this without first decoding the full image.
+static QImage decodeImage(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return QImage();
+    }
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, Covers::imageFormat(data));
+    QSize sz=reader.size();
+    if (sz.isValid()) {
+        if (sz.width()<32) {
+            return QImage();
+        }
+        if (sz.width()>Covers::constMaxSize.width() || sz.height()>Covers::constMaxSize.height()) {
+            reader.setScaledSize(sz.scaled(Covers::constMaxSize, Qt::KeepAspectRatio));
+        }
+    }
+    return reader.read();
+}
+
 static inline bool isOnlineServiceImage(const Song &s)
 {
     return OnlineService::showLogoAsCover(s);
@@ -352,6 +387,23 @@ static QImage loadScaledCover(const Song &song, int size)
     return QImage();
 }
 
+static const int constThumbnailSize=24;
+
+// Only decode a tiny version of the scaled cover - JPEG can do this without decoding the full image.
+static QImage loadScaledThumbnail(const Song &song, int size)
+{
+    QString fileName=getScaledCoverName(song, size, false);
+    if (fileName.isEmpty() || !QFile::exists(fileName)) {
+        return QImage();
+    }
+    QImageReader reader(fileName, constScaledFormat);
+    QSize sz=reader.size();
+    if (sz.isValid()) {
+        reader.setScaledSize(sz.scaled(constThumbnailSize, constThumbnailSize, Qt::KeepAspectRatio));
+    }
+    return reader.read();
+}
+
 bool Covers::isJpg(const QByteArray &data)
 {
     return data.size()>9 && /*data[0]==0xFF && data[1]==0xD8 && data[2]==0xFF*/ data[6]=='J' && data[7]=='F' && data[8]=='I' && data[9]=='F';
@@ -597,7 +649,12 @@ CoverDownloader::CoverDownloader()
     moveToThread(thread);
     thread->start();
     connect(this, SIGNAL(mpdCover(Song)), MPDConnection::self(), SLOT(getCover(Song)));
-    connect(MPDConnection::self(), SIGNAL(albumArt(Song,QByteArray)), this, SLOT(mpdAlbumArt(Song,QByteArray)));
+    connect(MPDConnection::self(), SIGNAL(albumArt(Song,QByteArray,bool)), this, SLOT(mpdAlbumArt(Song,QByteArray,bool)));
+}
+
+static bool isHttpDir(const QString &dir)
+{
+    return dir.startsWith(QLatin1String("http://"), Qt::CaseInsensitive) || dir.startsWith(QLatin1String("https://"), Qt::CaseInsensitive);
 }
 
 void CoverDownloader::stop()
@@ -642,9 +699,7 @@ void CoverDownloader::download(const Song &song)
 
     if (!song.isArtistImageRequest() && !song.isComposerImageRequest() && MPDConnection::self()->supportsCoverDownload()) {
         downloadViaMpd(job);
-    } else if (!MPDConnection::self()->getDetails().dir.isEmpty() &&
-               (MPDConnection::self()->getDetails().dir.startsWith(QLatin1String("http://"), Qt::CaseInsensitive) ||
-                MPDConnection::self()->getDetails().dir.startsWith(QLatin1String("https://"), Qt::CaseInsensitive))) {
+    } else if (isHttpDir(MPDConnection::self()->getDetails().dir)) {
         downloadViaHttp(job, JobHttpJpg);
     } else if (fetchCovers || job.song.isArtistImageRequest()) {
         downloadViaRemote(job);
@@ -727,12 +782,12 @@ void CoverDownloader::downloadViaRemote(Job &job)
     }
 }
 
-void CoverDownloader::mpdAlbumArt(const Song &song, const QByteArray &data)
+void CoverDownloader::mpdAlbumArt(const Song &song, const QByteArray &data, bool notFound)
 {
     QHash<QString, Job>::Iterator it = mpdJobs.find(song.file);
     if (it!=mpdJobs.end()) {
         Covers::Image img;
-        img.img= data.isEmpty() ? QImage() : QImage::fromData(data, Covers::imageFormat(data));
+        img.img=decodeImage(data);
         Job job=it.value();
 
         if (!img.img.isNull() && img.img.size().width()<32) {
@@ -741,7 +796,19 @@ void CoverDownloader::mpdAlbumArt(const Song &song, const QByteArray &data)
 
         mpdJobs.remove(it.key());
         if (img.img.isNull()) {
-            downloadViaHttp(job, JobHttpJpg);
+            if (data.isEmpty() && !notFound) {
+                job.error=true;
+            } else {
+                job.notFound|=Source_Mpd;
+            }
+            // Only try HTTP if the music folder is accessed that way - a local path is not a URL
+            if (isHttpDir(MPDConnection::self()->getDetails().dir)) {
+                downloadViaHttp(job, JobHttpJpg);
+            } else if (fetchCovers) {
+                downloadViaRemote(job);
+            } else {
+                failed(job);
+            }
         } else {
             if (!img.img.isNull()) {
                 if (img.img.size().width()>Covers::constMaxSize.width() || img.img.size().height()>Covers::constMaxSize.height()) {
@@ -754,13 +821,19 @@ void CoverDownloader::mpdAlbumArt(const Song &song, const QByteArray &data)
             }
 
             DBUG << "got cover image" << img.fileName;
-            emit cover(job.song, img.img, img.fileName);
+            emit cover(job.song, img.img, img.fileName, scaleImg(job.song, img.img));
         }
     } else {
        DBUG << "missing job for " << song.file;
     }
 }
 
+// A failed reply only means there is no image if the server said so - not if it could not be reached, etc.
+static bool isNotFound(NetworkJob *reply)
+{
+    return reply->ok() || QNetworkReply::ContentNotFoundError==reply->error();
+}
+
 void CoverDownloader::remoteCallFinished()
 {
     NetworkJob *reply=qobject_cast<NetworkJob *>(sender());
@@ -776,6 +849,9 @@ void CoverDownloader::remoteCallFinished()
     if (it!=end) {
         Job job=it.value();
         jobs.erase(it);
+        if (!isNotFound(reply)) {
+            job.error=true;
+        }
         QString url;
 
         if (reply->ok()) {
@@ -829,6 +905,7 @@ void CoverDownloader::remoteCallFinished()
             DBUG << "download" << url;
             jobs.insert(j, job);
         } else {
+            job.notFound|=Source_Online;
             failed(job);
         }
     }
@@ -850,6 +927,9 @@ void CoverDownloader::lastFmArtistCallFinished()
     if (it!=end) {
         Job job=it.value();
         jobs.erase(it);
+        if (!isNotFound(reply)) {
+            job.error=true;
+        }
         QUrl url;
 
         if (reply->ok()) {
@@ -910,7 +990,7 @@ void CoverDownloader::jobFinished()
     if (it!=end) {
         QByteArray data=reply->ok() ? reply->readAll() : QByteArray();
         Covers::Image img;
-        img.img= data.isEmpty() ? QImage() : QImage::fromData(data, Covers::imageFormat(data));
+        img.img=decodeImage(data);
         Job job=it.value();
 
         if (!img.img.isNull() && img.img.size().width()<32) {
@@ -918,6 +998,11 @@ void CoverDownloader::jobFinished()
         }
 
         jobs.remove(it.key());
+        if (!isNotFound(reply)) {
+            job.error=true;
+        } else if (img.img.isNull()) {
+            job.notFound|=JobRemote==job.type ? Source_Online : Source_Http;
+        }
         if (img.img.isNull() && JobRemote!=job.type) {
             if (JobHttpJpg==job.type) {
                 if (!job.level || !downloadViaHttp(job, JobHttpJpg)) {
@@ -942,16 +1027,19 @@ void CoverDownloader::jobFinished()
 
             if (job.song.isArtistImageRequest()) {
                 DBUG << "artist image, null?" << img.img.isNull();
-                emit artistImage(job.song, img.img, img.fileName);
+                emit artistImage(job.song, img.img, img.fileName, scaleImg(job.song, img.img));
             } else if (job.song.isComposerImageRequest()) {
                 DBUG << "compser image, null?" << img.img.isNull();
-                emit composerImage(job.song, img.img, img.fileName);
+                emit composerImage(job.song, img.img, img.fileName, scaleImg(job.song, img.img));
             } else if (img.img.isNull()) {
                 DBUG << "failed to download cover image";
-                emit cover(job.song, QImage(), QString());
+                emit cover(job.song, QImage(), QString(), ScaledCovers());
+                if (!job.error) {
+                    emit coverNotFound(job.song, job.notFound);
+                }
             } else {
                 DBUG << "got cover image" << img.fileName;
-                emit cover(job.song, img.img, img.fileName);
+                emit cover(job.song, img.img, img.fileName, scaleImg(job.song, img.img));
             }
         }
     }
@@ -984,7 +1072,8 @@ void CoverDownloader::onlineJobFinished()
         const Song &song=job.song;
         QString id=song.onlineService();
         QString fileName;
-        QImage img=data.isEmpty() ? QImage() : QImage::fromData(data, Covers::imageFormat(data));
+        QImage img=decodeImage(data);
+        ScaledCovers scaled;
 
         bool png=Covers::isPng(data);
         DBUG << "Got image" << id << song.albumArtist() << song.album << png;
@@ -1007,8 +1096,9 @@ void CoverDownloader::onlineJobFinished()
                     f.write(data);
                 }
             }
+            scaled=scaleImg(song, img);
         }
-        emit cover(job.song, img, fileName);
+        emit cover(job.song, img, fileName, scaled);
     }
 }
 
@@ -1016,14 +1106,50 @@ void CoverDownloader::failed(const Job &job)
 {
     if (job.song.isArtistImageRequest()) {
         DBUG << "artist image" << job.song.albumArtist();
-        emit artistImage(job.song, QImage(), QString());
+        emit artistImage(job.song, QImage(), QString(), ScaledCovers());
     } else if (job.song.isComposerImageRequest()) {
         DBUG << "composer image" << job.song.composer();
-        emit composerImage(job.song, QImage(), QString());
+        emit composerImage(job.song, QImage(), QString(), ScaledCovers());
     } else {
-        DBUG << "cover image" << job.song.albumArtist() << job.song.album;
-        emit cover(job.song, QImage(), QString());
+        DBUG << "cover image" << job.song.albumArtist() << job.song.album << job.notFound << job.error;
+        emit cover(job.song, QImage(), QString(), ScaledCovers());
+        if (!job.error) {
+            emit coverNotFound(job.song, job.notFound);
+        }
+    }
+}
+
+void CoverDownloader::setScaleSizes(const QSet<int> &sizes)
+{
+    QMutexLocker locker(&sizesMutex);
+    scaleSizes=sizes;
+}
+
+// Scale, and save, image to each of the sizes the GUI has cached - so that this is not done on the GUI thread.
+ScaledCovers CoverDownloader::scaleImg(const Song &song, const QImage &img)
+{
+    ScaledCovers scaled;
+    if (img.isNull()) {
+        return scaled;
+    }
+    sizesMutex.lock();
+    QSet<int> sizes=scaleSizes;
+    sizesMutex.unlock();
+
+    bool save=!isOnlineServiceImage(song);
+    for (int size: sizes) {
+        if (size<4) {
+            continue;
+        }
+        QImage s=scale(song, img, size);
+        if (save) {
+            QString fileName=getScaledCoverName(song, size, true);
+            bool status=!fileName.isEmpty() && s.save(fileName, constScaledFormat);
+            DBUG << song.albumArtist() << song.album << size << fileName << status;
+        }
+        scaled.insert(size, s);
     }
+    return scaled;
 }
 
 QString CoverDownloader::saveImg(const Job &job, const QImage &img, const QByteArray &raw)
@@ -1126,9 +1252,42 @@ NetworkAccessManager * CoverDownloader::network()
     return manager;
 }
 
+// Locating, and loading, covers is mainly disk I/O (and image decoding) - so spread the
+// requests over a few threads, rather than handling each cover in turn.
+static int coverPoolSize()
+{
+    return qBound(2, QThread::idealThreadCount(), 8);
+}
+
+// Covers are passed back as each job completes, but are only emitted once per frame - so
+// that views are not repainted for every single cover.
+static const int constFrameInterval=16;
+
+class LocateJob : public QRunnable
+{
+public:
+    LocateJob(QObject *o, int i, const Song &s) : owner(o), id(i), cancelled(false), cover(s) { setAutoDelete(false); }
+    void run() override
+    {
+        Covers::Image img=Covers::locateImage(cover.song);
+        cover=LocatedCover(cover.song, img.img, img.fileName);
+        QMetaObject::invokeMethod(owner, "jobFinished", Qt::QueuedConnection, Q_ARG(int, id));
+    }
+
+    QObject *owner;
+    int id;
+    bool cancelled; // Only accessed from owner's thread
+    LocatedCover cover;
+};
+
 CoverLocator::CoverLocator()
-    : timer(nullptr)
+    : frameTimer(nullptr)
+    , nextId(0)
 {
+    // Initialise list of names now, so that pool threads do not race to create this.
+    Covers::standardNames();
+    pool=new QThreadPool(this);
+    pool->setMaxThreadCount(coverPoolSize());
     thread=new Thread(metaObject()->className());
     moveToThread(thread);
     thread->start();
@@ -1136,58 +1295,87 @@ CoverLocator::CoverLocator()
 
 void CoverLocator::stop()
 {
+    pool->clear();
     thread->stop();
 }
 
-void CoverLocator::startTimer(int interval)
-{
-    if (!timer) {
-        timer=thread->createTimer(this);
-        timer->setSingleShot(true);
-        connect(timer, SIGNAL(timeout()), this, SLOT(locate()), Qt::QueuedConnection);
-    }
-    timer->start(interval);
-}
-
 void CoverLocator::locate(const Song &s)
 {
     queue.append(s);
-    startTimer(0);
+    startJobs();
 }
 
-// To improve responsiveness of views, we only process a max of X images per even loop iteration.
-// If more images are asked for, we place these into a list, and get them on the next iteration
-// of the loop. This way things appear smoother.
-static const int constMaxCoverUpdatePerIteration=10;
-
-void CoverLocator::locate()
+// Only hand the pool as many jobs as it has threads, so that requests not yet started remain
+// in our queue - where they can still be cancelled.
+void CoverLocator::startJobs()
 {
-    QList<Song> toDo;
-    for (int i=0; i<constMaxCoverUpdatePerIteration && !queue.isEmpty(); ++i) {
-        toDo.append(queue.takeFirst());
+    while (jobs.count()<pool->maxThreadCount() && !queue.isEmpty()) {
+        Song s=queue.takeFirst();
+        DBUG << s.file << s.artist << s.albumartist << s.album;
+        LocateJob *job=new LocateJob(this, nextId++, s);
+        jobs.insert(job->id, job);
+        pool->start(job);
     }
-    if (toDo.isEmpty()) {
+}
+
+void CoverLocator::jobFinished(int id)
+{
+    LocateJob *job=jobs.take(id);
+    if (!job) {
         return;
     }
-    QList<LocatedCover> covers;
-    for (const Song &s: toDo) {
-        DBUG << s.file << s.artist << s.albumartist << s.album;
-        Covers::Image img=Covers::locateImage(s);
-        covers.append(LocatedCover(s, img.img, img.fileName));
+    if (!job->cancelled) {
+        done.append(job->cover);
+        if (!frameTimer) {
+            frameTimer=thread->createTimer(this);
+            frameTimer->setSingleShot(true);
+            connect(frameTimer, SIGNAL(timeout()), this, SLOT(emitLocated()), Qt::QueuedConnection);
+        }
+        if (!frameTimer->isActive()) {
+            frameTimer->start(constFrameInterval);
+        }
     }
-    if (!covers.isEmpty()) {
+    delete job;
+    startJobs();
+}
+
+void CoverLocator::emitLocated()
+{
+    if (!done.isEmpty()) {
+        QList<LocatedCover> covers;
+        covers.swap(done);
         DBUG << "located" << covers.count();
         emit located(covers);
     }
+}
 
-    if (!queue.isEmpty()) {
-        startTimer(0);
+class LoadJob : public QRunnable
+{
+public:
+    LoadJob(QObject *o, int i, const LoadedCover &r) : owner(o), id(i), cancelled(false), cover(r) { setAutoDelete(false); }
+    void run() override
+    {
+        int size=cover.song.size;
+        if (size<constRetinaScaleMaxSize) {
+            size*=devicePixelRatio;
+        }
+        cover.img=cover.thumbnail ? loadScaledThumbnail(cover.song, size) : loadScaledCover(cover.song, size);
+        QMetaObject::invokeMethod(owner, "jobFinished", Qt::QueuedConnection, Q_ARG(int, id));
     }
-}
+
+    QObject *owner;
+    int id;
+    bool cancelled; // Only accessed from owner's thread
+    LoadedCover cover;
+};
 
 CoverLoader::CoverLoader()
-    : timer(nullptr)
+    : frameTimer(nullptr)
+    , nextId(0)
+    , runningPreloads(0)
 {
+    pool=new QThreadPool(this);
+    pool->setMaxThreadCount(coverPoolSize());
     thread=new Thread(metaObject()->className());
     moveToThread(thread);
     thread->start();
@@ -1195,57 +1383,127 @@ CoverLoader::CoverLoader()
 
 void CoverLoader::stop()
 {
+    pool->clear();
     thread->stop();
 }
 
-void CoverLoader::startTimer(int interval)
+static inline bool sameRequest(const LoadedCover &a, const Song &b)
 {
-    if (!timer) {
-        timer=thread->createTimer(this);
-        timer->setSingleShot(true);
-        connect(timer, SIGNAL(timeout()), this, SLOT(load()), Qt::QueuedConnection);
-    }
-    timer->start(interval);
+    return a.song.size==b.size && cacheKey(a.song, a.song.size)==cacheKey(b, b.size);
 }
 
 void CoverLoader::load(const Song &song)
 {
+    // Cover is now needed, so remove any pending (full-size) preload of it
+    QList<LoadedCover>::Iterator it=preloadQueue.begin();
+    while (it!=preloadQueue.end()) {
+        if (!(*it).thumbnail && sameRequest(*it, song)) {
+            it=preloadQueue.erase(it);
+        } else {
+            ++it;
+        }
+    }
     queue.append(LoadedCover(song));
-    startTimer(0);
+    startJobs();
+}
+
+void CoverLoader::preload(const Song &song, bool thumbnail)
+{
+    preloadQueue.append(LoadedCover(song, QImage(), true, thumbnail));
+    startJobs();
 }
 
-void CoverLoader::load()
+void CoverLoader::cancelPreload(const Song &song)
 {
-    QList<LoadedCover> toDo;
-    for (int i=0; i<constMaxCoverUpdatePerIteration && !queue.isEmpty(); ++i) {
-        toDo.append(queue.takeFirst());
+    QList<LoadedCover>::Iterator it=preloadQueue.begin();
+    while (it!=preloadQueue.end()) {
+        if (sameRequest(*it, song)) {
+            it=preloadQueue.erase(it);
+        } else {
+            ++it;
+        }
     }
-    if (toDo.isEmpty()) {
+
+    // Also cancel any preload already handed to the pool - if it has not started, it can be
+    // removed; otherwise its result is dropped when it completes.
+    QHash<int, LoadJob *>::Iterator jit=jobs.begin();
+    while (jit!=jobs.end()) {
+        LoadJob *job=jit.value();
+        if (job->cover.preload && !job->cancelled && sameRequest(job->cover, song)) {
+            if (pool->tryTake(job)) {
+                runningPreloads--;
+                delete job;
+                jit=jobs.erase(jit);
+                continue;
+            }
+            job->cancelled=true;
+        }
+        ++jit;
+    }
+    startJobs();
+}
+
+// Preloads are only started when there are no on-screen covers to load, and always leave one
+// thread free - so that a cover that is needed now does not wait behind a batch of preloads.
+void CoverLoader::startJobs()
+{
+    while (jobs.count()<pool->maxThreadCount()) {
+        bool preload=queue.isEmpty();
+        if (preload && (preloadQueue.isEmpty() || runningPreloads>=pool->maxThreadCount()-1)) {
+            break;
+        }
+        LoadedCover request=preload ? preloadQueue.takeFirst() : queue.takeFirst();
+        DBUG << request.song.albumArtist() << request.song.albumId() << request.song.size << request.preload;
+        LoadJob *job=new LoadJob(this, nextId++, request);
+        jobs.insert(job->id, job);
+        if (request.preload) {
+            runningPreloads++;
+        }
+        pool->start(job);
+    }
+}
+
+void CoverLoader::jobFinished(int id)
+{
+    LoadJob *job=jobs.take(id);
+    if (!job) {
         return;
     }
-    QList<LoadedCover> covers;
-    for (const LoadedCover &s: toDo) {
-        DBUG << s.song.albumArtist() << s.song.albumId() << s.song.size;
-        int size=s.song.size;
-        if (size<constRetinaScaleMaxSize) {
-            size*=devicePixelRatio;
+    if (job->cover.preload) {
+        runningPreloads--;
+    }
+    if (!job->cancelled) {
+        done.append(job->cover);
+        if (!frameTimer) {
+            frameTimer=thread->createTimer(this);
+            frameTimer->setSingleShot(true);
+            connect(frameTimer, SIGNAL(timeout()), this, SLOT(emitLoaded()), Qt::QueuedConnection);
+        }
+        if (!frameTimer->isActive()) {
+            frameTimer->start(constFrameInterval);
         }
-        covers.append(LoadedCover(s.song, loadScaledCover(s.song, size)));
     }
-    if (!covers.isEmpty()) {
+    delete job;
+    startJobs();
+}
+
+void CoverLoader::emitLoaded()
+{
+    if (!done.isEmpty()) {
+        QList<LoadedCover> covers;
+        covers.swap(done);
         DBUG << "loaded" << covers.count();
         emit loaded(covers);
     }
-
-    if (!queue.isEmpty()) {
-        startTimer(0);
-    }
 }
 
 Covers::Covers()
     : downloader(nullptr)
     , locator(nullptr)
     , loader(nullptr)
+    , mpdDbVersion(0)
+    , mpdCoverSources(0)
+    , noCoversModified(false)
 {
     devicePixelRatio=qApp->devicePixelRatio();
 
@@ -1258,6 +1516,10 @@ Covers::Covers()
         maxCost = sz.width() * sz.height() * 5; // *5 as 32-bit pixmap (so 4 bytes), + some wiggle rooom :-)
     }
     cache.setMaxCost(qMax(static_cast<int>(15*1024*1024*devicePixelRatio), maxCost)); // Ensure at least 15M
+    thumbnails.setMaxCost(2*1024*1024);
+    loadNoCovers();
+    connect(MPDStats::self(), SIGNAL(updated()), this, SLOT(mpdStatsUpdated()));
+    mpdStatsUpdated();
 }
 
 void Covers::readConfig()
@@ -1273,9 +1535,10 @@ void Covers::readConfig()
 void Covers::stop()
 {
     if (downloader) {
-        disconnect(downloader, SIGNAL(artistImage(Song,QImage,QString)), this, SLOT(artistImageDownloaded(Song,QImage,QString)));
-        disconnect(downloader, SIGNAL(composerImage(Song,QImage,QString)), this, SLOT(composerImageDownloaded(Song,QImage,QString)));
-        disconnect(downloader, SIGNAL(cover(Song,QImage,QString)), this, SLOT(coverDownloaded(Song,QImage,QString)));
+        disconnect(downloader, SIGNAL(artistImage(Song,QImage,QString,ScaledCovers)), this, SLOT(artistImageDownloaded(Song,QImage,QString,ScaledCovers)));
+        disconnect(downloader, SIGNAL(composerImage(Song,QImage,QString,ScaledCovers)), this, SLOT(composerImageDownloaded(Song,QImage,QString,ScaledCovers)));
+        disconnect(downloader, SIGNAL(cover(Song,QImage,QString,ScaledCovers)), this, SLOT(coverDownloaded(Song,QImage,QString,ScaledCovers)));
+        disconnect(downloader, SIGNAL(coverNotFound(Song,int)), this, SLOT(coverNotFound(Song,int)));
         downloader->stop();
         downloader=nullptr;
     }
@@ -1300,12 +1563,19 @@ void Covers::clearNameCache()
 {
     mutex.lock();
     filenames.clear();
+    noCovers.clear();
+    noCoversModified=false;
     mutex.unlock();
+    QString dir=Utils::cacheDir(constCoverDir, false);
+    if (!dir.isEmpty()) {
+        QFile::remove(dir+constNoCoverFile);
+    }
 }
 
 void Covers::clearScaleCache()
 {
     cache.clear();
+    thumbnails.clear();
 }
 
 QPixmap * Covers::getScaledCover(const Song &song, int size)
@@ -1344,6 +1614,12 @@ QPixmap * Covers::saveScaledCover(const QImage &img, const Song &song, int size)
         bool status=img.save(fileName, constScaledFormat);
         DBUG_CLASS("Covers") << song.albumArtist() << song.album << song.mbAlbumId() << size << fileName << status;
     }
+    return cacheScaledCover(img, song, size);
+}
+
+// Image has already been scaled, and saved, by CoverDownloader - so just need to cache a pixmap.
+QPixmap * Covers::cacheScaledCover(const QImage &img, const Song &song, int size)
+{
     QPixmap *pix=new QPixmap(QPixmap::fromImage(img));
     cache.insert(cacheKey(song, size), pix, pix->width()*pix->height()*(pix->depth()/8));
     cacheSizes.insert(size);
@@ -1453,6 +1729,7 @@ QPixmap * Covers::get(const Song &song, int size, bool urgent)
                 }
             }
             VERBOSE_DBUG << "Cached cover not found";
+            preloadRequests.remove(key);
             tryToLoad(setSizeRequest(song, origSize));
 
             // Create a dummy image so that we dont keep on locating/loading/downloading files that do not exist!
@@ -1470,32 +1747,107 @@ QPixmap * Covers::get(const Song &song, int size, bool urgent)
             return pix;
         }
     }
+    if (!key.isEmpty()) {
+        pix=thumbnailPix(song, size, origSize);
+        if (pix) {
+            VERBOSE_DBUG << "Use thumbnail pixmap";
+            return pix;
+        }
+    }
     VERBOSE_DBUG << "Use default pixmap";
     return defaultPix(song, size, origSize);
 }
 
-void Covers::coverDownloaded(const Song &song, const QImage &img, const QString &file)
+void Covers::preload(const Song &song, int size, bool thumbnail)
 {
-    gotAlbumCover(song, img, file);
+    if (0==size || song.isUnknownAlbum() || song.isStandardStream() || Song::SingleTracks==song.type || isOnlineServiceImage(song)) {
+        return;
+    }
+    int origSize=size;
+    if (size<constRetinaScaleMaxSize) {
+        size*=devicePixelRatio;
+    }
+    QString key=cacheKey(song, size);
+    // Already loaded, or a normal load has been requested.
+    if (cache.contains(key) || (thumbnail && thumbnails.contains(songKey(song)))) {
+        return;
+    }
+    if (thumbnail) {
+        key+=QLatin1String("-thumb");
+    }
+    if (preloadRequests.contains(key)) {
+        return;
+    }
+    preloadRequests.insert(key);
+    initLoader();
+    emit preloadCover(setSizeRequest(song, origSize), thumbnail);
 }
 
-void Covers::artistImageDownloaded(const Song &song, const QImage &img, const QString &file)
+void Covers::cancelPreload(const Song &song, int size)
 {
-    gotArtistImage(song, img, file);
+    if (preloadRequests.isEmpty()) {
+        return;
+    }
+    int origSize=size;
+    if (size<constRetinaScaleMaxSize) {
+        size*=devicePixelRatio;
+    }
+    QString key=cacheKey(song, size);
+    bool full=preloadRequests.remove(key);
+    bool thumb=preloadRequests.remove(key+QLatin1String("-thumb"));
+    if ((full || thumb) && loader) {
+        emit cancelPreloadCover(setSizeRequest(song, origSize));
+    }
 }
 
-void Covers::composerImageDownloaded(const Song &song, const QImage &img, const QString &file)
+QPixmap * Covers::thumbnailPix(const Song &song, int size, int origSize)
 {
-    gotComposerImage(song, img, file);
+    QString key=cacheKey(song, size)+QLatin1String("-thumb");
+    QPixmap *pix=cache.object(key);
+    if (pix) {
+        return pix;
+    }
+    QImage *thumb=thumbnails.object(songKey(song));
+    if (!thumb) {
+        return nullptr;
+    }
+    // Smooth scaling a tiny image up gives a blurred placeholder
+    pix=new QPixmap(QPixmap::fromImage(thumb->scaled(QSize(size, size), Qt::KeepAspectRatio, Qt::SmoothTransformation)));
+    if (size!=origSize) {
+        pix->setDevicePixelRatio(devicePixelRatio);
+    }
+    cache.insert(key, pix, pix->width()*pix->height()*(pix->depth()/8));
+    return pix;
+}
+
+void Covers::coverDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled)
+{
+    gotAlbumCover(song, img, file, true, scaled);
+}
+
+void Covers::coverNotFound(const Song &song, int sources)
+{
+    addNoCover(song, sources);
 }
 
-bool Covers::updateCache(const Song &song, const QImage &img, bool dummyEntriesOnly)
+void Covers::artistImageDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled)
+{
+    gotArtistImage(song, img, file, true, scaled);
+}
+
+void Covers::composerImageDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled)
+{
+    gotComposerImage(song, img, file, true, scaled);
+}
+
+bool Covers::updateCache(const Song &song, const QImage &img, bool dummyEntriesOnly, const ScaledCovers &scaled)
 {
     // Only remove all scaled entries from disk if the cover has been set by the CoverDialog
     // This is the only case where dummyEntriesOnly==false
     // dummyEntriesOnly => entries in cache that have a 'dummy' pixmap
     if (!dummyEntriesOnly) {
         clearScaledCache(song);
+        thumbnails.remove(songKey(song));
     }
     #ifdef ENABLE_DEVICES_SUPPORT
     bool emitLoaded=!song.isFromDevice();
@@ -1508,12 +1860,14 @@ bool Covers::updateCache(const Song &song, const QImage &img, bool dummyEntriesO
         QString key=cacheKey(song, s);
         QPixmap *pix(cache.object(key));
 
+        cache.remove(key+QLatin1String("-thumb"));
         if (pix && (!dummyEntriesOnly || pix->width()<2)) {
             double pixRatio=pix->devicePixelRatio();
             cache.remove(key);
             if (!img.isNull()) {
                 DBUG_CLASS("Covers");
-                QPixmap *p=saveScaledCover(scale(song, img, s), song, s);
+                ScaledCovers::ConstIterator sIt=scaled.constFind(s);
+                QPixmap *p=sIt==scaled.constEnd() ? saveScaledCover(scale(song, img, s), song, s) : cacheScaledCover(sIt.value(), song, s);
                 if (p) {
                     p->setDevicePixelRatio(pixRatio);
                     DBUG << "Set pixel ratio of updated cached pixmap" << devicePixelRatio;
@@ -1552,15 +1906,24 @@ void Covers::tryToDownload(const Song &song)
     }
     #endif
     if (!downloader) {
+        qRegisterMetaType<ScaledCovers>("ScaledCovers");
         downloader=new CoverDownloader();
         connect(this, SIGNAL(download(Song)), downloader, SLOT(download(Song)), Qt::QueuedConnection);
-        connect(downloader, SIGNAL(artistImage(Song,QImage,QString)), this, SLOT(artistImageDownloaded(Song,QImage,QString)), Qt::QueuedConnection);
-        connect(downloader, SIGNAL(cover(Song,QImage,QString)), this, SLOT(coverDownloaded(Song,QImage,QString)), Qt::QueuedConnection);
+        connect(downloader, SIGNAL(artistImage(Song,QImage,QString,ScaledCovers)), this, SLOT(artistImageDownloaded(Song,QImage,QString,ScaledCovers)), Qt::QueuedConnection);
+        connect(downloader, SIGNAL(cover(Song,QImage,QString,ScaledCovers)), this, SLOT(coverDownloaded(Song,QImage,QString,ScaledCovers)), Qt::QueuedConnection);
+        connect(downloader, SIGNAL(coverNotFound(Song,int)), this, SLOT(coverNotFound(Song,int)), Qt::QueuedConnection);
     }
+    downloader->setScaleSizes(cacheSizes);
     emit download(song);
 }
 
 void Covers::tryToLoad(const Song &song)
+{
+    initLoader();
+    emit load(song);
+}
+
+void Covers::initLoader()
 {
     if (!loader) {
         qRegisterMetaType<LoadedCover>("LoadedCover");
@@ -1568,8 +1931,9 @@ void Covers::tryToLoad(const Song &song)
         loader=new CoverLoader();
         connect(loader, SIGNAL(loaded(QList<LoadedCover>)), this, SLOT(loaded(QList<LoadedCover>)), Qt::QueuedConnection);
         connect(this, SIGNAL(load(Song)), loader, SLOT(load(Song)), Qt::QueuedConnection);
+        connect(this, SIGNAL(preloadCover(Song,bool)), loader, SLOT(preload(Song,bool)), Qt::QueuedConnection);
+        connect(this, SIGNAL(cancelPreloadCover(Song)), loader, SLOT(cancelPreload(Song)), Qt::QueuedConnection);
     }
-    emit load(song);
 }
 
 Covers::Image Covers::findImage(const Song &song, bool emitResult)
@@ -1945,6 +2309,8 @@ void Covers::located(const QList<LocatedCover> &covers)
             } else {
                 gotAlbumCover(cvr.song, cvr.img, cvr.fileName);
             }
+        } else if (constNoCover==cvr.fileName) { // Already know there is no cover
+            currentImageRequests.remove(songKey(cvr.song));
         } else { // Failed to locate a cover, so try to download one...
             tryToDownload(cvr.song);
         }
@@ -1954,6 +2320,30 @@ void Covers::located(const QList<LocatedCover> &covers)
 void Covers::loaded(const QList<LoadedCover> &covers)
 {
     for (const LoadedCover &cvr: covers) {
+        if (cvr.preload) {
+            int size=cvr.song.size;
+            if (size<constRetinaScaleMaxSize) {
+                size*=devicePixelRatio;
+            }
+            QString key=cacheKey(cvr.song, size);
+            if (!preloadRequests.remove(cvr.thumbnail ? key+QLatin1String("-thumb") : key) || cvr.img.isNull()) {
+                // Cancelled, or no scaled cover - will be located when actually displayed.
+                continue;
+            }
+            if (cvr.thumbnail) {
+                thumbnails.insert(songKey(cvr.song), new QImage(cvr.img), cvr.img.sizeInBytes());
+                QPixmap *pix=cache.object(key);
+                if (pix && pix->width()>1) {
+                    continue;
+                }
+                emit loaded(cvr.song, cvr.song.size);
+                continue;
+            }
+            QPixmap *pix=cache.object(key);
+            if (pix && pix->width()>1) {
+                continue;
+            }
+        }
         if (!cvr.img.isNull()) {
             int size=cvr.song.size;
             int origSize=size;
@@ -1978,7 +2368,12 @@ void Covers::updateCover(const Song &song, const QImage &img, const QString &fil
 {
     updateCache(song, img, false);
     if (!file.isEmpty()) {
+        mutex.lock();
         filenames[songKey(song)]=file;
+        if (noCovers.remove(songKey(song))) {
+            noCoversModified=true;
+        }
+        mutex.unlock();
     }
     #ifdef ENABLE_DEVICES_SUPPORT
     if (!song.isFromDevice())
@@ -2005,19 +2400,22 @@ void Covers::cleanCdda()
 }
 #endif
 
-void Covers::gotAlbumCover(const Song &song, const QImage &img, const QString &fileName, bool emitResult)
+void Covers::gotAlbumCover(const Song &song, const QImage &img, const QString &fileName, bool emitResult, const ScaledCovers &scaled)
 {
     QString key=albumKey(song);
     currentImageRequests.remove(key);
 //    if (!img.isNull() && !fileName.isEmpty() && !fileName.startsWith("http:/", Qt::CaseInsensitive) && !fileName.startsWith("https:/", Qt::CaseInsensitive)  ) {
         mutex.lock();
         filenames.insert(key, fileName.isEmpty() ? constNoCover : fileName);
+        if (!fileName.isEmpty() && noCovers.remove(key)) {
+            noCoversModified=true;
+        }
         mutex.unlock();
 //    }
     if (emitResult) {
         bool updatedCover=false;
         if (!img.isNull()) {
-            updatedCover=updateCache(song, img, true);
+            updatedCover=updateCache(song, img, true, scaled);
         }
         if (updatedCover || song.isCdda()/* || !song.isSpecificSizeRequest()*/) {
             DBUG << "emit cover" << song.file << song.artist << song.albumartist << song.album << song.mbAlbumId() << img.width() << img.height() << fileName;
@@ -2026,7 +2424,7 @@ void Covers::gotAlbumCover(const Song &song, const QImage &img, const QString &f
     }
 }
 
-void Covers::gotArtistImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult)
+void Covers::gotArtistImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult, const ScaledCovers &scaled)
 {
     QString key=artistKey(song);
     currentImageRequests.remove(key);
@@ -2037,7 +2435,7 @@ void Covers::gotArtistImage(const Song &song, const QImage &img, const QString &
 //    }
     if (emitResult) {
         if (!img.isNull()) {
-            updateCache(song, img, true);
+            updateCache(song, img, true, scaled);
         }
 //        if (!song.isSpecificSizeRequest()) {
             DBUG << "emit artistImage" << song.file << song.artist << song.albumartist << song.album << img.width() << img.height() << fileName;
@@ -2046,7 +2444,7 @@ void Covers::gotArtistImage(const Song &song, const QImage &img, const QString &
     }
 }
 
-void Covers::gotComposerImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult)
+void Covers::gotComposerImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult, const ScaledCovers &scaled)
 {
     QString key=composerKey(song);
     currentImageRequests.remove(key);
@@ -2057,7 +2455,7 @@ void Covers::gotComposerImage(const Song &song, const QImage &img, const QString
 //    }
     if (emitResult) {
         if (!img.isNull()) {
-            updateCache(song, img, true);
+            updateCache(song, img, true, scaled);
         }
 //        if (!song.isSpecificSizeRequest()) {
             DBUG << "emit composerImage" << song.file << song.artist << song.albumartist << song.album << song.composer() << img.width() << img.height() << fileName;
@@ -2066,13 +2464,200 @@ void Covers::gotComposerImage(const Song &song, const QImage &img, const QString
     }
 }
 
+// Modification time of song's folder, or 0 if this is not locally accessible.
+static time_t dirModified(const QString &musicDir, const Song &song)
+{
+    if (musicDir.isEmpty()) {
+        return 0;
+    }
+    QFileInfo info(musicDir+Utils::getDir(song.file));
+    return info.exists() ? info.lastModified().toTime_t() : 0;
+}
+
 QString Covers::getFilename(const Song &s)
 {
+    QString key=songKey(s);
     mutex.lock();
-    QMap<QString, QString>::ConstIterator fileIt=filenames.find(songKey(s));
+    QMap<QString, QString>::ConstIterator fileIt=filenames.find(key);
     QString f=fileIt==filenames.end() ? QString() : fileIt.value();
+    QHash<QString, NoCover>::ConstIterator noCoverIt=f.isEmpty() ? noCovers.constFind(key) : noCovers.constEnd();
+    if (noCoverIt==noCovers.constEnd()) {
+        mutex.unlock();
+        return f;
+    }
+    bool checkDir=0!=noCoverIt.value().dirModified;
+    QString musicDir=localMusicDir;
+    mutex.unlock();
+
+    // Folder is checked without holding the mutex, as this may be slow (e.g. network mounts)
+    time_t modified=checkDir ? dirModified(musicDir, s) : 0;
+    mutex.lock();
+    if (isNoCover(s, key, modified)) {
+        f=constNoCover;
+        filenames.insert(key, f);
+    }
     mutex.unlock();
     return f;
 }
 
+// Only albums from the MPD collection are remembered across sessions - the sources for everything
+// else (devices, online services, CDs) are either cheap to check or change independently of MPD.
+static bool canRememberNoCover(const Song &song)
+{
+    return !song.file.isEmpty() && !song.isArtistImageRequest() && !song.isComposerImageRequest() && !song.isCdda() &&
+           !song.isStandardStream() && !song.isFromOnlineService() && Song::SingleTracks!=song.type && Song::OnlineSvrTrack!=song.type
+           #ifdef ENABLE_DEVICES_SUPPORT
+           && !song.isFromDevice()
+           #endif
+           ;
+}
+
+void Covers::mpdStatsUpdated()
+{
+    // Stats are updated upon (re)connection, so also re-check where covers may come from
+    QString musicDir=MPDConnection::self()->getDetails().dir;
+    int sources=isHttpDir(musicDir) ? CoverDownloader::Source_Http : 0;
+    if (MPDConnection::self()->supportsCoverDownload()) {
+        sources|=CoverDownloader::Source_Mpd;
+    }
+    if (!QDir(musicDir).isAbsolute() || (sources&CoverDownloader::Source_Http)) {
+        musicDir=QString();
+    }
+
+    time_t version=MPDStats::self()->dbUpdate();
+    mutex.lock();
+    localMusicDir=musicDir;
+    mpdCoverSources=sources;
+    if (version==mpdDbVersion) {
+        mutex.unlock();
+        return;
+    }
+    // Database has changed, so files may have been added - forget anything recorded against another version.
+    mpdDbVersion=version;
+    if (0!=version) {
+        QHash<QString, NoCover>::Iterator it=noCovers.begin();
+        while (it!=noCovers.end()) {
+            if (it.value().dbVersion!=version) {
+                it=noCovers.erase(it);
+                noCoversModified=true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    mutex.unlock();
+}
+
+void Covers::loadNoCovers()
+{
+    QString dir=Utils::cacheDir(constCoverDir, false);
+    if (dir.isEmpty()) {
+        return;
+    }
+    QFile file(dir+constNoCoverFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    quint32 version=0;
+    quint32 count=0;
+    stream >> version >> count;
+    if (constNoCoverFileVersion!=version) {
+        return;
+    }
+    time_t now=QDateTime::currentDateTime().toTime_t();
+    for (quint32 i=0; i<count && QDataStream::Ok==stream.status(); ++i) {
+        QString key;
+        qint64 stamp=0;
+        qint64 dbVersion=0;
+        qint64 dirModified=0;
+        quint32 sources=0;
+        stream >> key >> stamp >> dbVersion >> dirModified >> sources;
+        if (QDataStream::Ok==stream.status() && stamp+constNoCoverTtl>now) {
+            noCovers.insert(key, NoCover(stamp, dbVersion, dirModified, sources));
+        }
+    }
+    noCoversModified=noCovers.size()!=(int)count;
+    DBUG << "Loaded" << noCovers.size() << "albums without covers";
+}
+
+void Covers::saveNoCovers()
+{
+    mutex.lock();
+    if (!noCoversModified) {
+        mutex.unlock();
+        return;
+    }
+    QHash<QString, NoCover> entries=noCovers;
+    noCoversModified=false;
+    mutex.unlock();
+
+    QString dir=Utils::cacheDir(constCoverDir, !entries.isEmpty());
+    if (dir.isEmpty()) {
+        return;
+    }
+    if (entries.isEmpty()) {
+        QFile::remove(dir+constNoCoverFile);
+        return;
+    }
+    QFile file(dir+constNoCoverFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << constNoCoverFileVersion << (quint32)entries.size();
+    QHash<QString, NoCover>::ConstIterator it=entries.constBegin();
+    QHash<QString, NoCover>::ConstIterator end=entries.constEnd();
+    for (; it!=end; ++it) {
+        stream << it.key() << (qint64)it.value().stamp << (qint64)it.value().dbVersion << (qint64)it.value().dirModified << (quint32)it.value().sources;
+    }
+    DBUG << "Saved" << entries.size() << "albums without covers";
+}
+
+void Covers::addNoCover(const Song &song, int sources)
+{
+    if (!canRememberNoCover(song)) {
+        return;
+    }
+    mutex.lock();
+    time_t version=mpdDbVersion;
+    QString musicDir=localMusicDir;
+    mutex.unlock();
+    if (0==version) {
+        return;
+    }
+    NoCover entry(QDateTime::currentDateTime().toTime_t(), version, dirModified(musicDir, song), sources);
+    mutex.lock();
+    noCovers.insert(albumKey(song), entry);
+    noCoversModified=true;
+    mutex.unlock();
+}
+
+// Whether key is recorded as having no cover, and that each source that could now be queried was
+// queried then. 'modified' is the current modification time of the album's folder.
+// NOTE: Called with mutex locked.
+bool Covers::isNoCover(const Song &song, const QString &key, time_t modified)
+{
+    QHash<QString, NoCover>::Iterator it=noCovers.find(key);
+    if (it==noCovers.end()) {
+        return false;
+    }
+    const NoCover &entry=it.value();
+    int sources=mpdCoverSources|(fetchCovers ? CoverDownloader::Source_Online : 0);
+    bool valid=0!=mpdDbVersion && entry.dbVersion==mpdDbVersion &&
+               entry.stamp+constNoCoverTtl>(time_t)QDateTime::currentDateTime().toTime_t() &&
+               (entry.sources&sources)==sources && canRememberNoCover(song) &&
+               (0==entry.dirModified || entry.dirModified==modified);
+    if (!valid) {
+        // Only drop entries that are definitely stale - the MPD database version may not yet be known.
+        if (0!=mpdDbVersion) {
+            noCovers.erase(it);
+            noCoversModified=true;
+        }
+        return false;
+    }
+    DBUG << "No cover (from previous session)" << key;
+    return true;
+}
+
 #include "moc_covers.cpp"
@@ -34,14 +34,21 @@
 #include <QCache>
 #include "mpd-interface/song.h"
 #include "config.h"
+#include <time.h>
 
 class QString;
 class Thread;
 class NetworkJob;
 class QMutex;
 class QTimer;
+class QThreadPool;
+class LocateJob;
+class LoadJob;
 class NetworkAccessManager;
 
+// Cover scaled to each of the sizes in use, keyed on (device) pixel size.
+typedef QMap<int, QImage> ScaledCovers;
+
 class CoverDownloader : public QObject
 {
     Q_OBJECT
@@ -54,30 +61,43 @@ public:
         JobRemote
     };
 
+    // Sources, other than the album's folder, that may be queried for a cover
+    enum Source {
+        Source_Mpd    = 0x01, // MPD's albumart command
+        Source_Http   = 0x02, // Music folder, when accessed via HTTP
+        Source_Online = 0x04  // Online services
+    };
+
     struct Job
     {
         Job(const Song &s, const QString &d)
-            : song(s), filePath(s.filePath()), dir(d), type(JobRemote), level(0) { }
+            : song(s), filePath(s.filePath()), dir(d), type(JobRemote), level(0), notFound(0), error(false) { }
         Song song;
         QString filePath;
         QString dir;
         JobType type;
         int level;
+        int notFound; // Sources that reported there is no image
+        bool error;   // A source failed for a reason other than not having an image (e.g. timeout)
     };
 
     CoverDownloader();
     ~CoverDownloader() override { }
 
     void stop();
+    // Sizes that downloaded images should be scaled to - called from the GUI thread.
+    void setScaleSizes(const QSet<int> &sizes);
 
 public Q_SLOTS:
     void download(const Song &s);
 
 Q_SIGNALS:
-    void cover(const Song &song, const QImage &img, const QString &file);
-    void artistImage(const Song &song, const QImage &img, const QString &file);
-    void composerImage(const Song &song, const QImage &img, const QString &file);
+    void cover(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
+    void artistImage(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
+    void composerImage(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
     void mpdCover(const Song &song);
+    // Each of the queried sources reported that there is no cover - emitted after cover() with a null image
+    void coverNotFound(const Song &song, int sources);
 
 private:
     void downloadViaMpd(Job &job);
@@ -85,7 +105,7 @@ private:
     void downloadViaRemote(Job &job);
 
 private Q_SLOTS:
-    void mpdAlbumArt(const Song &song, const QByteArray &data);
+    void mpdAlbumArt(const Song &song, const QByteArray &data, bool notFound);
     void remoteCallFinished();
     void lastFmArtistCallFinished();
     void jobFinished();
@@ -94,12 +114,15 @@ private Q_SLOTS:
 private:
     void failed(const Job &job);
     QString saveImg(const Job &job, const QImage &img, const QByteArray &raw);
+    ScaledCovers scaleImg(const Song &song, const QImage &img);
     QHash<NetworkJob *, Job>::Iterator findJob(const Job &job);
     NetworkAccessManager * network();
 
 private:
     QHash<NetworkJob *, Job> jobs;
     QHash<QString, Job> mpdJobs;
+    QMutex sizesMutex;
+    QSet<int> scaleSizes;
 
 private:
     Thread *thread;
@@ -129,23 +152,32 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void locate(const Song &s);
-    void locate();
+
+private Q_SLOTS:
+    void jobFinished(int id);
+    void emitLocated();
 
 private:
-    void startTimer(int interval);
+    void startJobs();
 
 private:
     Thread *thread;
-    QTimer *timer;
+    QTimer *frameTimer;
+    QThreadPool *pool;
     QList<Song> queue;
+    QHash<int, LocateJob *> jobs;
+    QList<LocatedCover> done;
+    int nextId;
 };
 
 struct LoadedCover
 {
-    LoadedCover(const Song &sng=Song(), const QImage &i=QImage())
-        : song(sng), img(i) { }
+    LoadedCover(const Song &sng=Song(), const QImage &i=QImage(), bool p=false, bool t=false)
+        : song(sng), img(i), preload(p), thumbnail(t) { }
     Song song;
     QImage img;
+    bool preload;
+    bool thumbnail;
 };
 
 class CoverLoader : public QObject
@@ -162,15 +194,26 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void load(const Song &song);
-    void load();
+    void preload(const Song &song, bool thumbnail);
+    void cancelPreload(const Song &song);
+
+private Q_SLOTS:
+    void jobFinished(int id);
+    void emitLoaded();
 
 private:
-    void startTimer(int interval);
+    void startJobs();
 
 private:
     Thread *thread;
-    QTimer *timer;
+    QTimer *frameTimer;
+    QThreadPool *pool;
     QList<LoadedCover> queue;
+    QList<LoadedCover> preloadQueue; // Only processed when 'queue' is empty
+    QHash<int, LoadJob *> jobs;
+    QList<LoadedCover> done;
+    int nextId;
+    int runningPreloads;
 };
 
 class Covers : public QObject
@@ -225,6 +268,10 @@ public:
     // Get cover image of specified size. If this is not found 0 will be returned, and the cover
     // will be downloaded.
     QPixmap * get(const Song &song, int size, bool urgent=false);
+    // Load scaled cover, at low priority, ahead of it being displayed. If 'thumbnail' is set then only
+    // a tiny version is loaded - get() will show this, scaled up, until the real cover is loaded.
+    void preload(const Song &song, int size, bool thumbnail);
+    void cancelPreload(const Song &song, int size);
     // Get QImage and filename associated with Song request. If this is not found, then the cover
     // will NOT be downloaded. 'emitResult' controls whether 'cover()/artistImage()' is emitted if
     // a cover is found.
@@ -234,6 +281,8 @@ public:
     // the cover requests are placed on a queue.
     Image requestImage(const Song &song, bool urgent=false);
     void updateCover(const Song &song, const QImage &img, const QString &file);
+    // Write list of albums without covers, so that these are not searched for again next session.
+    void saveNoCovers();
 
     #if defined CDDB_FOUND || defined MUSICBRAINZ5_FOUND
     void cleanCdda();
@@ -245,6 +294,8 @@ Q_SIGNALS:
     void download(const Song &s);
     void locate(const Song &s);
     void load(const Song &song);
+    void preloadCover(const Song &song, bool thumbnail);
+    void cancelPreloadCover(const Song &song);
     void loaded(const Song &song, int s);
     void cover(const Song &song, const QImage &img, const QString &file);
     void coverUpdated(const Song &song, const QImage &img, const QString &file);
@@ -254,20 +305,41 @@ Q_SIGNALS:
 private Q_SLOTS:
     void located(const QList<LocatedCover> &covers);
     void loaded(const QList<LoadedCover> &covers);
-    void coverDownloaded(const Song &song, const QImage &img, const QString &file);
-    void artistImageDownloaded(const Song &song, const QImage &img, const QString &file);
-    void composerImageDownloaded(const Song &song, const QImage &img, const QString &file);
+    void coverDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
+    void coverNotFound(const Song &song, int sources);
+    void artistImageDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
+    void composerImageDownloaded(const Song &song, const QImage &img, const QString &file, const ScaledCovers &scaled);
+    void mpdStatsUpdated();
+
+private:
+    // Album for which no cover could be found, by any means, in a previous session.
+    struct NoCover
+    {
+        NoCover(time_t s=0, time_t v=0, time_t m=0, int src=0)
+            : stamp(s), dbVersion(v), dirModified(m), sources(src) { }
+        time_t stamp;       // When recorded
+        time_t dbVersion;   // MPD database version at that time
+        time_t dirModified; // Modification time of album's folder, if this was accessible
+        int sources;        // CoverDownloader::Source values that reported there is no cover
+    };
+
+    void loadNoCovers();
+    void addNoCover(const Song &song, int sources);
+    bool isNoCover(const Song &song, const QString &key, time_t modified);
 
 private:
     QPixmap * defaultPix(const Song &song, int size, int origSize);
     void tryToLocate(const Song &song);
     void tryToDownload(const Song &song);
     void tryToLoad(const Song &song);
+    void initLoader();
+    QPixmap * thumbnailPix(const Song &song, int size, int origSize);
     Image findImage(const Song &song, bool emitResult);
-    bool updateCache(const Song &song, const QImage &img, bool dummyEntriesOnly);
-    void gotAlbumCover(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true);
-    void gotArtistImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true);
-    void gotComposerImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true);
+    QPixmap * cacheScaledCover(const QImage &img, const Song &song, int size);
+    bool updateCache(const Song &song, const QImage &img, bool dummyEntriesOnly, const ScaledCovers &scaled=ScaledCovers());
+    void gotAlbumCover(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true, const ScaledCovers &scaled=ScaledCovers());
+    void gotArtistImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true, const ScaledCovers &scaled=ScaledCovers());
+    void gotComposerImage(const Song &song, const QImage &img, const QString &fileName, bool emitResult=true, const ScaledCovers &scaled=ScaledCovers());
     QString getFilename(const Song &s);
 
 private:
@@ -275,11 +347,18 @@ private:
     QList<Song> queue;
     QSet<int> cacheSizes;
     QCache<QString, QPixmap> cache;
+    QCache<QString, QImage> thumbnails;
+    QSet<QString> preloadRequests;
     QMap<QString, QString> filenames;
     CoverDownloader *downloader;
     CoverLocator *locator;
     CoverLoader *loader;
     QMutex mutex;
+    QHash<QString, NoCover> noCovers;
+    time_t mpdDbVersion;
+    QString localMusicDir; // MPD's music folder, if this is locally accessible
+    int mpdCoverSources;   // Sources, other than online services, available for the current MPD
+    bool noCoversModified;
 };
 
 #endif
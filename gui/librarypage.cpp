@@ -47,6 +47,7 @@ LibraryPage::LibraryPage(QWidget *p)
     connect(view, SIGNAL(itemsSelected(bool)), this, SLOT(controlActions()));
     connect(view, SIGNAL(doubleClicked(const QModelIndex &)), this, SLOT(itemDoubleClicked(const QModelIndex &)));
     view->setModel(MpdLibraryModel::self());
+    view->setAsyncSearch(true);
     connect(MpdLibraryModel::self(), SIGNAL(modelReset()), this, SLOT(modelReset()));
 
     view->allowCategorized();
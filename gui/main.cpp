@@ -170,6 +170,7 @@ static QString debugAreas()
             #ifdef AVAHI_FOUND
             +QObject::tr("avahi - Auto-discovery of MPD servers")+QLatin1Char('\n')
             #endif
+            +QObject::tr("track-change - Updates made when the current track changes")+QLatin1Char('\n')
             +QObject::tr("all - Enable all debug")+QLatin1Char('\n')
             ;
 }
@@ -262,6 +263,9 @@ static void installDebugMessageHandler(const QString &cmdLine)
             AvahiDiscovery::enableDebug();
         }
         #endif
+        if (all || QLatin1String("track-change")==area) {
+            MainWindow::enableDebug();
+        }
     }
     qInstallMessageHandler(cantataQtMsgHandler);
 }
@@ -371,11 +375,13 @@ int main(int argc, char *argv[])
     QCommandLineOption noNetworkOption(QStringList() << "n" << "no-network", QObject::tr("Disable network access"), "", "false");
     QCommandLineOption collectionOption(QStringList() << "c" << "collection", QObject::tr("Collection name"), "collection", "");
     QCommandLineOption fullscreenOption(QStringList() << "F" << "fullscreen", QObject::tr("Start full screen"), "", "false");
+    QCommandLineOption traceMpdOption(QStringList() << "t" << "trace-mpd", QObject::tr("Record all MPD commands and responses, with timings, to file"), "file", "");
     cmdLineParser.addOption(debugOption);
     cmdLineParser.addOption(debugToFileOption);
     cmdLineParser.addOption(noNetworkOption);
     cmdLineParser.addOption(collectionOption);
     cmdLineParser.addOption(fullscreenOption);
+    cmdLineParser.addOption(traceMpdOption);
     cmdLineParser.process(app);
     QStringList files = cmdLineParser.positionalArguments();
 
@@ -386,6 +392,9 @@ int main(int argc, char *argv[])
     if (cmdLineParser.isSet(noNetworkOption)) {
         NetworkAccessManager::disableNetworkAccess();
     }
+    if (cmdLineParser.isSet(traceMpdOption) && !cmdLineParser.value(traceMpdOption).isEmpty()) {
+        MPDConnection::enableTrace(cmdLineParser.value(traceMpdOption));
+    }
 
     // Set the permissions on the config file on Unix - it can contain passwords
     // for internet services so it's important that other users can't read it.
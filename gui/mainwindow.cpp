@@ -122,9 +122,22 @@
 #include <QFileDialog>
 #include <QLocale>
 #include "mediakeys.h"
+#include <QElapsedTimer>
+#include <QDebug>
 #include <cstdlib>
 #include <algorithm>
 
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << "MainWindow" << __FUNCTION__
+
+void MainWindow::enableDebug()
+{
+    debugEnabled=true;
+}
+
+// Context, tray, MPRIS, etc. are only updated once track changes have settled for this long.
+static const int constSongChangeDelay=100;
+
 static int nextKey(int &key)
 {
     int k=key;
@@ -160,6 +173,7 @@ MainWindow::MainWindow(QWidget *parent)
     #endif
     , contextTimer(nullptr)
     , contextSwitchTime(0)
+    , songChangeTimer(nullptr)
     , connectedState(CS_Init)
     , stopAfterCurrent(false)
     , responsiveSidebar(false)
@@ -817,6 +831,8 @@ MainWindow::MainWindow(QWidget *parent)
     connect(playQueue, SIGNAL(itemsSelected(bool)), SLOT(playQueueItemsSelected(bool)));
     connect(MPDStatus::self(), SIGNAL(updated()), this, SLOT(updateStatus()));
     connect(MPDConnection::self(), SIGNAL(playlistUpdated(const QList<Song> &, bool)), this, SLOT(updatePlayQueue(const QList<Song> &, bool)));
+    connect(MPDConnection::self(), SIGNAL(playlistPagedUpdated(QList<qint32>,QList<quint32>)), this, SLOT(updatePagedPlayQueue(QList<qint32>,QList<quint32>)));
+    connect(PlayQueueModel::self(), SIGNAL(searchResultsUpdated()), &playQueueProxyModel, SLOT(invalidate()));
     connect(MPDConnection::self(), SIGNAL(currentSongUpdated(Song)), this, SLOT(updateCurrentSong(Song)));
     connect(MPDConnection::self(), SIGNAL(stateChanged(bool)), SLOT(mpdConnectionStateChanged(bool)));
     connect(MPDConnection::self(), SIGNAL(error(const QString &, bool)), SLOT(showError(const QString &, bool)));
@@ -1009,6 +1025,7 @@ MainWindow::~MainWindow()
     Covers::self()->cleanCdda();
     #endif
     #endif
+    Covers::self()->saveNoCovers();
     MediaKeys::self()->stop();
     #ifdef TAGLIB_FOUND
     Tags::stop();
@@ -1858,6 +1875,7 @@ void MainWindow::realSearchPlayQueue()
     if (filter!=playQueueProxyModel.filterText()) {
         playQueue->setFilterActive(!filter.isEmpty());
         playQueue->clearSelection();
+        PlayQueueModel::self()->search(filter);
         playQueueProxyModel.update(filter);
         QModelIndex idx=playQueueProxyModel.mapFromSource(PlayQueueModel::self()->index(PlayQueueModel::self()->currentSongRow(), 0));
         playQueue->updateRows(idx.row(), current.key, autoScrollPlayQueue && playQueueProxyModel.isEmpty() && MPDState_Playing==MPDStatus::self()->state());
@@ -1874,35 +1892,54 @@ void MainWindow::playQueueSearchActivated(bool a)
 
 void MainWindow::updatePlayQueue(const QList<Song> &songs, bool isComplete)
 {
-    StdActions::self()->playPauseTrackAction->setEnabled(!songs.isEmpty());
-    StdActions::self()->nextTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && !songs.isEmpty() && MPDStatus::self()->nextSongId()!=-1);
-    StdActions::self()->prevTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && !songs.isEmpty() && (songs.count()>1 || current.time>5));
-    StdActions::self()->savePlayQueueAction->setEnabled(!songs.isEmpty());
-    clearPlayQueueAction->setEnabled(!songs.isEmpty());
+    int topRow=prePlayQueueUpdate(songs.count());
+    bool wasEmpty=0==PlayQueueModel::self()->rowCount();
+    PlayQueueModel::self()->update(songs, isComplete);
+    postPlayQueueUpdate(songs.count(), topRow, wasEmpty);
+}
+
+void MainWindow::updatePagedPlayQueue(const QList<qint32> &ids, const QList<quint32> &times)
+{
+    int topRow=prePlayQueueUpdate(ids.count());
+    bool wasEmpty=0==PlayQueueModel::self()->rowCount();
+    PlayQueueModel::self()->updatePaged(ids, times);
+    postPlayQueueUpdate(ids.count(), topRow, wasEmpty);
+}
+
+int MainWindow::prePlayQueueUpdate(int count)
+{
+    StdActions::self()->playPauseTrackAction->setEnabled(count>0);
+    StdActions::self()->nextTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && count>0 && MPDStatus::self()->nextSongId()!=-1);
+    StdActions::self()->prevTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && count>0 && (count>1 || current.time>5));
+    StdActions::self()->savePlayQueueAction->setEnabled(count>0);
+    clearPlayQueueAction->setEnabled(count>0);
 
     int topRow=-1;
     QModelIndex topIndex=PlayQueueModel::self()->lastCommandWasUnodOrRedo() ? playQueue->indexAt(QPoint(0, 0)) : QModelIndex();
     if (topIndex.isValid()) {
         topRow=playQueueProxyModel.mapToSource(topIndex).row();
     }
-    bool wasEmpty=0==PlayQueueModel::self()->rowCount();
-    bool songChanged=false;
+    return topRow;
+}
 
-    PlayQueueModel::self()->update(songs, isComplete);
+void MainWindow::postPlayQueueUpdate(int count, int topRow, bool wasEmpty)
+{
+    bool songChanged=false;
 
-    if (songs.isEmpty()) {
+    if (0==count) {
         updateCurrentSong(Song(), wasEmpty);
     } else {
         // Check to see if it has been updated...
         Song pqSong=PlayQueueModel::self()->getSongByRow(PlayQueueModel::self()->currentSongRow());
-        if (wasEmpty || pqSong.isDifferent(current) ) {
+        // In paged mode, the song details may not have been retrieved yet
+        if ((wasEmpty || pqSong.isDifferent(current)) && !(PlayQueueModel::self()->isPaged() && pqSong.file.isEmpty())) {
             updateCurrentSong(pqSong, wasEmpty);
             songChanged=true;
         }
     }
 
     if (songChanged) {
-        StdActions::self()->prevTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && !songs.isEmpty() && (songs.count()>1 || current.time>5));
+        StdActions::self()->prevTrackAction->setEnabled(StdActions::self()->stopPlaybackAction->isEnabled() && count>0 && (count>1 || current.time>5));
     }
 
     QModelIndex idx=playQueueProxyModel.mapFromSource(PlayQueueModel::self()->index(PlayQueueModel::self()->currentSongRow(), 0));
@@ -1952,6 +1989,10 @@ void MainWindow::updateCurrentSong(Song song, bool wasEmpty)
     bool diffSong=song.isDifferent(current);
     current=song;
 
+    QElapsedTimer timer;
+    if (debugEnabled) {
+        timer.start();
+    }
     CurrentCover::self()->update(current);
     if (current.time<5 && MPDStatus::self()->songId()==current.id && MPDStatus::self()->timeTotal()>5) {
         current.time=MPDStatus::self()->timeTotal();
@@ -1963,26 +2004,47 @@ void MainWindow::updateCurrentSong(Song song, bool wasEmpty)
     QModelIndex idx=playQueueProxyModel.mapFromSource(PlayQueueModel::self()->index(PlayQueueModel::self()->currentSongRow(), 0));
     playQueue->updateRows(idx.row(), current.key, autoScrollPlayQueue && playQueueProxyModel.isEmpty() && isPlaying, wasEmpty);
     scrollPlayQueue(wasEmpty);
+    DBUG << "now playing, and play queue" << timer.elapsed() << "ms";
     if (diffSong) {
-        #ifdef QT_QTDBUS_FOUND
-        if (mpris) {
-            mpris->updateCurrentSong(current);
+        // Consumers that are not needed for the next paint are updated later, so that
+        // rapid skips only cause one update.
+        if (!songChangeTimer) {
+            songChangeTimer=new QTimer(this);
+            songChangeTimer->setSingleShot(true);
+            connect(songChangeTimer, SIGNAL(timeout()), this, SLOT(notifySongChange()));
         }
-        #endif
-        #ifdef Q_OS_WIN
-        if (thumbnailTooolbar) {
-            thumbnailTooolbar->updateCurrentSong(current);
-        }
-        #endif
-        #ifdef MAC_MEDIAPLAYER_FOUND
-        macNowPlaying->updateCurrentSong(current);
-        #endif
-        context->update(current);
-        trayItem->songChanged(song, isPlaying);
+        songChangeTimer->start(constSongChangeDelay);
     }
     centerPlayQueueAction->setEnabled(!song.isEmpty());
 }
 
+void MainWindow::notifySongChange()
+{
+    bool isPlaying=MPDState_Playing==MPDStatus::self()->state();
+    QElapsedTimer timer;
+    if (debugEnabled) {
+        timer.start();
+    }
+    #ifdef QT_QTDBUS_FOUND
+    if (mpris) {
+        mpris->updateCurrentSong(current);
+        DBUG << "mpris" << timer.restart() << "ms";
+    }
+    #endif
+    #ifdef Q_OS_WIN
+    if (thumbnailTooolbar) {
+        thumbnailTooolbar->updateCurrentSong(current);
+    }
+    #endif
+    #ifdef MAC_MEDIAPLAYER_FOUND
+    macNowPlaying->updateCurrentSong(current);
+    #endif
+    context->update(current);
+    DBUG << "context" << timer.restart() << "ms";
+    trayItem->songChanged(current, isPlaying);
+    DBUG << "tray" << timer.restart() << "ms";
+}
+
 void MainWindow::scrollPlayQueue(bool wasEmpty)
 {
     if (autoScrollPlayQueue && (wasEmpty || MPDState_Playing==MPDStatus::self()->state()) && !playQueue->isGrouped()) {
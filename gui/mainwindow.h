@@ -111,6 +111,8 @@ public:
         PAGE_CONTEXT
     };
 
+    static void enableDebug();
+
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
@@ -189,6 +191,7 @@ public Q_SLOTS:
     void realSearchPlayQueue();
     void playQueueSearchActivated(bool a);
     void updatePlayQueue(const QList<Song> &songs, bool isComplete);
+    void updatePagedPlayQueue(const QList<qint32> &ids, const QList<quint32> &times);
     void updateCurrentSong(Song song, bool wasEmpty=false);
     void scrollPlayQueue(bool wasEmpty=false);
     void updateStatus();
@@ -274,10 +277,13 @@ private:
     int calcCollapsedSize();
     void setCollapsedSize();
     void controlView(bool forceUpdate=false);
+    int prePlayQueueUpdate(int count);
+    void postPlayQueueUpdate(int count, int topRow, bool wasEmpty);
 
 private Q_SLOTS:
     void controlPlayQueueButtons();
     void toggleContext();
+    void notifySongChange();
     void initMpris();
     void toggleMenubar();
     void paletteChanged();
@@ -370,6 +376,7 @@ private:
     #endif
     QTimer *contextTimer;
     int contextSwitchTime;
+    QTimer *songChangeTimer;
     enum { CS_Init, CS_Connected, CS_Disconnected } connectedState;
     bool stopAfterCurrent;
     bool responsiveSidebar;
@@ -550,6 +550,11 @@ int Settings::paranoiaOffset()
 {
     return cfg.get("paranoiaOffset", 0);
 }
+
+int Settings::cdCacheDays()
+{
+    return cfg.get("cdCacheDays", 30, 0, 365);
+}
 #endif
 
 #if defined CDDB_FOUND && defined MUSICBRAINZ5_FOUND
@@ -1045,6 +1050,11 @@ void Settings::saveParanoiaOffset(int v)
 {
     cfg.set("paranoiaOffset", v);
 }
+
+void Settings::saveCdCacheDays(int v)
+{
+    cfg.set("cdCacheDays", v);
+}
 #endif
 
 #if defined CDDB_FOUND && defined MUSICBRAINZ5_FOUND
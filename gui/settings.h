@@ -111,6 +111,7 @@ public:
     bool paranoiaFull();
     bool paranoiaNeverSkip();
     int paranoiaOffset();
+    int cdCacheDays();
     #endif
     #if defined CDDB_FOUND && defined MUSICBRAINZ5_FOUND
     bool useCddb();
@@ -217,6 +218,7 @@ public:
     void saveParanoiaFull(bool v);
     void saveParanoiaNeverSkip(bool v);
     void saveParanoiaOffset(int v);
+    void saveCdCacheDays(int v);
     #endif
     #if defined CDDB_FOUND && defined MUSICBRAINZ5_FOUND
     void saveUseCddb(bool v);
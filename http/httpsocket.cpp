@@ -28,6 +28,10 @@
 #if defined CDDB_FOUND || defined MUSICBRAINZ5_FOUND
 #include "devices/cdparanoia.h"
 #include "devices/extractjob.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
 #endif
 #include <QTcpSocket>
 #include <QStringList>
@@ -42,6 +46,72 @@
 
 static const quint64 constMaxBuffer = 32768;
 
+#if defined CDDB_FOUND || defined MUSICBRAINZ5_FOUND
+// Reads CD sectors on a separate thread, so that paranoia retries and drive spin-ups are
+// absorbed by the buffered sectors - rather than stalling the stream to MPD.
+class CdReadAhead : public QThread
+{
+public:
+    static const int constMaxSectors = 75*10; // 10 seconds of audio
+
+    CdReadAhead(CdParanoia &p, int first, int last)
+        : paranoia(p), firstSector(first), lastSector(last), stopped(false), finished(false) { }
+    ~CdReadAhead() override {
+        stop();
+        wait();
+    }
+
+    void stop() {
+        QMutexLocker locker(&mutex);
+        stopped=true;
+        notFull.wakeAll();
+    }
+
+    // Returns the next sector, or an empty array at the end of the track (or upon a read error)
+    QByteArray next() {
+        QMutexLocker locker(&mutex);
+        while (sectors.isEmpty() && !finished) {
+            notEmpty.wait(&mutex);
+        }
+        if (sectors.isEmpty()) {
+            return QByteArray();
+        }
+        notFull.wakeOne();
+        return sectors.dequeue();
+    }
+
+protected:
+    void run() override {
+        for (int sector=firstSector; sector<=lastSector; ++sector) {
+            qint16 *buf = paranoia.read();
+            QMutexLocker locker(&mutex);
+            while (buf && !stopped && sectors.count()>=constMaxSectors) {
+                notFull.wait(&mutex);
+            }
+            if (!buf || stopped) {
+                break;
+            }
+            sectors.enqueue(QByteArray((const char *)buf, CD_FRAMESIZE_RAW));
+            notEmpty.wakeOne();
+        }
+        QMutexLocker locker(&mutex);
+        finished=true;
+        notEmpty.wakeAll();
+    }
+
+private:
+    CdParanoia &paranoia;
+    int firstSector;
+    int lastSector;
+    bool stopped;
+    bool finished;
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<QByteArray> sectors;
+};
+#endif
+
 static QString detectMimeType(const QString &file)
 {
     QString suffix = QFileInfo(file).suffix().toLower();
@@ -298,7 +368,6 @@ void HttpSocket::readClient()
                             int firstSector = cdparanoia.firstSectorOfTrack(song.id);
                             int lastSector = cdparanoia.lastSectorOfTrack(song.id);
                             qint32 totalSize = ((lastSector-firstSector)+1)*CD_FRAMESIZE_RAW;
-                            int count = 0;
                             bool writeHeader=0==readBytesFrom; // Only write header if we are not seeking...
 //                            int bytesToDiscard = 0; // Number of bytes to discard in first read sector due to range request in HTTP header
 //                            if (readBytesFrom>=ExtractJob::constWavHeaderSize) {
@@ -317,14 +386,16 @@ void HttpSocket::readClient()
                                 ExtractJob::writeWavHeader(*socket, totalSize);
                             }
                             bool stop=false;
-                            while (!terminated && (firstSector+count) <= lastSector && !stop) {
-                                qint16 *buf = cdparanoia.read();
-                                if (!buf) {
+                            CdReadAhead reader(cdparanoia, firstSector, lastSector);
+                            reader.start();
+                            while (!terminated && !stop) {
+                                QByteArray sector = reader.next();
+                                if (sector.isEmpty()) {
                                     break;
                                 }
-                                char *buffer=(char *)buf;
+                                char *buffer=sector.data();
                                 qint32 writePos=0;
-                                qint32 toWrite=CD_FRAMESIZE_RAW;
+                                qint32 toWrite=sector.size();
 
 //                                if (bytesToDiscard>0) {
 //                                    int toSkip=qMin(toWrite, bytesToDiscard);
@@ -336,7 +407,6 @@ void HttpSocket::readClient()
                                 if (toWrite>0 && !write(socket, &buffer[writePos], toWrite, stop)) {
                                     break;
                                 }
-                                count++;
                             }
                         }
                     }
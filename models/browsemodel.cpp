@@ -24,10 +24,10 @@
 #include "browsemodel.h"
 #include "roles.h"
 #include "playqueuemodel.h"
+#include "mpdlibrarymodel.h"
 #include "widgets/icons.h"
 #include "gui/settings.h"
 #include "mpd-interface/mpdconnection.h"
-#include "mpd-interface/mpdstats.h"
 #include "support/monoicon.h"
 #include "support/utils.h"
 #include <QMimeData>
@@ -59,7 +59,6 @@ BrowseModel::BrowseModel(QObject *p)
     : ActionModel(p)
     , root(new FolderItem("/", nullptr))
     , enabled(false)
-    , dbVersion(0)
 {
     icn=MonoIcon::icon(FontAwesome::server, Utils::monoIconColor());
     connect(this, SIGNAL(listFolder(QString)), MPDConnection::self(), SLOT(listFolder(QString)));
@@ -109,11 +108,11 @@ void BrowseModel::setEnabled(bool e)
     if (enabled) {
         connect(MPDConnection::self(), SIGNAL(folderContents(QString,QStringList,QList<Song>)), this, SLOT(folderContents(QString,QStringList,QList<Song>)));
         connect(MPDConnection::self(), SIGNAL(connectionChanged(MPDConnectionDetails)), this, SLOT(connectionChanged()));
-        connect(MPDConnection::self(), SIGNAL(statsUpdated(MPDStatsValues)), this, SLOT(statsUpdated(MPDStatsValues)));
+        connect(MpdLibraryModel::self(), SIGNAL(libraryChanged(LibraryDb::Changes)), this, SLOT(libraryChanged(LibraryDb::Changes)));
     } else {
         disconnect(MPDConnection::self(), SIGNAL(folderContents(QString,QStringList,QList<Song>)), this, SLOT(folderContents(QString,QStringList,QList<Song>)));
         disconnect(MPDConnection::self(), SIGNAL(connectionChanged(MPDConnectionDetails)), this, SLOT(connectionChanged()));
-        disconnect(MPDConnection::self(), SIGNAL(statsUpdated(MPDStatsValues)), this, SLOT(statsUpdated(MPDStatsValues)));
+        disconnect(MpdLibraryModel::self(), SIGNAL(libraryChanged(LibraryDb::Changes)), this, SLOT(libraryChanged(LibraryDb::Changes)));
         clear();
     }
 }
@@ -292,20 +291,121 @@ void BrowseModel::connectionChanged()
 {
     clear();
     if (!root->isFetching() && MPDConnection::self()->isConnected()) {
-        dbVersion=0;
         root->setState(FolderItem::State_Fetching);
         emit listFolder(root->getPath());
     }
 }
 
-void BrowseModel::statsUpdated(const MPDStatsValues &stats)
+static inline QString folderOf(const QString &path)
 {
-    if (stats.dbUpdate!=dbVersion) {
-        if (0!=dbVersion) {
+    int pos=path.lastIndexOf(Utils::constDirSep);
+    return pos<0 ? QString() : path.left(pos);
+}
+
+void BrowseModel::libraryChanged(const LibraryDb::Changes &changes)
+{
+    if (!changes.complete) {
+        // Don't know what has changed, so must re-read everything that has been listed.
+        if (root->getChildCount()) {
             connectionChanged();
         }
-        dbVersion=stats.dbUpdate;
+        return;
+    }
+
+    // Folders that gain files are re-listed, as are the parents of those that lose them - as the
+    // folder itself may have been removed. Folders not yet listed will be read when expanded.
+    QSet<FolderItem *> toList;
+    for (const QString &file: changes.added) {
+        toList.insert(listedFolder(folderOf(file)));
+    }
+    for (const QString &file: changes.removed) {
+        toList.insert(listedFolder(folderOf(folderOf(file))));
+    }
+
+    // Don't re-list a folder if one of its parents is being re-listed.
+    QList<FolderItem *> folders;
+    for (FolderItem *folder: toList) {
+        bool parentListed=false;
+        for (FolderItem *p=folder->getParent(); p && !parentListed; p=p->getParent()) {
+            parentListed=toList.contains(p);
+        }
+        if (!parentListed) {
+            folders.append(folder);
+        }
+    }
+    for (FolderItem *folder: folders) {
+        relist(folder);
+    }
+
+    // Update details of modified tracks, in folders that are listed and not being re-listed.
+    QMap<QString, FolderItem *>::ConstIterator end=folderIndex.constEnd();
+    QMap<QString, Song> modified;
+    for (const QString &file: changes.modified) {
+        QMap<QString, FolderItem *>::ConstIterator it=folderIndex.constFind(folderOf(file));
+        FolderItem *folder=it==end ? (folderOf(file).isEmpty() ? root : nullptr) : it.value();
+        if (folder && !folder->isFetching() && folder->getChildCount()) {
+            modified.insert(file, Song());
+        }
+    }
+    if (modified.isEmpty()) {
+        return;
+    }
+    for (const Song &song: MpdLibraryModel::self()->songs(modified.keys(), true)) {
+        modified[song.file]=song;
+    }
+    for (QMap<QString, Song>::ConstIterator mIt=modified.constBegin(); mIt!=modified.constEnd(); ++mIt) {
+        if (mIt.value().file.isEmpty()) {
+            continue;
+        }
+        QMap<QString, FolderItem *>::ConstIterator it=folderIndex.constFind(folderOf(mIt.key()));
+        FolderItem *folder=it==end ? root : it.value();
+        for (Item *item: folder->getChildren()) {
+            if (!item->isFolder() && static_cast<TrackItem *>(item)->getSong().file==mIt.key()) {
+                static_cast<TrackItem *>(item)->setSong(mIt.value());
+                QModelIndex idx=createIndex(item->getRow(), 0, item);
+                emit dataChanged(idx, idx);
+                break;
+            }
+        }
+    }
+}
+
+// Nearest folder, from path upwards, that is in the model.
+BrowseModel::FolderItem * BrowseModel::listedFolder(QString path) const
+{
+    while (!path.isEmpty()) {
+        QMap<QString, FolderItem *>::ConstIterator it=folderIndex.constFind(path);
+        if (it!=folderIndex.constEnd()) {
+            return it.value();
+        }
+        path=folderOf(path);
+    }
+    return root;
+}
+
+void BrowseModel::relist(FolderItem *folder)
+{
+    if (folder->canFetchMore() || folder->isFetching()) {
+        // Not yet listed, or being listed
+        return;
+    }
+
+    if (folder->getChildCount()) {
+        QString prefix=folder==root ? QString() : (folder->getPath()+Utils::constDirSep);
+        QMap<QString, FolderItem *>::Iterator it=folderIndex.begin();
+        while (it!=folderIndex.end()) {
+            if (it.value()!=root && it.key().startsWith(prefix) && it.value()!=folder) {
+                it=folderIndex.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        beginRemoveRows(folder==root ? QModelIndex() : createIndex(folder->getRow(), 0, folder), 0, folder->getChildCount()-1);
+        folder->clear();
+        endRemoveRows();
     }
+    folder->setState(FolderItem::State_Fetching);
+    emit listFolder(folder->getPath());
 }
 
 void BrowseModel::folderContents(const QString &path, const QStringList &folders, const QList<Song> &songs)
@@ -28,10 +28,9 @@
 #include "mpd-interface/song.h"
 #include "support/utils.h"
 #include "support/icon.h"
+#include "db/librarydb.h"
 #include <QMap>
 
-struct MPDStatsValues;
-
 class BrowseModel : public ActionModel
 {
     Q_OBJECT
@@ -70,6 +69,7 @@ public:
         QString getText() const override { return song.trackAndTitleStr(); }
         QString getSubText() const override { return Song::Playlist==song.type || 0==song.time ? QString() : Utils::formatTime(song.time, true); }
         const Song & getSong() const { return song; }
+        void setSong(const Song &s) { song=s; }
 
     private:
         Song song;
@@ -135,18 +135,19 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void connectionChanged();
-    void statsUpdated(const MPDStatsValues &stats);
+    void libraryChanged(const LibraryDb::Changes &changes);
     void folderContents(const QString &path, const QStringList &folders, const QList<Song> &songs);
 
 private:
     Item * toItem(const QModelIndex &index) const { return index.isValid() ? static_cast<Item*>(index.internalPointer()) : root; }
+    FolderItem * listedFolder(QString path) const;
+    void relist(FolderItem *folder);
 
 private:
     QIcon icn;
     FolderItem *root;
     QMap<QString, FolderItem *> folderIndex;
     bool enabled;
-    time_t dbVersion;
 };
 
 #endif
@@ -206,45 +206,11 @@ void MpdLibraryModel::listNextChunk()
 
 void MpdLibraryModel::cover(const Song &song, const QImage &img, const QString &file)
 {
-    if (file.isEmpty() || img.isNull() || song.isFromOnlineService()) {
+    if (file.isEmpty() || img.isNull() || song.isFromOnlineService() || !root) {
         return;
     }
-    switch(topLevel()) {
-    case T_Genre: {
-        const Item *genre=root ? root->getChild(song.genres[0]) : nullptr;
-        if (genre) {
-            const Item *artist=static_cast<const CollectionItem *>(genre)->getChild(song.albumArtistOrComposer());
-            if (artist) {
-                const Item *album=static_cast<const CollectionItem *>(artist)->getChild(song.albumId());
-                if (album) {
-                    QModelIndex idx=index(album->getRow(), 0, index(artist->getRow(), 0, index(genre->getRow(), 0, QModelIndex())));
-                    emit dataChanged(idx, idx);
-                }
-            }
-        }
-        break;
-    }
-    case T_Artist: {
-        const Item *artist=root ? root->getChild(song.albumArtistOrComposer()) : nullptr;
-        if (artist) {
-            const Item *album=static_cast<const CollectionItem *>(artist)->getChild(song.albumId());
-            if (album) {
-                QModelIndex idx=index(album->getRow(), 0, index(artist->getRow(), 0, QModelIndex()));
-                emit dataChanged(idx, idx);
-            }
-        }
-        break;
-    }
-    case T_Album: {
-        const Item *album=root ? root->getChild(song.albumArtistOrComposer()+song.albumId()) : nullptr;
-        if (album) {
-            QModelIndex idx=index(album->getRow(), 0, QModelIndex());
-            emit dataChanged(idx, idx);
-        }
-        break;
-    }
-    default:
-        break;
+    for (Item *album: albumItems(song.albumArtistOrComposer(), song.albumId())) {
+        queueDataChanged(album);
     }
 }
 
@@ -258,31 +224,11 @@ void MpdLibraryModel::coverUpdated(const Song &song, const QImage &img, const QS
 
 void MpdLibraryModel::artistImage(const Song &song, const QImage &img, const QString &file)
 {
-    if (file.isEmpty() || img.isNull() || T_Album==topLevel()) {
+    if (file.isEmpty() || img.isNull() || T_Album==topLevel() || !root) {
         return;
     }
-    switch(topLevel()) {
-    case T_Genre: {
-        const Item *genre=root ? root->getChild(song.genres[0]) : nullptr;
-        if (genre) {
-            const Item *artist=static_cast<const CollectionItem *>(genre)->getChild(song.albumArtistOrComposer());
-            if (artist) {
-                QModelIndex idx=index(artist->getRow(), 0, index(genre->getRow(), 0, QModelIndex()));
-                emit dataChanged(idx, idx);
-            }
-        }
-        break;
-    }
-    case T_Artist: {
-        const Item *artist=root ? root->getChild(song.albumArtistOrComposer()) : nullptr;
-        if (artist) {
-            QModelIndex idx=index(artist->getRow(), 0, QModelIndex());
-            emit dataChanged(idx, idx);
-        }
-        break;
-    }
-    default:
-        break;
+    for (Item *artist: artistItems(song.albumArtistOrComposer())) {
+        queueDataChanged(artist);
     }
 }
 
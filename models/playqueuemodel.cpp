@@ -84,6 +84,9 @@ static const QLatin1String constSortByTitleKey("title");
 static const QLatin1String constSortByNumberKey("track");
 static const QLatin1String constSortByPathKey("path");
 
+// Number of fully populated songs to keep when in paged mode.
+static const int constPagedCacheSize=MPDConnection::constPlayQueuePageSize*8;
+
 static QSet<QString> constM3uPlaylists = QSet<QString>() << QLatin1String("m3u") << QLatin1String("m3u8");
 static const QString constPlsPlaylist = QLatin1String("pls");
 static const QString constXspfPlaylist = QLatin1String("xspf");
@@ -401,7 +404,9 @@ PlayQueueModel::PlayQueueModel(QObject *parent)
     , undoEnabled(undoLimit>0)
     , lastCommand(Cmd_Other)
     , dropAdjust(0)
+    , paged(false)
 {
+    pagedSongs.setMaxCost(constPagedCacheSize);
     fetcher=new StreamFetcher(this);
     connect(this, SIGNAL(modelReset()), this, SLOT(stats()));
     connect(fetcher, SIGNAL(result(const QStringList &, int, int, quint8, bool)), SLOT(addFiles(const QStringList &, int, int, quint8, bool)));
@@ -425,6 +430,10 @@ PlayQueueModel::PlayQueueModel(QObject *parent)
     connect(this, SIGNAL(setRating(QStringList,quint8)), MPDConnection::self(), SLOT(setRating(QStringList,quint8)));
     connect(MPDConnection::self(), SIGNAL(rating(QString,quint8)), SLOT(ratingResult(QString,quint8)));
     connect(MPDConnection::self(), SIGNAL(stickerDbChanged()), SLOT(stickerDbChanged()));
+    connect(this, SIGNAL(fetchRange(quint32,quint32)), MPDConnection::self(), SLOT(playListRange(quint32,quint32)));
+    connect(MPDConnection::self(), SIGNAL(playlistRange(quint32,QList<Song>)), SLOT(rangeRetrieved(quint32,QList<Song>)));
+    connect(this, SIGNAL(searchPlayQueue(QString)), MPDConnection::self(), SLOT(playListSearch(QString)));
+    connect(MPDConnection::self(), SIGNAL(playlistSearchResults(QString,QList<Song>)), SLOT(searchResults(QString,QList<Song>)));
     #ifdef ENABLE_DEVICES_SUPPORT //TODO: Problems here with devices support!!!
     connect(DevicesModel::self(), SIGNAL(updatedDetails(QList<Song>)), SLOT(updateDetails(QList<Song>)));
     #endif
@@ -477,7 +486,10 @@ PlayQueueModel::~PlayQueueModel()
 
 QModelIndex PlayQueueModel::index(int row, int column, const QModelIndex &parent) const
 {
-    return hasIndex(row, column, parent) ? createIndex(row, column, (void *)&songs.at(row)) : QModelIndex();
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    return paged ? createIndex(row, column) : createIndex(row, column, (void *)&songs.at(row));
 }
 
 QModelIndex PlayQueueModel::parent(const QModelIndex &idx) const
@@ -541,7 +553,7 @@ bool PlayQueueModel::setHeaderData(int section, Qt::Orientation orientation, con
 
 int PlayQueueModel::rowCount(const QModelIndex &idx) const
 {
-    return idx.isValid() ? 0 : songs.size();
+    return idx.isValid() ? 0 : (paged ? pagedIds.count() : songs.size());
 }
 
 static QString basicPath(const Song &song)
@@ -565,21 +577,21 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
         return COL_RATING;
     }
 
-    if (!index.isValid() || index.row() >= songs.size()) {
+    if (!index.isValid() || index.row() >= rowCount()) {
         return QVariant();
     }
 
     switch (role) {
     case Cantata::Role_MainText: {
-        const Song &s=songs.at(index.row());
+        const Song &s=songAt(index.row());
         return s.title.isEmpty() ? s.file : s.trackAndTitleStr(false);
     }
     case Cantata::Role_SubText: {
-        const Song &s=songs.at(index.row());
+        const Song &s=songAt(index.row());
         return s.artist+Song::constSep+s.displayAlbum();
     }
     case Cantata::Role_Time: {
-        const Song &s=songs.at(index.row());
+        const Song &s=songAt(index.row());
         return s.time>0 ? Utils::formatTime(s.time) : QLatin1String("");
     }
     case Cantata::Role_IsCollection:
@@ -587,14 +599,14 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
     case Cantata::Role_CollectionId:
         return 0;
     case Cantata::Role_Key:
-        return songs.at(index.row()).key;
+        return songAt(index.row()).key;
     case Cantata::Role_Id:
-        return songs.at(index.row()).id;
+        return songAt(index.row()).id;
     case Cantata::Role_SongWithRating:
     case Cantata::Role_Song: {
         QVariant var;
-        const Song &s=songs.at(index.row());
-        if (Cantata::Role_SongWithRating==role && Song::Standard==s.type && Song::Rating_Null==s.rating) {
+        const Song &s=songAt(index.row());
+        if (Cantata::Role_SongWithRating==role && Song::Standard==s.type && Song::Rating_Null==s.rating && !s.file.isEmpty()) {
             emit getRating(s.file);
             s.rating=Song::Rating_Requested;
         }
@@ -602,40 +614,40 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
         return var;
     }
     case Cantata::Role_AlbumDuration: {
-        const Song &first = songs.at(index.row());
-        quint32 d=first.time;
-        for (int i=index.row()+1; i<songs.count(); ++i) {
-            const Song &song = songs.at(i);
-            if (song.key!=first.key) {
+        quint16 key=songAt(index.row()).key;
+        quint32 d=songAt(index.row()).time;
+        for (int i=index.row()+1; i<rowCount(); ++i) {
+            const Song *song=cachedSongAt(i);
+            if (!song || song->key!=key) {
                 break;
             }
-            d+=song.time;
+            d+=song->time;
         }
         if (index.row()>1) {
             for (int i=index.row()-1; i<=0; ++i) {
-                const Song &song = songs.at(i);
-                if (song.key!=first.key) {
+                const Song *song=cachedSongAt(i);
+                if (!song || song->key!=key) {
                     break;
                 }
-                d+=song.time;
+                d+=song->time;
             }
         }
         return d;
     }
     case Cantata::Role_SongCount: {
-        const Song &first = songs.at(index.row());
+        quint16 key=songAt(index.row()).key;
         quint32 count=1;
-        for (int i=index.row()+1; i<songs.count(); ++i) {
-            const Song &song = songs.at(i);
-            if (song.key!=first.key) {
+        for (int i=index.row()+1; i<rowCount(); ++i) {
+            const Song *song=cachedSongAt(i);
+            if (!song || song->key!=key) {
                 break;
             }
             count++;
         }
         if (index.row()>1) {
             for (int i=index.row()-1; i<=0; ++i) {
-                const Song &song = songs.at(i);
-                if (song.key!=first.key) {
+                const Song *song=cachedSongAt(i);
+                if (!song || song->key!=key) {
                     break;
                 }
                 count++;
@@ -644,27 +656,27 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
         return count;
     }
     case Cantata::Role_CurrentStatus: {
-        quint16 key=songs.at(index.row()).key;
-        for (int i=index.row()+1; i<songs.count(); ++i) {
-            const Song &s=songs.at(i);
-            if (s.key!=key) {
+        quint16 key=songAt(index.row()).key;
+        for (int i=index.row()+1; i<rowCount(); ++i) {
+            const Song *s=cachedSongAt(i);
+            if (!s || s->key!=key) {
                 return QVariant();
             }
-            if (s.id==currentSongId) {
+            if (s->id==currentSongId) {
                 switch (mpdState) {
                 case MPDState_Inactive:
                 case MPDState_Stopped: return (int)GroupedView::State_Stopped;
                 case MPDState_Playing: return (int)(stopAfterCurrent ? GroupedView::State_StopAfter : GroupedView::State_Playing);
                 case MPDState_Paused:  return (int)GroupedView::State_Paused;
                 }
-            }  else if (-1!=s.id && s.id==stopAfterTrackId) {
+            }  else if (-1!=s->id && s->id==stopAfterTrackId) {
                 return GroupedView::State_StopAfterTrack;
             }
         }
         return QVariant();
     }
     case Cantata::Role_Status: {
-        qint32 id=songs.at(index.row()).id;
+        qint32 id=songAt(index.row()).id;
         if (id==currentSongId) {
             switch (mpdState) {
             case MPDState_Inactive:
@@ -679,17 +691,17 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
         break;
     }
     case Qt::FontRole: {
-        Song s=songs.at(index.row());
+        const Song &s=songAt(index.row());
 
         if (s.isStream()) {
             QFont font;
-            if (songs.at(index.row()).id == currentSongId) {
+            if (s.id == currentSongId) {
                 font.setBold(true);
             }
             font.setItalic(true);
             return font;
         }
-        else if (songs.at(index.row()).id == currentSongId) {
+        else if (s.id == currentSongId) {
             QFont font;
             font.setBold(true);
             return font;
@@ -704,7 +716,7 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
 //         }
 //         break;
     case Qt::DisplayRole: {
-        const Song &song = songs.at(index.row());
+        const Song &song = songAt(index.row());
         switch (index.column()) {
         case COL_TITLE:
             return song.title.isEmpty() ? Utils::getFile(basicPath(song)) : song.title;
@@ -773,7 +785,7 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
         if (!Settings::self()->infoTooltips()) {
             return QVariant();
         }
-        Song s=songs.at(index.row());
+        Song s=songAt(index.row());
         if (s.album.isEmpty() && s.isStream()) {
             return basicPath(s);
         } else {
@@ -783,7 +795,7 @@ QVariant PlayQueueModel::data(const QModelIndex &index, int role) const
     case Qt::TextAlignmentRole:
         return alignments[index.column()];
     case Cantata::Role_Decoration: {
-        qint32 id=songs.at(index.row()).id;
+        qint32 id=songAt(index.row()).id;
         if (id==currentSongId) {
             switch (mpdState) {
             case MPDState_Inactive:
@@ -849,7 +861,7 @@ QMimeData *PlayQueueModel::mimeData(const QModelIndexList &indexes) const
     for (const QModelIndex &index: indexes) {
         if (index.isValid() && 0==index.column()) {
             positions.append(index.row());
-            filenames.append(static_cast<Song *>(index.internalPointer())->file);
+            filenames.append(songAt(index.row()).file);
         }
     }
 
@@ -879,9 +891,9 @@ bool PlayQueueModel::dropMimeData(const QMimeData *data,
     row+=dropAdjust;
     if (data->hasFormat(constMoveMimeType)) { //Act on internal moves
         if (row < 0) {
-            emit move(decodeInts(*data, constMoveMimeType), songs.size(), songs.size());
+            emit move(decodeInts(*data, constMoveMimeType), rowCount(), rowCount());
         } else {
-            emit move(decodeInts(*data, constMoveMimeType), row, songs.size());
+            emit move(decodeInts(*data, constMoveMimeType), row, rowCount());
         }
         return true;
     } else if (data->hasFormat(constFileNameMimeType)) {
@@ -901,11 +913,11 @@ bool PlayQueueModel::dropMimeData(const QMimeData *data,
 void PlayQueueModel::load(const QStringList &urls, int action, quint8 priority, bool decreasePriority)
 {
     if (-1==action) {
-        action = songs.isEmpty() ? MPDConnection::AppendAndPlay : MPDConnection::Append;
+        action = 0==rowCount() ? MPDConnection::AppendAndPlay : MPDConnection::Append;
     }
     QStringList useable=parseUrls(urls);
     if (useable.count()) {
-        addItems(useable, songs.count(), action, priority, decreasePriority);
+        addItems(useable, rowCount(), action, priority, decreasePriority);
     }
 }
 
@@ -933,17 +945,32 @@ void PlayQueueModel::addFiles(const QStringList &filenames, int row, int action,
 {
     if (MPDConnection::ReplaceAndplay==action) {
         emit filesAdded(filenames, 0, 0, MPDConnection::ReplaceAndplay, priority, decreasePriority);
-    } else if (songs.isEmpty()) {
+    } else if (0==rowCount()) {
          emit filesAdded(filenames, 0, 0, action, priority, decreasePriority);
     } else if (row < 0) {
-        emit filesAdded(filenames, songs.size(), songs.size(), action, priority, decreasePriority);
+        emit filesAdded(filenames, rowCount(), rowCount(), action, priority, decreasePriority);
     } else {
-        emit filesAdded(filenames, row, songs.size(), action, priority, decreasePriority);
+        emit filesAdded(filenames, row, rowCount(), action, priority, decreasePriority);
     }
 }
 
 void PlayQueueModel::prioritySet(const QMap<qint32, quint8> &prio)
 {
+    if (paged) {
+        QMap<qint32, quint8>::ConstIterator it=prio.constBegin();
+        QMap<qint32, quint8>::ConstIterator end=prio.constEnd();
+        for (; it!=end; ++it) {
+            Song *song=pagedSongs.object(it.key());
+            int row=song ? getRowById(it.key()) : -1;
+            if (-1!=row) {
+                song->priority=it.value();
+                QModelIndex idx(index(row, 0));
+                emit dataChanged(idx, idx);
+            }
+        }
+        return;
+    }
+
     QList<Song> prev;
     if (undoEnabled) {
         for (const Song &s: songs) {
@@ -972,7 +999,10 @@ void PlayQueueModel::prioritySet(const QMap<qint32, quint8> &prio)
 
 qint32 PlayQueueModel::getIdByRow(qint32 row) const
 {
-    return row>=songs.size() ? -1 : songs.at(row).id;
+    if (row<0 || row>=rowCount()) {
+        return -1;
+    }
+    return paged ? pagedIds.at(row) : songs.at(row).id;
 }
 
 qint32 PlayQueueModel::getSongId(const QString &file) const
@@ -997,12 +1027,26 @@ qint32 PlayQueueModel::getSongId(const QString &file) const
                 return s.id;
             }
         }
+        if (paged) {
+            for (qint32 id: pagedSongs.keys()) {
+                if (pagedSongs.object(id)->sameMetadata(check)) {
+                    return id;
+                }
+            }
+        }
     } else {
         for (const Song &s: songs) {
             if (s.file==file) {
                 return s.id;
             }
         }
+        if (paged) {
+            for (qint32 id: pagedSongs.keys()) {
+                if (pagedSongs.object(id)->file==file) {
+                    return id;
+                }
+            }
+        }
     }
 
     return -1;
@@ -1015,6 +1059,16 @@ qint32 PlayQueueModel::getSongId(const QString &file) const
 
 qint32 PlayQueueModel::getRowById(qint32 id) const
 {
+    if (paged) {
+        // Called for each changed row during updates, so use a lookup built once per change of ids
+        if (pagedRows.isEmpty() && !pagedIds.isEmpty()) {
+            pagedRows.reserve(pagedIds.count());
+            for (int i=0; i<pagedIds.count(); ++i) {
+                pagedRows.insert(pagedIds.at(i), i);
+            }
+        }
+        return pagedRows.value(id, -1);
+    }
     for (int i = 0; i < songs.size(); i++) {
         if (songs.at(i).id == id) {
             return i;
@@ -1026,11 +1080,15 @@ qint32 PlayQueueModel::getRowById(qint32 id) const
 
 Song PlayQueueModel::getSongByRow(const qint32 row) const
 {
-    return row<0 || row>=songs.size() ? Song() : songs.at(row);
+    return row<0 || row>=rowCount() ? Song() : songAt(row);
 }
 
 Song PlayQueueModel::getSongById(qint32 id) const
 {
+    if (paged) {
+        Song *song=pagedSongs.object(id);
+        return song ? *song : Song();
+    }
     for (const Song &s: songs) {
         if (s.id==id) {
             return s;
@@ -1050,8 +1108,9 @@ void PlayQueueModel::updateCurrentSong(quint32 id)
     }
 
     currentSongRowNum=getRowById(currentSongId);
-    if (currentSongRowNum>=0 && currentSongRowNum<=songs.count()) {
-        const Song &song=songs.at(currentSongRowNum);
+    // In paged mode the current song may not have been retrieved yet
+    if (currentSongRowNum>=0 && currentSongRowNum<rowCount() && !songAt(currentSongRowNum).file.isEmpty()) {
+        const Song &song=songAt(currentSongRowNum);
         if (Song::Rating_Null==song.rating) {
             song.rating=Song::Rating_Requested;
             emit getRating(song.file);
@@ -1072,6 +1131,8 @@ void PlayQueueModel::clear()
     beginResetModel();
     songs.clear();
     ids.clear();
+    paged=false;
+    clearPaged();
     currentSongId=-1;
     currentSongRowNum=0;
     stopAfterTrackId=-1;
@@ -1129,6 +1190,8 @@ void PlayQueueModel::update(const QList<Song> &songList, bool isComplete)
         beginResetModel();
         songs=songList;
         ids=newIds;
+        paged=false;
+        clearPaged();
         endResetModel();
         if (songList.isEmpty()) {
             stopAfterTrackId=-1;
@@ -1145,13 +1208,14 @@ void PlayQueueModel::update(const QList<Song> &songList, bool isComplete)
                 endRemoveRows();
             }
         }
+        // Songs are only copied when they need to be modified - otherwise the data
+        // shared with the MPD thread's list is used as is.
         for (qint32 i=0; i<songList.count(); ++i) {
-            Song s=songList.at(i);
+            const Song &s=songList.at(i);
             bool newSong=i>=songs.count();
-            Song currentSongAtPos=newSong ? Song() : songs.at(i);
             bool isEmpty=s.isEmpty();
 
-            if (newSong || s.id!=currentSongAtPos.id) {
+            if (newSong || s.id!=songs.at(i).id) {
                 qint32 existingPos=newSong ? -1 : getRowById(s.id);
                 if (-1==existingPos) {
                     beginInsertRows(QModelIndex(), i, i);
@@ -1160,26 +1224,34 @@ void PlayQueueModel::update(const QList<Song> &songList, bool isComplete)
                 } else {
                     beginMoveRows(QModelIndex(), existingPos, existingPos, QModelIndex(), i>existingPos ? i+1 : i);
                     Song old=songs.takeAt(existingPos);
-//                     old.pos=s.pos;
-                    s.rating=old.rating;
-                    songs.insert(i, isEmpty ? old : s);
+                    if (isEmpty) {
+                        songs.insert(i, old);
+                    } else {
+                        Song moved(s);
+                        moved.rating=old.rating;
+                        songs.insert(i, moved);
+                    }
                     endMoveRows();
                 }
+                time += s.time;
             } else if (isEmpty) {
-                s=currentSongAtPos;
+                time += songs.at(i).time;
             } else {
-                s.key=currentSongAtPos.key;
-                s.rating=currentSongAtPos.rating;
-                songs.replace(i, s);
-                if (s.title!=currentSongAtPos.title || s.artist!=currentSongAtPos.artist || s.name()!=currentSongAtPos.name()) {
+                const Song &currentSongAtPos=songs.at(i);
+                bool changed=s.title!=currentSongAtPos.title || s.artist!=currentSongAtPos.artist || s.name()!=currentSongAtPos.name();
+                Song updated(s);
+                updated.key=currentSongAtPos.key;
+                updated.rating=currentSongAtPos.rating;
+                songs.replace(i, updated);
+                if (changed) {
                     emit dataChanged(index(i, 0), index(i, columnCount(QModelIndex())-1));
                 }
+                time += s.time;
             }
 
             if (s.id==currentSongId) {
                 currentSongRowNum=i;
             }
-            time += s.time;
         }
 
         if (songs.count()>songList.count()) {
@@ -1244,8 +1316,8 @@ void PlayQueueModel::remove(const QList<int> &rowsToRemove)
 {
     QList<qint32> removeIds;
     for (const int &r: rowsToRemove) {
-        if (r>-1 && r<songs.count()) {
-            removeIds.append(songs.at(r).id);
+        if (r>-1 && r<rowCount()) {
+            removeIds.append(getIdByRow(r));
         }
     }
 
@@ -1260,11 +1332,14 @@ void PlayQueueModel::crop(const QList<int> &rowsToKeep)
     for (const Song &song: songs) {
         allIds.insert(song.id);
     }
+    for (qint32 id: pagedIds) {
+        allIds.insert(id);
+    }
 
     QSet<qint32> keepIds;
     for (const int &r: rowsToKeep) {
-        if (r>-1 && r<songs.count()) {
-            keepIds.insert(songs.at(r).id);
+        if (r>-1 && r<rowCount()) {
+            keepIds.insert(getIdByRow(r));
         }
     }
 
@@ -1278,9 +1353,9 @@ void PlayQueueModel::setRating(const QList<int> &rows, quint8 rating) const
 {
     QSet<QString> files;
     for (const int &r: rows) {
-        if (r>-1 && r<songs.count()) {
-            const Song &s=songs.at(r);
-            if (Song::Standard==s.type && !files.contains(s.file)) {
+        if (r>-1 && r<rowCount()) {
+            const Song &s=songAt(r);
+            if (Song::Standard==s.type && !s.file.isEmpty() && !files.contains(s.file)) {
                 files.insert(s.file);
             }
         }
@@ -1542,6 +1617,20 @@ void PlayQueueModel::ratingResult(const QString &file, quint8 r)
             }
         }
     }
+
+    if (paged) {
+        for (qint32 id: pagedSongs.keys()) {
+            Song *song=pagedSongs.object(id);
+            if (Song::Standard==song->type && r!=song->rating && song->file==file) {
+                song->rating=r;
+                int row=getRowById(id);
+                emit dataChanged(index(row, 0), index(row, numCols));
+                if (id==currentSongId) {
+                    emit currentSongRating(file, r);
+                }
+            }
+        }
+    }
 }
 
 void PlayQueueModel::stickerDbChanged()
@@ -1554,6 +1643,15 @@ void PlayQueueModel::stickerDbChanged()
             requests.insert(song.file);
         }
     }
+    if (paged) {
+        for (qint32 id: pagedSongs.keys()) {
+            const Song *song=pagedSongs.object(id);
+            if (Song::Standard==song->type && song->rating<=Song::Rating_Max && !requests.contains(song->file)) {
+                emit getRating(song->file);
+                requests.insert(song->file);
+            }
+        }
+    }
 }
 
 void PlayQueueModel::undo()
@@ -1593,8 +1691,11 @@ void PlayQueueModel::stats()
     for (const Song &song: songs) {
         time += song.time;
     }
+    for (quint32 t: pagedTimes) {
+        time += t;
+    }
 
-    emit statsUpdated(songs.size(), time);
+    emit statsUpdated(rowCount(), time);
 }
 
 void PlayQueueModel::cancelStreamFetch()
@@ -1657,6 +1758,18 @@ void PlayQueueModel::remove(const QList<Song> &rem)
             }
         }
     }
+    if (paged) {
+        for (qint32 id: pagedSongs.keys()) {
+            const QString &file=pagedSongs.object(id)->file;
+            if (s.contains(file)) {
+                ids.append(id);
+                s.remove(file);
+                if (s.isEmpty()) {
+                    break;
+                }
+            }
+        }
+    }
 
     if (!ids.isEmpty()) {
         emit removeSongs(ids);
@@ -1697,6 +1810,25 @@ void PlayQueueModel::updateDetails(const QList<Song> &updated)
         }
     }
 
+    if (paged) {
+        for (qint32 id: pagedSongs.keys()) {
+            Song *current=pagedSongs.object(id);
+            if (songMap.contains(current->file)) {
+                Song updatedSong=songMap[current->file];
+                updatedSong.id=id;
+                updatedSong.setKey(MPDParseUtils::Loc_PlayQueue);
+                if (updatedSong.title!=current->title || updatedSong.artist!=current->artist || updatedSong.name()!=current->name()) {
+                    *current=updatedSong;
+                    updatedRows.append(getRowById(id));
+                    if (currentSongId==id) {
+                        currentUpdated=true;
+                        currentSong=updatedSong;
+                    }
+                }
+            }
+        }
+    }
+
     if (!updatedRows.isEmpty()) {
         if (updatedRows.count()==updated.count()) {
             beginResetModel();
@@ -1713,6 +1845,179 @@ void PlayQueueModel::updateDetails(const QList<Song> &updated)
     }
 }
 
+void PlayQueueModel::updatePaged(const QList<qint32> &newIds, const QList<quint32> &newTimes)
+{
+    currentSongRowNum=-1;
+    requestedPages.clear();
+    removeDuplicatesAction->setEnabled(false);
+    sortAction->setEnabled(false);
+    shuffleAction->setEnabled(newIds.count()>1);
+    if (!paged) {
+        // Undo requires the filename of every song, so is not available whilst paged
+        undoStack.clear();
+        redoStack.clear();
+        controlActions();
+    }
+    pagedRows.clear();
+
+    if (!paged || pagedIds.isEmpty() || newIds.isEmpty()) {
+        beginResetModel();
+        songs.clear();
+        ids.clear();
+        clearPaged();
+        paged=true;
+        pagedIds=newIds;
+        pagedTimes=newTimes;
+        endResetModel();
+    } else {
+        // Only the section between the common prefix and suffix has changed
+        int oldCount=pagedIds.count();
+        int newCount=newIds.count();
+        int prefix=0;
+        while (prefix<oldCount && prefix<newCount && pagedIds.at(prefix)==newIds.at(prefix)) {
+            ++prefix;
+        }
+        int suffix=0;
+        while (suffix<oldCount-prefix && suffix<newCount-prefix && pagedIds.at(oldCount-suffix-1)==newIds.at(newCount-suffix-1)) {
+            ++suffix;
+        }
+        int oldEnd=oldCount-suffix;
+        int newEnd=newCount-suffix;
+
+        if (oldEnd>prefix) {
+            for (int i=prefix; i<oldEnd; ++i) {
+                time-=pagedTimes.at(i);
+            }
+            beginRemoveRows(QModelIndex(), prefix, oldEnd-1);
+            pagedIds=pagedIds.mid(0, prefix)+pagedIds.mid(oldEnd);
+            pagedRows.clear();
+            pagedTimes=pagedTimes.mid(0, prefix)+pagedTimes.mid(oldEnd);
+            endRemoveRows();
+        }
+        if (newEnd>prefix) {
+            for (int i=prefix; i<newEnd; ++i) {
+                time+=newTimes.at(i);
+            }
+            beginInsertRows(QModelIndex(), prefix, newEnd-1);
+            pagedIds=newIds;
+            pagedRows.clear();
+            pagedTimes=newTimes;
+            endInsertRows();
+        }
+        if (-1!=stopAfterTrackId && -1==getRowById(stopAfterTrackId)) {
+            stopAfterTrackId=-1;
+        }
+        emit statsUpdated(pagedIds.count(), time);
+    }
+
+    if (pagedIds.isEmpty()) {
+        stopAfterTrackId=-1;
+    }
+    if (!searchText.isEmpty()) {
+        emit searchPlayQueue(searchText);
+    }
+}
+
+void PlayQueueModel::search(const QString &text)
+{
+    searchText=text;
+    searchIds.clear();
+    if (paged && !text.isEmpty()) {
+        emit searchPlayQueue(text);
+    }
+}
+
+// Song at row, or null if this has not been fetched yet. Unlike songAt() this never requests
+// pages, so may be used when scanning neighbouring rows.
+const Song * PlayQueueModel::cachedSongAt(int row) const
+{
+    return paged ? pagedSongs.object(pagedIds.at(row)) : &songs.at(row);
+}
+
+const Song & PlayQueueModel::songAt(int row) const
+{
+    if (!paged) {
+        return songs.at(row);
+    }
+
+    qint32 id=pagedIds.at(row);
+    Song *song=pagedSongs.object(id);
+    if (song) {
+        return *song;
+    }
+
+    // Request the page holding this row, and the neighbouring page if the row is near its edge.
+    int pageSize=MPDConnection::constPlayQueuePageSize;
+    int page=row/pageSize;
+    int offset=row%pageSize;
+    QList<int> pages=QList<int>() << page;
+    if (offset<pageSize/4 && page>0) {
+        pages.append(page-1);
+    } else if (offset>=(pageSize*3)/4 && (page+1)*pageSize<pagedIds.count()) {
+        pages.append(page+1);
+    }
+    for (int p: pages) {
+        if (!requestedPages.contains(p)) {
+            requestedPages.insert(p);
+            emit fetchRange(p*pageSize, (p+1)*pageSize);
+        }
+    }
+
+    placeholder=Song();
+    placeholder.id=id;
+    placeholder.time=pagedTimes.at(row);
+    return placeholder;
+}
+
+void PlayQueueModel::clearPaged()
+{
+    pagedIds.clear();
+    pagedRows.clear();
+    pagedTimes.clear();
+    pagedSongs.clear();
+    requestedPages.clear();
+    searchIds.clear();
+}
+
+void PlayQueueModel::rangeRetrieved(quint32 start, const QList<Song> &retrieved)
+{
+    requestedPages.remove(start/MPDConnection::constPlayQueuePageSize);
+    if (!paged) {
+        return;
+    }
+
+    int first=-1;
+    int last=-1;
+    for (int i=0; i<retrieved.count(); ++i) {
+        int row=start+i;
+        const Song &song=retrieved.at(i);
+        // Play queue may have changed since the range was requested
+        if (row>=pagedIds.count() || pagedIds.at(row)!=song.id) {
+            continue;
+        }
+        pagedSongs.insert(song.id, new Song(song));
+        if (-1==first) {
+            first=row;
+        }
+        last=row;
+    }
+    if (-1!=first) {
+        emit dataChanged(index(first, 0), index(last, COL_COUNT-1));
+    }
+}
+
+void PlayQueueModel::searchResults(const QString &text, const QList<Song> &results)
+{
+    if (!paged || text!=searchText) {
+        return;
+    }
+    searchIds.clear();
+    for (const Song &song: results) {
+        searchIds.insert(song.id);
+    }
+    emit searchResultsUpdated();
+}
+
 QStringList PlayQueueModel::filenames()
 {
     QStringList names;
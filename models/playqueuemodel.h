@@ -37,6 +37,8 @@
 #include <QSet>
 #include <QStack>
 #include <QMap>
+#include <QCache>
+#include <QHash>
 
 class StreamFetcher;
 class Action;
@@ -116,6 +118,10 @@ public:
     qint32 currentSongRow() const;
     void setState(MPDState st);
     void update(const QList<Song> &songList, bool isComplete);
+    void updatePaged(const QList<qint32> &newIds, const QList<quint32> &newTimes);
+    bool isPaged() const { return paged; }
+    void search(const QString &text);
+    bool matchesSearch(int row) const { return searchIds.contains(getIdByRow(row)); }
     void setStopAfterTrack(qint32 track);
     void clearStopAfterTrack() { setStopAfterTrack(-1); }
     bool removeCantataStreams(bool cdOnly=false);
@@ -134,6 +140,9 @@ public:
     void remove(const QList<Song> &rem);
 
 private:
+    const Song & songAt(int row) const;
+    const Song * cachedSongAt(int row) const;
+    void clearPaged();
     void saveHistory(const QList<Song> &prevList);
     void controlActions();
     void addSortAction(const QString &name, const QString &key);
@@ -159,6 +168,8 @@ private Q_SLOTS:
     void removeDuplicates();
     void ratingResult(const QString &file, quint8 r);
     void stickerDbChanged();
+    void rangeRetrieved(quint32 start, const QList<Song> &retrieved);
+    void searchResults(const QString &text, const QList<Song> &results);
 
 Q_SIGNALS:
     void stop(bool afterCurrent);
@@ -168,6 +179,9 @@ Q_SIGNALS:
     void move(const QList<quint32> &items, const quint32 row, const quint32 size);
     void setOrder(const QList<quint32> &items);
     void getRating(const QString &file) const;
+    void fetchRange(quint32 start, quint32 end) const;
+    void searchPlayQueue(const QString &text);
+    void searchResultsUpdated();
     void setRating(const QStringList &files, quint8 rating) const;
     void statsUpdated(int songs, quint32 time);
     void fetchingStreams();
@@ -211,6 +225,18 @@ private:
     Action *shuffleAction;
     Action *sortAction;
     QMap<int, int> alignments;
+
+    // Paged mode, used for very large play queues. Only the ids and durations of all songs are
+    // stored, the full details are fetched, as required, into a cache.
+    bool paged;
+    QList<qint32> pagedIds;
+    mutable QHash<qint32, int> pagedRows; // id -> row, built on demand
+    QList<quint32> pagedTimes;
+    mutable QCache<qint32, Song> pagedSongs;
+    mutable QSet<int> requestedPages;
+    mutable Song placeholder;
+    QString searchText;
+    QSet<qint32> searchIds;
 };
 
 #endif
@@ -33,6 +33,7 @@ PlayQueueProxyModel::PlayQueueProxyModel(QObject *parent)
     : ProxyModel(parent)
 {
     setFilterCaseSensitivity(Qt::CaseInsensitive);
+    setRefinable(true);
 }
 
 bool PlayQueueProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
@@ -45,6 +46,16 @@ bool PlayQueueProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sou
         return false;
     }
 
+    // Paged play queues are searched by MPD
+    const PlayQueueModel *pq=qobject_cast<const PlayQueueModel *>(sourceModel());
+    if (pq && pq->isPaged()) {
+        return pq->matchesSearch(sourceRow);
+    }
+
+    if (refinedOut(sourceRow, sourceParent)) {
+        return false;
+    }
+
     const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
     return index.isValid() && matchesFilter(*static_cast<Song *>(index.internalPointer()));
 }
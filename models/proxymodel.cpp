@@ -108,6 +108,11 @@ bool ProxyModel::update(const QString &txt)
     }
 
     bool wasEmpty=isEmpty();
+    // If the new text just extends the previous text (e.g. user typed another letter) then only
+    // rows that matched the previous filter can match. Years are excluded, as a partially typed
+    // year is matched as text.
+    bool refine=refinable && filterEnabled && nullptr==filter && sourceModel() && !text.contains(QLatin1Char('#')) &&
+                text.startsWith(origFilterText, Qt::CaseInsensitive);
     filterStrings.clear();
     yearFrom=yearTo=0;
 
@@ -154,9 +159,19 @@ bool ProxyModel::update(const QString &txt)
             return true;
         }
     } else {
+        if (refine) {
+            refineRows.fill(false, sourceModel()->rowCount());
+            for (int i=0, rc=rowCount(); i<rc; ++i) {
+                int row=mapToSource(index(i, 0)).row();
+                if (row>=0 && row<refineRows.count()) {
+                    refineRows[row]=true;
+                }
+            }
+        }
         filterEnabled=true;
 //        qWarning() << "INVALIDATE (changed)";
         invalidateFilter();
+        refineRows.clear();
 //        qWarning() << "DONE";
         return true;
     }
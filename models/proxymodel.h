@@ -26,6 +26,7 @@
 
 #include <QSortFilterProxyModel>
 #include <QStringList>
+#include <QVector>
 #include "mpd-interface/song.h"
 #include "config.h"
 
@@ -34,7 +35,7 @@ class QMimeData;
 class ProxyModel : public QSortFilterProxyModel
 {
 public:
-    ProxyModel(QObject *parent) : QSortFilterProxyModel(parent), isSorted(false), filterEnabled(false), filter(nullptr) { }
+    ProxyModel(QObject *parent) : QSortFilterProxyModel(parent), isSorted(false), filterEnabled(false), filter(nullptr), refinable(false) { }
     ~ProxyModel() override { }
 
     bool update(const QString &text);
@@ -57,6 +58,13 @@ public:
 protected:
     bool matchesFilter(const Song &s) const;
     bool matchesFilter(const QStringList &strings) const;
+    // Sub-classes whose filterAcceptsRow() checks refinedOut() should call this - refined rows are not
+    // recorded otherwise, as doing so requires a walk of all proxy rows.
+    void setRefinable(bool r) { refinable=r; }
+    // Whilst a refined filter is being applied, source (top-level) rows that did not match the previous one.
+    bool refinedOut(int sourceRow, const QModelIndex &sourceParent) const {
+        return !sourceParent.isValid() && sourceRow<refineRows.count() && !refineRows.at(sourceRow);
+    }
 
 private:
     QModelIndexList leaves(const QModelIndex &idx) const;
@@ -71,6 +79,8 @@ protected:
     const void *filter;
     quint16 yearFrom;
     quint16 yearTo;
+    bool refinable;
+    QVector<bool> refineRows;
 };
 
 #endif
@@ -29,8 +29,15 @@
 #include "support/utils.h"
 #include "roles.h"
 #include <QMimeData>
+#include <QTimer>
+#include <algorithm>
 #include <time.h>
 
+static inline QString albumKey(const QString &artistId, const QString &albumId)
+{
+    return artistId+QLatin1Char('\n')+albumId;
+}
+
 static QString parentData(const SqlLibraryModel::Item *i)
 {
     QString data;
@@ -69,6 +76,9 @@ QString SqlLibraryModel::groupingStr(Type m)
     }
 }
 
+static const int constListingCacheSize=32;
+static const int constMinMergeChanges=100;
+
 SqlLibraryModel::SqlLibraryModel(LibraryDb *d, QObject *p, Type top)
     : ActionModel(p)
     , tl(top)
@@ -76,14 +86,27 @@ SqlLibraryModel::SqlLibraryModel(LibraryDb *d, QObject *p, Type top)
     , db(d)
     , librarySort(LibraryDb::AS_YrAlAr)
     , albumSort(LibraryDb::AS_AlArYr)
+    , changedTimer(nullptr)
+    , generation(0)
+    , resetPending(false)
+    , mergePending(false)
+    , cacheVersion(0)
+    , albumTracksCache(constListingCacheSize)
+    , artistAlbumsCache(constListingCacheSize)
 {
     connect(db, SIGNAL(libraryUpdated()), SLOT(libraryUpdated()));
+    connect(db, SIGNAL(libraryChanged(LibraryDb::Changes)), SLOT(applyChanges(LibraryDb::Changes)));
+    connect(db, SIGNAL(retrieved(LibraryDb::ReadResult)), SLOT(libraryRetrieved(LibraryDb::ReadResult)));
     connect(db, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
 }
 
 void SqlLibraryModel::clear()
 {
+    ++generation; // Discard any pending read
+    resetPending=mergePending=false;
+    pendingChanges=LibraryDb::Changes();
     beginResetModel();
+    clearItemIndex();
     delete root;
     root=nullptr;
     endResetModel();
@@ -101,7 +124,7 @@ void SqlLibraryModel::settings(Type top, LibraryDb::AlbumSort lib, LibraryDb::Al
     librarySort=lib;
     albumSort=al;
     if (changed) {
-        libraryUpdated();
+        regroup();
     }
 }
 
@@ -109,7 +132,7 @@ void SqlLibraryModel::setTopLevel(Type t)
 {
     if (t!=tl) {
         tl=t;
-        libraryUpdated();
+        regroup();
     }
 }
 
@@ -118,7 +141,7 @@ void SqlLibraryModel::setLibraryAlbumSort(LibraryDb::AlbumSort s)
     if (s!=librarySort) {
         librarySort=s;
         if (T_Album!=tl) {
-            libraryUpdated();
+            regroup();
         }
     }
 }
@@ -128,11 +151,19 @@ void SqlLibraryModel::setAlbumAlbumSort(LibraryDb::AlbumSort s)
     if (s!=albumSort) {
         albumSort=s;
         if (T_Album==tl) {
-            libraryUpdated();
+            regroup();
         }
     }
 }
 
+// Grouping, or sort, has changed. The current items have the previous shape (and code using these
+// relies upon 'tl'), so remove them now rather than waiting for the new items to be read.
+void SqlLibraryModel::regroup()
+{
+    clear();
+    libraryUpdated();
+}
+
 static QLatin1String constGroupingKey("grouping");
 static QLatin1String constAlbumSortKey("albumSort");
 static QLatin1String constLibrarySortKey("librarySort");
@@ -151,32 +182,321 @@ void SqlLibraryModel::save(Configuration &config)
     config.set(constLibrarySortKey, LibraryDb::albumSortStr(librarySort));
 }
 
+LibraryDb::ReadRequest SqlLibraryModel::topLevelRequest() const
+{
+    LibraryDb::ReadRequest req;
+    req.generation=generation;
+    req.type=T_Genre==tl ? LibraryDb::Read_Genres : (T_Album==tl ? LibraryDb::Read_Albums : LibraryDb::Read_Artists);
+    req.sort=albumSort;
+    return req;
+}
+
 void SqlLibraryModel::libraryUpdated()
 {
-    beginResetModel();
-    delete root;
-    root=new CollectionItem(T_Root, QString());
-    switch (tl) {
-    case T_Genre: {
-        QList<LibraryDb::Genre> genres=db->getGenres();
-        if (!genres.isEmpty())  {
-            for (const LibraryDb::Genre &genre: genres) {
-                root->add(new CollectionItem(T_Genre, genre.name, genre.name, tr("%n Artist(s)", "", genre.artistCount), root));
+    resetPending=true;
+    mergePending=false;
+    pendingChanges=LibraryDb::Changes();
+    readTopLevel();
+}
+
+void SqlLibraryModel::readTopLevel()
+{
+    // Read top-level items in a worker thread; the current items remain until these have been retrieved.
+    ++generation;
+    LibraryDb::ReadRequest req=topLevelRequest();
+    if (!db->readAsync(req)) {
+        libraryRetrieved(db->read(req));
+        return;
+    }
+    if (mergePending) {
+        // Results of any pending child reads will now be discarded, but the items will remain - so request
+        // these again.
+        const QSet<Item *> items=fetching;
+        for (Item *item: items) {
+            if (!db->readAsync(childRequest(static_cast<CollectionItem *>(item)))) {
+                fetching.remove(item);
             }
         }
-        break;
     }
-    case T_Artist: {
-        QList<LibraryDb::Artist> artists=db->getArtists();
-        if (!artists.isEmpty())  {
-            for (const LibraryDb::Artist &artist: artists) {
-                root->add(new CollectionItem(T_Artist, artist.name, artist.name, tr("%n Album(s)", "", artist.albumCount), root));
+}
+
+static void addChanges(LibraryDb::Changes &to, const LibraryDb::Changes &from)
+{
+    to.complete=from.complete;
+    to.keysChanged|=from.keysChanged;
+    to.detailsChanged|=from.detailsChanged;
+    to.added+=from.added;
+    to.removed+=from.removed;
+    to.modified+=from.modified;
+    to.artists+=from.artists;
+    to.albums+=from.albums;
+    to.genres+=from.genres;
+}
+
+void SqlLibraryModel::applyChanges(const LibraryDb::Changes &changes)
+{
+    if (!changes.complete || resetPending || (!root && changes.isStructural())) {
+        // Previous contents were not known, or everything is already being reloaded.
+        libraryUpdated();
+    } else if (root && (changes.isStructural() || !db->getFilter().isEmpty())) {
+        // Items need to be added, removed, or moved - or changed tags could alter what matches the
+        // current search. So, re-read the top level, and merge this (and the children of any affected
+        // items that have been loaded) with the current items once retrieved.
+        addChanges(pendingChanges, changes);
+        mergePending=true;
+        readTopLevel();
+    } else if (root && !changes.isEmpty()) {
+        // Only track details have changed, so just update any tracks that have been loaded.
+        QSet<QString> files;
+        for (const QString &f: changes.modified) {
+            files.insert(f);
+        }
+        for (const QPair<QString, QString> &album: changes.albums) {
+            for (Item *item: albumItems(album.first, album.second)) {
+                updateTracks(static_cast<CollectionItem *>(item), files);
+            }
+        }
+    }
+    emit libraryChanged(changes);
+}
+
+// Update the loaded children of the artists, albums, and genres affected by changes. The top level must
+// already have been merged.
+void SqlLibraryModel::mergeChanges(const LibraryDb::Changes &changes)
+{
+    if (T_Genre==tl) {
+        for (Item *genre: root->getChildren()) {
+            if (0!=genre->getChildCount() && changes.genres.contains(genre->getId())) {
+                mergeLoadedChildren(static_cast<CollectionItem *>(genre));
+            }
+        }
+    }
+    if (T_Album!=tl) {
+        for (const QString &artistId: changes.artists) {
+            for (Item *artist: artistItems(artistId)) {
+                if (0!=artist->getChildCount()) {
+                    mergeLoadedChildren(static_cast<CollectionItem *>(artist));
+                }
+            }
+        }
+    }
+
+    QSet<QString> files;
+    for (const QString &f: changes.modified) {
+        files.insert(f);
+    }
+    for (const QPair<QString, QString> &album: changes.albums) {
+        for (Item *item: albumItems(album.first, album.second)) {
+            updateTracks(static_cast<CollectionItem *>(item), files);
+        }
+    }
+}
+
+void SqlLibraryModel::mergeLoadedChildren(CollectionItem *item)
+{
+    LibraryDb::ReadResult result=db->read(childRequest(item));
+    if (result.ok) {
+        mergeChildren(item, createItems(result, item));
+    }
+}
+
+// Merge newly read items with parent's current children - removing those no longer present, moving those
+// whose sort position has changed, and inserting new ones. Existing items (and so any of their loaded
+// children) are kept. If more than maxChanges items would be added or removed, then nothing is changed,
+// false is returned, and the caller retains ownership of items.
+bool SqlLibraryModel::mergeChildren(CollectionItem *parent, const QList<Item *> &items, int maxChanges)
+{
+    QSet<QString> ids;
+    for (Item *item: items) {
+        ids.insert(item->getUniqueId());
+    }
+
+    const QList<Item *> &children=parent->getChildren();
+    if (maxChanges>=0) {
+        int kept=0;
+        for (Item *child: children) {
+            if (ids.contains(child->getUniqueId())) {
+                kept++;
+            }
+        }
+        if ((children.count()-kept)+(items.count()-kept)>maxChanges) {
+            return false;
+        }
+    }
+
+    QModelIndex parentIndex=parent==root ? QModelIndex() : createIndex(parent->getRow(), 0, parent);
+
+    // Remove items that are no longer present, a run of rows at a time
+    for (int last=children.count()-1; last>=0; --last) {
+        if (ids.contains(children.at(last)->getUniqueId())) {
+            continue;
+        }
+        int first=last;
+        while (first>0 && !ids.contains(children.at(first-1)->getUniqueId())) {
+            --first;
+        }
+        beginRemoveRows(parentIndex, first, last);
+        QList<Item *> removed=parent->take(first, last-first+1);
+        for (Item *item: removed) {
+            unindexItem(item);
+        }
+        endRemoveRows();
+        qDeleteAll(removed);
+        last=first;
+    }
+
+    // Rows before 'row' are now in their final positions
+    for (int row=0; row<items.count(); ) {
+        Item *item=items.at(row);
+        Item *existing=parent->getChild(item->getUniqueId());
+        if (existing) {
+            if (existing->getRow()!=row) {
+                beginMoveRows(parentIndex, existing->getRow(), existing->getRow(), parentIndex, row);
+                parent->move(existing->getRow(), row);
+                endMoveRows();
+            }
+            if (static_cast<CollectionItem *>(existing)->update(static_cast<CollectionItem *>(item))) {
+                queueDataChanged(existing);
+            }
+            delete item;
+            ++row;
+        } else {
+            int last=row;
+            while (last+1<items.count() && !parent->getChild(items.at(last+1)->getUniqueId())) {
+                ++last;
+            }
+            QList<Item *> added=items.mid(row, last-row+1);
+            beginInsertRows(parentIndex, row, last);
+            parent->insert(row, added);
+            for (Item *a: added) {
+                indexItem(a);
+            }
+            endInsertRows();
+            row=last+1;
+        }
+    }
+    return true;
+}
+
+void SqlLibraryModel::updateTracks(CollectionItem *album, const QSet<QString> &files)
+{
+    const QList<Item *> &children=album->getChildren();
+    if (children.isEmpty()) {
+        // Tracks not loaded yet, so will be read when they are.
+        return;
+    }
+
+    QList<Song> songs=tracks(album);
+    bool sameOrder=songs.count()==children.count();
+    for (int i=0; sameOrder && i<songs.count(); ++i) {
+        sameOrder=songs.at(i).file==children.at(i)->getSong().file;
+    }
+
+    if (sameOrder) {
+        for (int i=0; i<songs.count(); ++i) {
+            if (files.contains(songs.at(i).file)) {
+                children.at(i)->setSong(songs.at(i));
+                queueDataChanged(children.at(i));
             }
         }
+        return;
+    }
+
+    // Track order has changed (e.g. track number edited), so replace all of album's tracks
+    QModelIndex idx=createIndex(album->getRow(), 0, album);
+    beginRemoveRows(idx, 0, children.count()-1);
+    for (Item *child: children) {
+        changedItems.remove(child);
+    }
+    album->clearChildren();
+    endRemoveRows();
+    if (!songs.isEmpty()) {
+        beginInsertRows(idx, 0, songs.count()-1);
+        for (const Song &song: songs) {
+            album->add(new TrackItem(song, album));
+        }
+        endInsertRows();
+    }
+}
+
+void SqlLibraryModel::libraryRetrieved(const LibraryDb::ReadResult &result)
+{
+    if (result.generation!=generation) {
+        // Superseded by a later request
+        return;
+    }
+    switch (result.type) {
+    case LibraryDb::Read_GenreArtists:
+    case LibraryDb::Read_ArtistAlbums:
+    case LibraryDb::Read_AlbumTracks:
+        childrenRetrieved(result);
+        return;
+    default:
         break;
     }
-    case T_Album: {
-        QList<LibraryDb::Album> albums=db->getAlbums(QString(), QString(), albumSort);
+    if (!result.ok) {
+        // Failed to open read-only connection, so read directly...
+        LibraryDb::ReadResult direct=db->read(topLevelRequest());
+        if (direct.ok) {
+            libraryRetrieved(direct);
+            return;
+        }
+    }
+
+    if (!root) {
+        root=new CollectionItem(T_Root, QString());
+    }
+    QList<Item *> items=createItems(result, root);
+    bool merge=mergePending;
+    LibraryDb::Changes changes=pendingChanges;
+    resetPending=mergePending=false;
+    pendingChanges=LibraryDb::Changes();
+
+    // If most items have changed, then a reset is quicker than adding and removing each.
+    if (merge && mergeChildren(root, items, qMax(constMinMergeChanges, root->getChildCount()/4))) {
+        mergeChanges(changes);
+        return;
+    }
+
+    beginResetModel();
+    clearItemIndex();
+    root->clearChildren();
+    for (Item *item: items) {
+        root->add(item);
+        indexItem(item);
+    }
+    endResetModel();
+}
+
+// Create (but do not add) items for the results of a read - with parent as their parent.
+QList<SqlLibraryModel::Item *> SqlLibraryModel::createItems(const LibraryDb::ReadResult &result, CollectionItem *parent)
+{
+    QList<Item *> items;
+    switch (result.type) {
+    case LibraryDb::Read_Genres:
+        for (const LibraryDb::Genre &genre: result.genres) {
+            items.append(new CollectionItem(T_Genre, genre.name, genre.name, tr("%n Artist(s)", "", genre.artistCount), parent));
+        }
+        break;
+    case LibraryDb::Read_Artists:
+    case LibraryDb::Read_GenreArtists:
+        for (const LibraryDb::Artist &artist: result.artists) {
+            items.append(new CollectionItem(T_Artist, artist.name, artist.name, tr("%n Album(s)", "", artist.albumCount), parent));
+        }
+        break;
+    case LibraryDb::Read_ArtistAlbums:
+        for (const LibraryDb::Album &album: result.albums) {
+            items.append(new CollectionItem(T_Album, album.id, Song::displayAlbum(album.name, album.year),
+                                            tr("%n Tracks (%1)", "", album.trackCount).arg(Utils::formatTime(album.duration, true)), parent));
+        }
+        break;
+    case LibraryDb::Read_AlbumTracks:
+        for (const Song &song: result.tracks) {
+            items.append(new TrackItem(song, parent));
+        }
+        break;
+    case LibraryDb::Read_Albums: {
+        const QList<LibraryDb::Album> &albums=result.albums;
         categories.clear();
         if (!albums.isEmpty())  {
             time_t now = time(nullptr);
@@ -243,9 +563,9 @@ void SqlLibraryModel::libraryUpdated()
                 }
 
                 QString trackInfo = tr("%n Tracks (%1)", "", album.trackCount).arg(Utils::formatTime(album.duration, true));
-                root->add(new AlbumItem(T_Album==tl && album.identifyById ? QString() : album.artist,
-                                        album.id, Song::displayAlbum(album.name, album.year),
-                                        T_Album==tl ? album.artist : trackInfo, T_Album==tl ? trackInfo : QString(), root, cat));
+                items.append(new AlbumItem(T_Album==tl && album.identifyById ? QString() : album.artist,
+                                           album.id, Song::displayAlbum(album.name, album.year),
+                                           T_Album==tl ? album.artist : trackInfo, T_Album==tl ? trackInfo : QString(), parent, cat));
             }
         }
         break;
@@ -253,8 +573,7 @@ void SqlLibraryModel::libraryUpdated()
     default:
         break;
     }
-
-    endResetModel();
+    return items;
 }
 
 void SqlLibraryModel::search(const QString &str, const QString &genre)
@@ -336,50 +655,126 @@ void SqlLibraryModel::fetchMore(const QModelIndex &index)
     }
 
     CollectionItem *item = static_cast<CollectionItem *>(toItem(index));
+    if (T_Root==item->getType() || T_Track==item->getType() || fetching.contains(item)) {
+        return;
+    }
+    // Read children in a worker thread, so that expanding an item does not block the UI
+    LibraryDb::ReadRequest req=childRequest(item);
+    if (db->readAsync(req)) {
+        fetching.insert(item);
+    } else {
+        addChildren(item, db->read(req));
+    }
+}
+
+// As fetchMore(), but children are read before returning - for when these are needed immediately.
+void SqlLibraryModel::fetchNow(const QModelIndex &index)
+{
+    if (canFetchMore(index)) {
+        CollectionItem *item = static_cast<CollectionItem *>(toItem(index));
+        fetching.remove(item); // Any pending result will now be ignored
+        addChildren(item, db->read(childRequest(item)));
+    }
+}
+
+LibraryDb::ReadRequest SqlLibraryModel::childRequest(const CollectionItem *item) const
+{
+    LibraryDb::ReadRequest req;
+    req.generation=generation;
     switch (item->getType()) {
-    case T_Root:
+    case T_Genre:
+        req.type=LibraryDb::Read_GenreArtists;
+        req.genre=item->getId();
         break;
-    case T_Genre: {
-        QList<LibraryDb::Artist> artists=db->getArtists(item->getId());
-        if (!artists.isEmpty())  {
-            beginInsertRows(index, 0, artists.count()-1);
-            for (const LibraryDb::Artist &artist: artists) {
-                item->add(new CollectionItem(T_Artist, artist.name, artist.name, tr("%n Album(s)", "", artist.albumCount), item));
-            }
-            endInsertRows();
+    case T_Artist:
+        req.type=LibraryDb::Read_ArtistAlbums;
+        req.artistId=item->getId();
+        req.genre=T_Genre==tl ? item->getParent()->getId() : QString();
+        req.sort=librarySort;
+        break;
+    default:
+        req.type=LibraryDb::Read_AlbumTracks;
+        req.albumId=item->getId();
+        if (T_Album==tl) {
+            req.artistId=static_cast<const AlbumItem *>(item)->getArtistId();
+            req.sort=albumSort;
+        } else {
+            req.artistId=item->getParent()->getId();
+            req.genre=T_Genre==tl ? item->getParent()->getParent()->getId() : QString();
+            req.sort=librarySort;
         }
         break;
     }
-    case T_Artist: {
-        QList<LibraryDb::Album> albums=db->getAlbums(item->getId(), T_Genre==tl ? item->getParent()->getId() : QString(), librarySort);
-        if (!albums.isEmpty())  {
-            beginInsertRows(index, 0, albums.count()-1);
-            for (const LibraryDb::Album &album: albums) {
-                item->add(new CollectionItem(T_Album, album.id, Song::displayAlbum(album.name, album.year),
-                                             tr("%n Tracks (%1)", "", album.trackCount).arg(Utils::formatTime(album.duration, true)), item));
+    return req;
+}
+
+// Locate the item whose children were requested. Items are identified by ID, rather than pointer, as
+// these may have been removed (and others created) whilst the request was pending.
+SqlLibraryModel::CollectionItem * SqlLibraryModel::requestedItem(const LibraryDb::ReadResult &result) const
+{
+    if (!root) {
+        return nullptr;
+    }
+    switch (result.type) {
+    case LibraryDb::Read_GenreArtists:
+        for (Item *g: root->getChildren()) {
+            if (T_Genre==g->getType() && g->getId()==result.genre) {
+                return static_cast<CollectionItem *>(g);
             }
-            endInsertRows();
         }
         break;
-    }
-    case T_Album: {
-        QList<Song> songs=T_Album==tl
-                            ? db->getTracks(static_cast<AlbumItem *>(item)->getArtistId(), item->getId(), QString(), albumSort)
-                            : db->getTracks(item->getParent()->getId(), item->getId(),
-                                            T_Genre==tl ? item->getParent()->getParent()->getId() : QString(), librarySort);
-
-        if (!songs.isEmpty())  {
-            beginInsertRows(index, 0, songs.count()-1);
-            for (const Song &song: songs) {
-                item->add(new TrackItem(song, item));
+    case LibraryDb::Read_ArtistAlbums:
+        for (Item *a: artistItems(result.artistId)) {
+            if (T_Genre!=tl || a->getParent()->getId()==result.genre) {
+                return static_cast<CollectionItem *>(a);
+            }
+        }
+        break;
+    case LibraryDb::Read_AlbumTracks:
+        for (Item *a: albumItems(result.artistId, result.albumId)) {
+            if (T_Genre!=tl || a->getParent()->getParent()->getId()==result.genre) {
+                return static_cast<CollectionItem *>(a);
             }
-            endInsertRows();
         }
         break;
-    }
     default:
         break;
     }
+    return nullptr;
+}
+
+void SqlLibraryModel::childrenRetrieved(const LibraryDb::ReadResult &result)
+{
+    CollectionItem *item=requestedItem(result);
+    if (!item || !fetching.contains(item)) {
+        // Item has been removed, or its children have already been read
+        return;
+    }
+    fetching.remove(item);
+    if (0!=item->getChildCount()) {
+        return;
+    }
+    // If worker failed to open read-only connection, then read directly...
+    addChildren(item, result.ok ? result : db->read(childRequest(item)));
+}
+
+void SqlLibraryModel::addChildren(CollectionItem *item, const LibraryDb::ReadResult &result)
+{
+    QList<Item *> items=createItems(result, item);
+    if (items.isEmpty()) {
+        return;
+    }
+    beginInsertRows(createIndex(item->getRow(), 0, item), 0, items.count()-1);
+    for (Item *child: items) {
+        item->add(child);
+        indexItem(child);
+    }
+    endInsertRows();
+}
+
+QList<Song> SqlLibraryModel::tracks(const CollectionItem *album) const
+{
+    return db->read(childRequest(album)).tracks;
 }
 
 QVariant SqlLibraryModel::data(const QModelIndex &index, int role) const
@@ -509,9 +904,7 @@ QModelIndex SqlLibraryModel::findSongIndex(const Song &song)
     if (root) {
         QModelIndex albumIndex=findAlbumIndex(song.albumArtistOrComposer(), song.albumId());
         if (albumIndex.isValid()) {
-            if (canFetchMore(albumIndex)) {
-                fetchMore(albumIndex);
-            }
+            fetchNow(albumIndex);
             CollectionItem *al=static_cast<CollectionItem *>(albumIndex.internalPointer());
             for (Item *t: al->getChildren()) {
                 if (static_cast<TrackItem *>(t)->getSong().title==song.title) {
@@ -536,6 +929,12 @@ QModelIndex SqlLibraryModel::findSongIndex(const Song &song)
 QModelIndex SqlLibraryModel::findAlbumIndex(const QString &artist, const QString &album)
 {
     if (root) {
+        QList<Item *> items=albumItems(artist, album);
+        if (!items.isEmpty()) {
+            Item *a=items.last();
+            return createIndex(a->getRow(), 0, a);
+        }
+
         if (T_Album==tl) {
             for (Item *a: root->getChildren()) {
                 if (a->getId()==album && static_cast<AlbumItem *>(a)->getArtistId()==artist) {
@@ -545,9 +944,7 @@ QModelIndex SqlLibraryModel::findAlbumIndex(const QString &artist, const QString
         } else {
             QModelIndex artistIndex=findArtistIndex(artist);
             if (artistIndex.isValid()) {
-                if (canFetchMore(artistIndex)) {
-                    fetchMore(artistIndex);
-                }
+                fetchNow(artistIndex);
                 CollectionItem *ar=static_cast<CollectionItem *>(artistIndex.internalPointer());
                 for (Item *al: ar->getChildren()) {
                     if (al->getId()==album) {
@@ -563,12 +960,16 @@ QModelIndex SqlLibraryModel::findAlbumIndex(const QString &artist, const QString
 QModelIndex SqlLibraryModel::findArtistIndex(const QString &artist)
 {
     if (root) {
+        QList<Item *> items=artistItems(artist);
+        if (!items.isEmpty()) {
+            Item *a=items.last();
+            return createIndex(a->getRow(), 0, a);
+        }
+
         if (T_Genre==tl) {
             for (Item *g: root->getChildren()) {
                 QModelIndex gIndex=index(g->getRow(), 0, QModelIndex());
-                if (canFetchMore(gIndex)) {
-                    fetchMore(gIndex);
-                }
+                fetchNow(gIndex);
                 for (Item *a: static_cast<CollectionItem *>(g)->getChildren()) {
                     if (a->getId()==artist) {
                         return index(a->getRow(), 0, gIndex);
@@ -596,9 +997,24 @@ QSet<QString> SqlLibraryModel::getArtists() const
     return db->get("albumArtist");
 }
 
+QString SqlLibraryModel::resolveArtist(const QString &name) const
+{
+    return db->resolveArtist(name);
+}
+
 QList<Song> SqlLibraryModel::getAlbumTracks(const QString &artistId, const QString &albumId, int maxTracks) const
 {
-    return db->getTracks(artistId, albumId, QString(), LibraryDb::AS_ArAlYr, false, maxTracks);
+    checkCacheVersion();
+    QString key=artistId+QLatin1Char('\n')+albumId+QLatin1Char('\n')+QString::number(maxTracks);
+    QList<Song> *cached=albumTracksCache.object(key);
+    if (cached) {
+        return *cached;
+    }
+    QList<Song> tracks=db->getTracks(artistId, albumId, QString(), LibraryDb::AS_ArAlYr, false, maxTracks);
+    if (0!=cacheVersion) {
+        albumTracksCache.insert(key, new QList<Song>(tracks));
+    }
+    return tracks;
 }
 
 QList<Song> SqlLibraryModel::songs(const QStringList &files, bool allowPlaylists) const
@@ -608,7 +1024,26 @@ QList<Song> SqlLibraryModel::songs(const QStringList &files, bool allowPlaylists
 
 QList<LibraryDb::Album> SqlLibraryModel::getArtistOrComposerAlbums(const QString &artist) const
 {
-    return db->getAlbumsWithArtistOrComposer(artist);
+    checkCacheVersion();
+    QList<LibraryDb::Album> *cached=artistAlbumsCache.object(artist);
+    if (cached) {
+        return *cached;
+    }
+    QList<LibraryDb::Album> albums=db->getAlbumsWithArtistOrComposer(artist);
+    if (0!=cacheVersion) {
+        artistAlbumsCache.insert(artist, new QList<LibraryDb::Album>(albums));
+    }
+    return albums;
+}
+
+// Listings are only valid for the DB version they were read from
+void SqlLibraryModel::checkCacheVersion() const
+{
+    if (db->getCurrentVersion()!=cacheVersion) {
+        albumTracksCache.clear();
+        artistAlbumsCache.clear();
+        cacheVersion=db->getCurrentVersion();
+    }
 }
 
 void SqlLibraryModel::getDetails(QSet<QString> &artists, QSet<QString> &albumArtists, QSet<QString> &composers, QSet<QString> &albums, QSet<QString> &genres)
@@ -626,12 +1061,125 @@ int SqlLibraryModel::trackCount() const
     return db->trackCount();
 }
 
+QList<SqlLibraryModel::Item *> SqlLibraryModel::albumItems(const QString &artistId, const QString &albumId) const
+{
+    QList<Item *> items=albumItemIndex.values(albumKey(artistId, albumId));
+    if (items.isEmpty() && T_Album==tl) {
+        // Albums identified by ID alone have no artist ID
+        items=albumItemIndex.values(albumKey(QString(), albumId));
+    }
+    return items;
+}
+
+void SqlLibraryModel::queueDataChanged(Item *item)
+{
+    if (!item) {
+        return;
+    }
+    changedItems.insert(item);
+    if (!changedTimer) {
+        changedTimer=new QTimer(this);
+        changedTimer->setSingleShot(true);
+        // Roughly one frame, so that many covers arriving at once cause a single repaint.
+        changedTimer->setInterval(16);
+        connect(changedTimer, SIGNAL(timeout()), this, SLOT(emitQueuedDataChanged()));
+    }
+    if (!changedTimer->isActive()) {
+        changedTimer->start();
+    }
+}
+
+void SqlLibraryModel::emitQueuedDataChanged()
+{
+    if (changedItems.isEmpty()) {
+        return;
+    }
+
+    QMap<CollectionItem *, QList<int> > rows;
+    for (Item *item: changedItems) {
+        rows[item->getParent()].append(item->getRow());
+    }
+    changedItems.clear();
+
+    QMap<CollectionItem *, QList<int> >::Iterator it=rows.begin();
+    QMap<CollectionItem *, QList<int> >::Iterator end=rows.end();
+    for (; it!=end; ++it) {
+        CollectionItem *p=it.key();
+        QModelIndex parentIndex=!p || p==root ? QModelIndex() : createIndex(p->getRow(), 0, p);
+        QList<int> &r=it.value();
+        std::sort(r.begin(), r.end());
+        int first=r.first();
+        int last=first;
+        for (int i=1; i<r.count(); ++i) {
+            if (r.at(i)!=last+1) {
+                emit dataChanged(index(first, 0, parentIndex), index(last, 0, parentIndex));
+                first=r.at(i);
+            }
+            last=r.at(i);
+        }
+        emit dataChanged(index(first, 0, parentIndex), index(last, 0, parentIndex));
+    }
+}
+
+QString SqlLibraryModel::albumItemKey(const Item *item) const
+{
+    return T_Album==tl
+            ? albumKey(static_cast<const AlbumItem *>(item)->getArtistId(), item->getId())
+            : albumKey(item->getParent()->getId(), item->getId());
+}
+
+void SqlLibraryModel::indexItem(Item *item)
+{
+    switch (item->getType()) {
+    case T_Artist:
+        artistItemIndex.insert(item->getId(), item);
+        break;
+    case T_Album:
+        albumItemIndex.insert(albumItemKey(item), item);
+        break;
+    default:
+        break;
+    }
+}
+
+// Item is about to be deleted, so remove it - and its children - from the indexes.
+void SqlLibraryModel::unindexItem(Item *item)
+{
+    switch (item->getType()) {
+    case T_Artist:
+        artistItemIndex.remove(item->getId(), item);
+        break;
+    case T_Album:
+        albumItemIndex.remove(albumItemKey(item), item);
+        break;
+    case T_Track:
+        changedItems.remove(item);
+        return;
+    default:
+        break;
+    }
+    fetching.remove(item);
+    changedItems.remove(item);
+    for (Item *child: static_cast<CollectionItem *>(item)->getChildren()) {
+        unindexItem(child);
+    }
+}
+
+void SqlLibraryModel::clearItemIndex()
+{
+    albumItemIndex.clear();
+    artistItemIndex.clear();
+    fetching.clear();
+    changedItems.clear();
+    if (changedTimer) {
+        changedTimer->stop();
+    }
+}
+
 void SqlLibraryModel::populate(const QModelIndexList &list) const
 {
     for (const QModelIndex &idx: list) {
-        if (canFetchMore(idx)) {
-            const_cast<SqlLibraryModel *>(this)->fetchMore(idx);
-        }
+        const_cast<SqlLibraryModel *>(this)->fetchNow(idx);
         if (T_Track!=static_cast<Item *>(idx.internalPointer())->getType()) {
             populate(children(idx));
         }
@@ -672,10 +1220,70 @@ void SqlLibraryModel::CollectionItem::add(Item *i)
     childMap.insert(i->getUniqueId(), i);
 }
 
+void SqlLibraryModel::CollectionItem::insert(int row, const QList<Item *> &items)
+{
+    for (int i=0; i<items.count(); ++i) {
+        children.insert(row+i, items.at(i));
+        childMap.insert(items.at(i)->getUniqueId(), items.at(i));
+    }
+    renumber(row);
+}
+
+QList<SqlLibraryModel::Item *> SqlLibraryModel::CollectionItem::take(int row, int count)
+{
+    QList<Item *> taken=children.mid(row, count);
+    children.erase(children.begin()+row, children.begin()+row+count);
+    for (Item *i: taken) {
+        childMap.remove(i->getUniqueId());
+    }
+    renumber(row);
+    return taken;
+}
+
+void SqlLibraryModel::CollectionItem::move(int from, int to)
+{
+    children.move(from, to);
+    renumber(qMin(from, to), qMax(from, to));
+}
+
+void SqlLibraryModel::CollectionItem::renumber(int from, int to)
+{
+    int last=to<0 ? children.count()-1 : to;
+    for (int i=from; i<=last; ++i) {
+        children.at(i)->setRow(i);
+    }
+}
+
+bool SqlLibraryModel::CollectionItem::update(const CollectionItem *other)
+{
+    if (other->text==text && other->subText==subText) {
+        return false;
+    }
+    text=other->text;
+    subText=other->subText;
+    return true;
+}
+
+bool SqlLibraryModel::AlbumItem::update(const CollectionItem *other)
+{
+    const AlbumItem *album=static_cast<const AlbumItem *>(other);
+    // Categories are re-calculated for each read, so must always be updated
+    bool changed=album->category!=category || album->titleSub!=titleSub;
+    category=album->category;
+    titleSub=album->titleSub;
+    return CollectionItem::update(other) || changed;
+}
+
 const SqlLibraryModel::Item *SqlLibraryModel::CollectionItem::getChild(const QString &id) const
 {
     QMap<QString, Item *>::ConstIterator it=childMap.find(id);
     return childMap.constEnd()==it ? nullptr : it.value();
 }
 
+SqlLibraryModel::Item *SqlLibraryModel::CollectionItem::getChild(const QString &id)
+{
+    QMap<QString, Item *>::Iterator it=childMap.find(id);
+    return childMap.end()==it ? nullptr : it.value();
+}
+
 #include "moc_sqllibrarymodel.cpp"
@@ -29,8 +29,12 @@
 #include "support/utils.h"
 #include "db/librarydb.h"
 #include <QMap>
+#include <QMultiHash>
+#include <QSet>
+#include <QCache>
 
 class Configuration;
+class QTimer;
 
 class SqlLibraryModel : public ActionModel
 {
@@ -97,10 +101,20 @@ public:
         const QList<Item *> & getChildren() const { return children; }
         int getChildCount() const override { return children.count();}
         void add(Item *i);
+        void insert(int row, const QList<Item *> &items);
+        QList<Item *> take(int row, int count);
+        void move(int from, int to);
         const Item * getChild(const QString &id) const;
+        Item * getChild(const QString &id);
+        void clearChildren() { qDeleteAll(children); children.clear(); childMap.clear(); }
         const QString & getId() const override { return id; }
         QString getText() const override { return text; }
         QString getSubText() const override { return subText; }
+        // Copy displayed details from a newly read item with the same ID. Returns true if any changed.
+        virtual bool update(const CollectionItem *other);
+
+    private:
+        void renumber(int from, int to=-1);
 
     private:
         QString id;
@@ -121,6 +135,7 @@ public:
         const QString getUniqueId() const override { return artistId+getId(); }
         const QString & getTitleSub() const {return titleSub; }
         int getCategory() { return category; }
+        bool update(const CollectionItem *other) override;
 
     private:
         QString artistId;
@@ -162,6 +177,7 @@ public:
     QModelIndex findArtistIndex(const QString &artist);
     QSet<QString> getGenres() const;
     QSet<QString> getArtists() const;
+    QString resolveArtist(const QString &name) const;
     QList<Song> getAlbumTracks(const QString &artistId, const QString &albumId, int maxTracks=-1) const;
     QList<Song> getAlbumTracks(const Song &song, int maxTracks=-1) const { return getAlbumTracks(song.albumArtistOrComposer(), song.albumId(), maxTracks); }
     QList<Song> songs(const QStringList &files, bool allowPlaylists=false) const;
@@ -169,23 +185,56 @@ public:
     void getDetails(QSet<QString> &artists, QSet<QString> &albumArtists, QSet<QString> &composers, QSet<QString> &albums, QSet<QString> &genres);
     bool songExists(const Song &song);
     LibraryDb::Album getRandomAlbum(const QStringList &genres, const QStringList &artists) const { return db->getRandomAlbum(genres, artists); }
+    QList<LibraryDb::Album> getRandomAlbums(const QStringList &genres, const QStringList &artists, int count, bool weightByTracks=false) const
+        { return db->getRandomAlbums(genres, artists, count, weightByTracks); }
     int trackCount() const;
 
 Q_SIGNALS:
     void error(const QString &str);
+    // Re-emitted from LibraryDb, after this model has been updated
+    void libraryChanged(const LibraryDb::Changes &changes);
 
 public Q_SLOTS:
     void clearDb();
 
 protected Q_SLOTS:
     void libraryUpdated();
+    void applyChanges(const LibraryDb::Changes &changes);
+
+private Q_SLOTS:
+    void libraryRetrieved(const LibraryDb::ReadResult &result);
+    void emitQueuedDataChanged();
+
+protected:
+    QList<Item *> albumItems(const QString &artistId, const QString &albumId) const;
+    QList<Item *> artistItems(const QString &artistId) const { return artistItemIndex.values(artistId); }
+    void queueDataChanged(Item *item);
 
 private:
+    LibraryDb::ReadRequest topLevelRequest() const;
+    LibraryDb::ReadRequest childRequest(const CollectionItem *item) const;
+    CollectionItem * requestedItem(const LibraryDb::ReadResult &result) const;
+    void childrenRetrieved(const LibraryDb::ReadResult &result);
+    void addChildren(CollectionItem *item, const LibraryDb::ReadResult &result);
+    void fetchNow(const QModelIndex &index);
+    void regroup();
+    void readTopLevel();
+    QList<Item *> createItems(const LibraryDb::ReadResult &result, CollectionItem *parent);
+    bool mergeChildren(CollectionItem *parent, const QList<Item *> &items, int maxChanges=-1);
+    void mergeLoadedChildren(CollectionItem *item);
+    void mergeChanges(const LibraryDb::Changes &changes);
+    QList<Song> tracks(const CollectionItem *album) const;
+    void updateTracks(CollectionItem *album, const QSet<QString> &files);
+    void indexItem(Item *item);
+    void unindexItem(Item *item);
+    QString albumItemKey(const Item *item) const;
+    void clearItemIndex();
     void populate(const QModelIndexList &list) const;
     QModelIndexList children(const QModelIndex &parent) const;
     QList<Song> songs(const QModelIndex &idx, bool allowPlaylists) const;
     Item * toItem(const QModelIndex &index) const { return index.isValid() ? static_cast<Item*>(index.internalPointer()) : root; }
     virtual Song & fixPath(Song &s) const { return s; }
+    void checkCacheVersion() const;
 
 protected:
     Type tl;
@@ -194,6 +243,22 @@ protected:
     LibraryDb::AlbumSort librarySort;
     LibraryDb::AlbumSort albumSort;
     QStringList categories;
+
+private:
+    // Items removed by a merge are also removed from these, so the pointers always remain valid.
+    QMultiHash<QString, Item *> albumItemIndex;
+    QMultiHash<QString, Item *> artistItemIndex;
+    QSet<Item *> fetching; // Items whose children are being read by a worker
+    QSet<Item *> changedItems;
+    QTimer *changedTimer;
+    quint32 generation; // Of the latest top-level read request
+    bool resetPending; // Latest top-level read is to replace all items
+    bool mergePending; // Latest top-level read is to be merged with the current items
+    LibraryDb::Changes pendingChanges; // To be merged, once the top-level read has been retrieved
+    // Recently used track and album listings, as requested by the context view. Valid for cacheVersion only.
+    mutable time_t cacheVersion;
+    mutable QCache<QString, QList<Song> > albumTracksCache;
+    mutable QCache<QString, QList<LibraryDb::Album> > artistAlbumsCache;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "qtiocompressor/qtiocompressor.h"
 #include "config.h"
 #include "support/globalstatic.h"
+#include "support/thread.h"
 #include <QModelIndex>
 #include <QString>
 #include <QSet>
@@ -52,12 +53,14 @@
 #include <QUrl>
 #include <QUrlQuery>
 #include <QJsonDocument>
+#include <QBuffer>
 #if defined Q_OS_WIN
 #include <QCoreApplication>
 #endif
 #include <stdio.h>
 #include <time.h>
 #include <algorithm>
+#include <zlib.h>
 
 #include <QDebug>
 GLOBAL_STATIC(StreamsModel, instance)
@@ -480,6 +483,8 @@ NetworkJob * StreamsModel::ShoutCastCategoryItem::fetchSecondardyUrl()
 StreamsModel::StreamsModel(QObject *parent)
     : ActionModel(parent)
     , root(new CategoryItem(QString(), "root"))
+    , lastParseId(0)
+    , parser(nullptr)
 {
     QColor col = Utils::monoIconColor();
     icn=MonoIcon::icon(":radio.svg", col);
@@ -519,6 +524,10 @@ StreamsModel::StreamsModel(QObject *parent)
 
 StreamsModel::~StreamsModel()
 {
+    if (parser) {
+        parser->stop();
+        parser=nullptr;
+    }
     delete root;
 }
 
@@ -702,12 +711,14 @@ void StreamsModel::fetchMore(const QModelIndex &index)
                 emit loading();
             }
             jobs.insert(job, cat);
+            connect(job, SIGNAL(readyRead()), SLOT(jobData()));
             connect(job, SIGNAL(finished()), SLOT(jobFinished()));
             cat->state=CategoryItem::Fetching;
 
             job=cat->fetchSecondardyUrl();
             if (job) {
                 jobs.insert(job, cat);
+                connect(job, SIGNAL(readyRead()), SLOT(jobData()));
                 connect(job, SIGNAL(finished()), SLOT(jobFinished()));
             }
         }
@@ -985,6 +996,66 @@ bool StreamsModel::loadCache(CategoryItem *cat)
     return false;
 }
 
+int StreamsModel::parserType(NetworkJob *job, CategoryItem *cat) const
+{
+    if (cat==favourites || QLatin1String("http")!=job->url().scheme()) {
+        return StreamsParser::Type_None;
+    }
+    if (constRadioTimeHost==job->origUrl().host()) {
+        return StreamsParser::Type_RadioTime;
+    }
+    if (constIceCastUrl==job->origUrl().toString()) {
+        return StreamsParser::Type_IceCast;
+    }
+    if (constShoutCastHost==job->origUrl().host()) {
+        return StreamsParser::Type_ShoutCast;
+    }
+    return StreamsParser::Type_None;
+}
+
+quint32 StreamsModel::startParser(NetworkJob *job, int type)
+{
+    if (!parser) {
+        qRegisterMetaType<QList<StreamsModel::Item *> >("QList<StreamsModel::Item*>");
+        parser=new StreamsParser();
+        connect(this, SIGNAL(startParse(quint32,int,bool)), parser, SLOT(start(quint32,int,bool)), Qt::QueuedConnection);
+        connect(this, SIGNAL(parseData(quint32,QByteArray)), parser, SLOT(addData(quint32,QByteArray)), Qt::QueuedConnection);
+        connect(this, SIGNAL(parseFinish(quint32)), parser, SLOT(finish(quint32)), Qt::QueuedConnection);
+        connect(this, SIGNAL(parseCancel(quint32)), parser, SLOT(cancel(quint32)), Qt::QueuedConnection);
+        connect(parser, SIGNAL(parsed(quint32,QList<StreamsModel::Item*>)), this, SLOT(parsed(quint32,QList<StreamsModel::Item*>)), Qt::QueuedConnection);
+    }
+
+    // IceCast's yp.xml is served gzip'ed, unless its content-type states otherwise
+    bool gzipped=StreamsParser::Type_IceCast==type && job->actualJob() && "application/xml"!=job->actualJob()->rawHeader("Content-Type");
+    quint32 id=++lastParseId;
+    parseIds.insert(job, id);
+    emit startParse(id, type, gzipped);
+    return id;
+}
+
+void StreamsModel::jobData()
+{
+    NetworkJob *job=dynamic_cast<NetworkJob *>(sender());
+
+    if (!job || !jobs.contains(job) || !jobs[job]) {
+        return;
+    }
+
+    quint32 id=parseIds.value(job, 0);
+    if (!id) {
+        int type=parserType(job, jobs[job]);
+        if (StreamsParser::Type_None==type) {
+            // Not a directory listing, leave data in the reply...
+            return;
+        }
+        id=startParser(job, type);
+    }
+    QByteArray data=job->readAll();
+    if (!data.isEmpty()) {
+        emit parseData(id, data);
+    }
+}
+
 void StreamsModel::jobFinished()
 {
     NetworkJob *job=dynamic_cast<NetworkJob *>(sender());
@@ -994,6 +1065,7 @@ void StreamsModel::jobFinished()
     }
 
     job->deleteLater();
+    quint32 parseId=parseIds.take(job);
     if (jobs.contains(job)) {
         CategoryItem *cat=jobs[job];
         if (!cat) {
@@ -1001,90 +1073,127 @@ void StreamsModel::jobFinished()
         }
         jobs.remove(job);
 
-        // ShoutCast has two jobs when listing a category - child categories and station list.
-        // So, only set as fetched if both are finished.
-        bool haveOtherJob=false;
-        for (CategoryItem *c: jobs.values()) {
+        if (job->ok()) {
+            if (!parseId) {
+                int type=parserType(job, cat);
+                if (StreamsParser::Type_None!=type) {
+                    parseId=startParser(job, type);
+                }
+            }
+            if (parseId) {
+                // Remaining items will be added once parser has completed...
+                QByteArray data=job->readAll();
+                if (!data.isEmpty()) {
+                    emit parseData(parseId, data);
+                }
+                parsing.insert(parseId, cat);
+                emit parseFinish(parseId);
+                return;
+            }
+        } else {
+            if (parseId) {
+                emit parseCancel(parseId);
+            }
+            if (constShoutCastHost==job->origUrl().host()) {
+                ApiKeys::self()->isLimitReached(job->actualJob(), ApiKeys::ShoutCast);
+            }
+        }
+        categoryFetched(cat, QList<Item *>(), job->ok());
+    } else if (parseId) {
+        emit parseCancel(parseId);
+    }
+}
+
+void StreamsModel::parsed(quint32 id, const QList<StreamsModel::Item *> &items)
+{
+    CategoryItem *cat=parsing.take(id);
+    if (!cat) {
+        qDeleteAll(items);
+        return;
+    }
+    for (Item *i: items) {
+        i->parent=cat;
+    }
+    categoryFetched(cat, items, true);
+}
+
+void StreamsModel::categoryFetched(CategoryItem *cat, QList<Item *> newItems, bool ok)
+{
+    // ShoutCast has two jobs when listing a category - child categories and station list.
+    // So, only set as fetched if both are finished.
+    bool haveOtherJob=false;
+    for (CategoryItem *c: jobs.values()) {
+        if (c==cat) {
+            haveOtherJob=true;
+            break;
+        }
+    }
+    if (!haveOtherJob) {
+        for (CategoryItem *c: parsing.values()) {
             if (c==cat) {
                 haveOtherJob=true;
                 break;
             }
         }
+    }
 
-        if (!haveOtherJob) {
-            cat->state=CategoryItem::Fetched;
-        }
+    if (!haveOtherJob) {
+        cat->state=CategoryItem::Fetched;
+    }
 
-        QModelIndex index=createIndex(cat->parent->children.indexOf(cat), 0, (void *)cat);
-        QString url=job->origUrl().toString();
+    QModelIndex index=createIndex(cat->parent->children.indexOf(cat), 0, (void *)cat);
 
-        if (job->ok()) {
-            QList<Item *> newItems;
-            if (cat!=favourites && QLatin1String("http")==job->url().scheme()) {
-                if (constRadioTimeHost==job->origUrl().host()) {
-                    newItems=parseRadioTimeResponse(job->actualJob(), cat);
-                } else if (constIceCastUrl==url) {
-                    newItems=parseIceCastResponse(job->actualJob(), cat);
-                } else if (constShoutCastHost==job->origUrl().host()) {
-                    newItems=parseShoutCastResponse(job->actualJob(), cat);
-                }
-            }
+    if (ok) {
+        if (cat->parent==root && cat->supportsBookmarks) {
+            QList<Item *> bookmarks=cat->loadBookmarks();
+            if (bookmarks.count()) {
+                CategoryItem *bookmarksCat=cat->getBookmarksCategory();
 
-            if (cat->parent==root && cat->supportsBookmarks) {
-                QList<Item *> bookmarks=cat->loadBookmarks();
-                if (bookmarks.count()) {
-                    CategoryItem *bookmarksCat=cat->getBookmarksCategory();
-
-                    if (bookmarksCat) {
-                        QList<Item *> newBookmarks;
-                        for (Item *bm: bookmarks) {
-                            for (Item *ex: bookmarksCat->children) {
-                                if (ex->fullUrl()==bm->fullUrl()) {
-                                    delete bm;
-                                    bm=nullptr;
-                                    break;
-                                }
+                if (bookmarksCat) {
+                    QList<Item *> newBookmarks;
+                    for (Item *bm: bookmarks) {
+                        for (Item *ex: bookmarksCat->children) {
+                            if (ex->fullUrl()==bm->fullUrl()) {
+                                delete bm;
+                                bm=nullptr;
+                                break;
                             }
-                            if (bm) {
-                                newBookmarks.append(bm);
-                                bm->parent=bookmarksCat;
-                            }
-                        }
-                        if (newBookmarks.count()) {
-                            QModelIndex index=createIndex(bookmarksCat->parent->children.indexOf(bookmarksCat), 0, (void *)bookmarksCat);
-                            beginInsertRows(index, bookmarksCat->children.count(), (bookmarksCat->children.count()+newBookmarks.count())-1);
-                            bookmarksCat->children+=newBookmarks;
-                            endInsertRows();
                         }
-                    } else {
-                        bookmarksCat=cat->createBookmarksCategory();
-                        for (Item *i: bookmarks) {
-                            i->parent=bookmarksCat;
+                        if (bm) {
+                            newBookmarks.append(bm);
+                            bm->parent=bookmarksCat;
                         }
-                        bookmarksCat->children=bookmarks;
-                        newItems.append(bookmarksCat);
                     }
+                    if (newBookmarks.count()) {
+                        QModelIndex index=createIndex(bookmarksCat->parent->children.indexOf(bookmarksCat), 0, (void *)bookmarksCat);
+                        beginInsertRows(index, bookmarksCat->children.count(), (bookmarksCat->children.count()+newBookmarks.count())-1);
+                        bookmarksCat->children+=newBookmarks;
+                        endInsertRows();
+                    }
+                } else {
+                    bookmarksCat=cat->createBookmarksCategory();
+                    for (Item *i: bookmarks) {
+                        i->parent=bookmarksCat;
+                    }
+                    bookmarksCat->children=bookmarks;
+                    newItems.append(bookmarksCat);
                 }
             }
-            
-            if (!newItems.isEmpty()) {
-                beginInsertRows(index, cat->children.count(), (cat->children.count()+newItems.count())-1);
-                cat->children+=newItems;
-                endInsertRows();
-                if (cat!=favourites) {
-                    cat->saveCache();
-                }
-            }
-        } else {
-            if (constShoutCastHost==job->origUrl().host()) {
-                ApiKeys::self()->isLimitReached(job->actualJob(), ApiKeys::ShoutCast);
-            }
         }
-        emit dataChanged(index, index);
-        if (jobs.isEmpty()) {
-            emit loaded();
+        
+        if (!newItems.isEmpty()) {
+            beginInsertRows(index, cat->children.count(), (cat->children.count()+newItems.count())-1);
+            cat->children+=newItems;
+            endInsertRows();
+            if (cat!=favourites) {
+                cat->saveCache();
+            }
         }
     }
+    emit dataChanged(index, index);
+    if (jobs.isEmpty() && parsing.isEmpty()) {
+        emit loaded();
+    }
 }
 
 void StreamsModel::savedFavouriteStream(const QString &url, const QString &name)
@@ -1264,79 +1373,6 @@ static void trimGenres(QMap<QString, QList<StreamsModel::Item *> > &genres)
     }
 }
 
-QList<StreamsModel::Item *> StreamsModel::parseIceCastResponse(QIODevice *dev, CategoryItem *cat)
-{
-    bool isGZipped = true;
-    QNetworkReply *nr = qobject_cast<QNetworkReply *>(dev);
-    if (nr) {
-        const auto hdr = nr->rawHeader("Content-Type");
-        if ("application/xml"==hdr) {
-            isGZipped = false;
-        }
-    }
-    QList<Item *> newItems;
-    QtIOCompressor *compressor = nullptr;
-    QIODevice *readDev = dev;
-
-    if (isGZipped) {
-        compressor = new QtIOCompressor(dev);
-        compressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        compressor->open(QIODevice::ReadOnly);
-        readDev = compressor;
-    }
-    QXmlStreamReader doc(readDev);
-    QSet<QString> names;
-    QMap<QString, QList<Item *> > genres;
-    while (!doc.atEnd()) {
-        doc.readNext();
-        if (doc.isStartElement() && QLatin1String("entry")==doc.name()) {
-            QString name;
-            QString url;
-            QStringList stationGenres;
-            while (!doc.atEnd()) {
-                doc.readNext();
-
-                if (QXmlStreamReader::StartElement==doc.tokenType()) {
-                    QStringRef elem = doc.name();
-
-                    if (QLatin1String("server_name")==elem) {
-                        name=doc.readElementText().trimmed();
-                    } else if (QLatin1String("listen_url")==elem) {
-                        url=doc.readElementText().trimmed();
-                    } else if (QLatin1String("genre")==elem) {
-                        stationGenres=fixGenres(doc.readElementText().trimmed());
-                    }
-                } else if (doc.isEndElement() && QLatin1String("entry")==doc.name()) {
-                    break;
-                }
-            }
-
-            if (!name.isEmpty() && !url.isEmpty() && !names.contains(name)) {
-                names.insert(name);
-                for (const QString &g: stationGenres) {
-                    genres[g].append(new Item(url, name, cat));
-                }
-            }
-        }
-    }
-    trimGenres(genres);
-    QMap<QString, QList<Item *> >::ConstIterator it(genres.constBegin());
-    QMap<QString, QList<Item *> >::ConstIterator end(genres.constEnd());
-
-    for (; it!=end; ++it) {
-        CategoryItem *genre=new CategoryItem(QString(), it.key(), cat);
-        genre->state=CategoryItem::Fetched;
-        for (Item *i: it.value()) {
-            i->parent=genre;
-            genre->children.append(i);
-        }
-        newItems.append(genre);
-    }
-
-    delete compressor;
-    return newItems;
-}
-
 QList<StreamsModel::Item *> StreamsModel::parseShoutCastSearchResponse(QIODevice *dev, CategoryItem *cat)
 {
     QList<Item *> newItems;
@@ -1479,4 +1515,236 @@ QString StreamsModel::modifyUrl(const QString &u, bool addPrefix, const QString
     return MPDParseUtils::addStreamName(!addPrefix || !u.startsWith("http:") ? u : (constPrefix+u), name);
 }
 
+static const int constInflateChunk=64*1024;
+
+struct StreamsParser::Job
+{
+    enum Field {
+        Field_None,
+        Field_Name,
+        Field_Url,
+        Field_Genre
+    };
+
+    Job(int t, bool gz)
+        : type(t), gzipped(gz), inflating(false), zs(), inEntry(false), field(Field_None) {
+        if (gzipped) {
+            // 16+MAX_WBITS => expect a gzip header
+            inflating=Z_OK==inflateInit2(&zs, 16+MAX_WBITS);
+        }
+    }
+    ~Job() {
+        if (inflating) {
+            inflateEnd(&zs);
+        }
+        QMap<QString, QList<StreamsModel::Item *> >::ConstIterator it(genres.constBegin());
+        QMap<QString, QList<StreamsModel::Item *> >::ConstIterator end(genres.constEnd());
+        for (; it!=end; ++it) {
+            qDeleteAll(it.value());
+        }
+    }
+
+    int type;
+    bool gzipped;
+    bool inflating;
+    z_stream zs;
+    QXmlStreamReader reader;
+    QByteArray data; // TuneIn and ShoutCast responses are small, so these are parsed once complete
+
+    // IceCast entry state - retained between chunks
+    bool inEntry;
+    Field field;
+    QString text;
+    QString name;
+    QString url;
+    QStringList stationGenres;
+    QSet<QString> names;
+    QMap<QString, QList<StreamsModel::Item *> > genres;
+};
+
+StreamsParser::StreamsParser()
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+StreamsParser::~StreamsParser()
+{
+    qDeleteAll(jobs);
+}
+
+void StreamsParser::stop()
+{
+    thread->stop();
+}
+
+void StreamsParser::start(quint32 id, int type, bool gzipped)
+{
+    delete jobs.take(id);
+    jobs.insert(id, new Job(type, gzipped));
+}
+
+void StreamsParser::addData(quint32 id, const QByteArray &data)
+{
+    Job *job=jobs.value(id);
+    if (!job) {
+        return;
+    }
+
+    if (Type_IceCast==job->type) {
+        if (job->gzipped) {
+            decompress(job, data);
+        } else {
+            job->reader.addData(data);
+        }
+        parseIceCast(job);
+    } else {
+        job->data+=data;
+    }
+}
+
+void StreamsParser::finish(quint32 id)
+{
+    Job *job=jobs.take(id);
+    if (!job) {
+        emit parsed(id, QList<StreamsModel::Item *>());
+        return;
+    }
+
+    QList<StreamsModel::Item *> items;
+    switch (job->type) {
+    case Type_IceCast:
+        parseIceCast(job);
+        items=iceCastGenres(job);
+        break;
+    case Type_RadioTime:
+    case Type_ShoutCast: {
+        QBuffer buffer(&job->data);
+        buffer.open(QIODevice::ReadOnly);
+        items=Type_RadioTime==job->type
+                ? StreamsModel::parseRadioTimeResponse(&buffer, nullptr)
+                : StreamsModel::parseShoutCastResponse(&buffer, nullptr);
+        break;
+    }
+    default:
+        break;
+    }
+    delete job;
+    emit parsed(id, items);
+}
+
+void StreamsParser::cancel(quint32 id)
+{
+    delete jobs.take(id);
+}
+
+void StreamsParser::decompress(Job *job, const QByteArray &data)
+{
+    if (!job->inflating) {
+        return;
+    }
+
+    QByteArray out(constInflateChunk, Qt::Uninitialized);
+    job->zs.next_in=(Bytef *)data.constData();
+    job->zs.avail_in=data.size();
+    do {
+        job->zs.next_out=(Bytef *)out.data();
+        job->zs.avail_out=out.size();
+        int rv=inflate(&job->zs, Z_NO_FLUSH);
+        if (Z_OK!=rv && Z_STREAM_END!=rv && Z_BUF_ERROR!=rv) {
+            inflateEnd(&job->zs);
+            job->inflating=false;
+            return;
+        }
+        int have=out.size()-job->zs.avail_out;
+        if (have>0) {
+            job->reader.addData(QByteArray(out.constData(), have));
+        }
+        if (Z_STREAM_END==rv) {
+            inflateEnd(&job->zs);
+            job->inflating=false;
+            return;
+        }
+    } while (0==job->zs.avail_out);
+}
+
+// Token based, so that parsing can stop at the end of the currently available data and resume once more has arrived
+void StreamsParser::parseIceCast(Job *job)
+{
+    QXmlStreamReader &doc=job->reader;
+    while (!doc.atEnd()) {
+        switch (doc.readNext()) {
+        case QXmlStreamReader::StartElement: {
+            QStringRef elem=doc.name();
+            if (QLatin1String("entry")==elem) {
+                job->inEntry=true;
+                job->field=Job::Field_None;
+                job->name.clear();
+                job->url.clear();
+                job->stationGenres.clear();
+            } else if (job->inEntry) {
+                job->field=QLatin1String("server_name")==elem
+                            ? Job::Field_Name
+                            : QLatin1String("listen_url")==elem
+                                ? Job::Field_Url
+                                : QLatin1String("genre")==elem
+                                    ? Job::Field_Genre
+                                    : Job::Field_None;
+                job->text.clear();
+            }
+            break;
+        }
+        case QXmlStreamReader::Characters:
+            if (Job::Field_None!=job->field) {
+                job->text+=doc.text();
+            }
+            break;
+        case QXmlStreamReader::EndElement:
+            if (Job::Field_None!=job->field) {
+                switch (job->field) {
+                case Job::Field_Name:  job->name=job->text.trimmed(); break;
+                case Job::Field_Url:   job->url=job->text.trimmed(); break;
+                case Job::Field_Genre: job->stationGenres=fixGenres(job->text.trimmed()); break;
+                default: break;
+                }
+                job->field=Job::Field_None;
+            } else if (job->inEntry && QLatin1String("entry")==doc.name()) {
+                job->inEntry=false;
+                if (!job->name.isEmpty() && !job->url.isEmpty() && !job->names.contains(job->name)) {
+                    job->names.insert(job->name);
+                    for (const QString &g: job->stationGenres) {
+                        job->genres[g].append(new StreamsModel::Item(job->url, job->name));
+                    }
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+QList<StreamsModel::Item *> StreamsParser::iceCastGenres(Job *job)
+{
+    QList<StreamsModel::Item *> newItems;
+    trimGenres(job->genres);
+    QMap<QString, QList<StreamsModel::Item *> >::ConstIterator it(job->genres.constBegin());
+    QMap<QString, QList<StreamsModel::Item *> >::ConstIterator end(job->genres.constEnd());
+
+    for (; it!=end; ++it) {
+        StreamsModel::CategoryItem *genre=new StreamsModel::CategoryItem(QString(), it.key());
+        genre->state=StreamsModel::CategoryItem::Fetched;
+        genre->children.reserve(it.value().count());
+        for (StreamsModel::Item *i: it.value()) {
+            i->parent=genre;
+            genre->children.append(i);
+        }
+        newItems.append(genre);
+    }
+    // Items now owned by genre categories...
+    job->genres.clear();
+    return newItems;
+}
+
 #include "moc_streamsmodel.cpp"
@@ -41,6 +41,8 @@ class NetworkJob;
 class QNetworkRequest;
 class QXmlStreamReader;
 class QIODevice;
+class StreamsParser;
+class Thread;
 
 class StreamsModel : public ActionModel
 {
@@ -244,18 +246,25 @@ Q_SIGNALS:
     void favouritesLoaded();
     void addedToFavourites(const QString &name);
 
+    // Directory parsing, performed by StreamsParser...
+    void startParse(quint32 id, int type, bool gzipped);
+    void parseData(quint32 id, const QByteArray &data);
+    void parseFinish(quint32 id);
+    void parseCancel(quint32 id);
+
 public:
     static QList<Item *> parseRadioTimeResponse(QIODevice *dev, CategoryItem *cat, bool parseSubText=false);
-    static QList<Item *> parseIceCastResponse(QIODevice *dev, CategoryItem *cat);
     static QList<Item *> parseShoutCastSearchResponse(QIODevice *dev, CategoryItem *cat);
-    QList<Item *> parseShoutCastResponse(QIODevice *dev, CategoryItem *cat);
+    static QList<Item *> parseShoutCastResponse(QIODevice *dev, CategoryItem *cat);
     static QList<Item *> parseShoutCastLinks(QXmlStreamReader &doc, CategoryItem *cat);
     static QList<Item *> parseShoutCastStations(QXmlStreamReader &doc, CategoryItem *cat);
     static QList<Item *> parseCommunityStations(QIODevice *dev, CategoryItem *cat);
     static Item * parseRadioTimeEntry(QXmlStreamReader &doc, CategoryItem *parent, bool parseSubText=false);
 
 private Q_SLOTS:
+    void jobData();
     void jobFinished();
+    void parsed(quint32 id, const QList<StreamsModel::Item *> &items);
 
     // Responses from MPD...
     void savedFavouriteStream(const QString &url, const QString &name);
@@ -265,6 +274,9 @@ private Q_SLOTS:
     void mpdConnectionState(bool c);
 
 private:
+    int parserType(NetworkJob *job, CategoryItem *cat) const;
+    quint32 startParser(NetworkJob *job, int type);
+    void categoryFetched(CategoryItem *cat, QList<Item *> newItems, bool ok);
     bool loadCache(CategoryItem *cat);
     Item * toItem(const QModelIndex &index) const { return index.isValid() ? static_cast<Item*>(index.internalPointer()) : root; }
     void loadInstalledProviders();
@@ -281,6 +293,49 @@ private:
     Action *reloadAction;
     QList<Item *> hiddenCategories;
     QIcon icn;
+    QMap<NetworkJob *, quint32> parseIds;
+    QMap<quint32, CategoryItem *> parsing; // Jobs whose response is still being parsed
+    quint32 lastParseId;
+    StreamsParser *parser;
+};
+
+// Parses TuneIn, IceCast, and ShoutCast directory listings in a background thread. Data is passed in as it
+// is downloaded, so (for IceCast) decompression and XML parsing overlap with the download. Parsed items are
+// created without a parent - the model sets this when they are inserted.
+class StreamsParser : public QObject
+{
+    Q_OBJECT
+public:
+    enum Type {
+        Type_None,
+        Type_RadioTime,
+        Type_IceCast,
+        Type_ShoutCast
+    };
+
+    StreamsParser();
+    ~StreamsParser() override;
+
+    void stop();
+
+Q_SIGNALS:
+    void parsed(quint32 id, const QList<StreamsModel::Item *> &items);
+
+public Q_SLOTS:
+    void start(quint32 id, int type, bool gzipped);
+    void addData(quint32 id, const QByteArray &data);
+    void finish(quint32 id);
+    void cancel(quint32 id);
+
+private:
+    struct Job;
+    void decompress(Job *job, const QByteArray &data);
+    void parseIceCast(Job *job);
+    QList<StreamsModel::Item *> iceCastGenres(Job *job);
+
+private:
+    Thread *thread;
+    QMap<quint32, Job *> jobs;
 };
 
 #endif
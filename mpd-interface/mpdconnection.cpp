@@ -42,6 +42,9 @@
 #include <QPropertyAnimation>
 #include <QCoreApplication>
 #include <QUdpSocket>
+#include <QFile>
+#include <QMutex>
+#include <QElapsedTimer>
 #include <complex>
 #include "support/thread.h"
 #include "cuefile.h"
@@ -61,12 +64,66 @@ void MPDConnection::enableDebug()
     debugEnabled=true;
 }
 
+// Protocol trace. Each entry is a header line - "<type> <ms since start> [<duration ms>] <num bytes>" - followed by
+// the raw bytes, and a newline. Types are; G - greeting from a new connection, C - command (on either socket, the
+// password is not recorded), R - reply to the preceding command (duration is the round trip time, if sent via
+// sendCommand()), I - data read asynchronously from the idle socket (i.e. the response to "idle"/"noidle").
+// These can be served by cantata-replay (see bench/)
+static QFile *traceFile=nullptr;
+static QElapsedTimer traceTimer;
+static QMutex traceMutex;
+
+void MPDConnection::enableTrace(const QString &fileName)
+{
+    QMutexLocker locker(&traceMutex);
+    if (traceFile) {
+        return;
+    }
+    traceFile=new QFile(fileName);
+    if (!traceFile->open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+        qWarning() << "Failed to open MPD trace file" << fileName;
+        delete traceFile;
+        traceFile=nullptr;
+        return;
+    }
+    traceFile->write("# Cantata MPD trace 2\n");
+    traceTimer.start();
+}
+
+static void trace(char type, const QByteArray &data, qint64 duration=-1)
+{
+    if (!traceFile) {
+        return;
+    }
+    QMutexLocker locker(&traceMutex);
+    QByteArray header(1, type);
+    header+=' '+QByteArray::number(traceTimer.elapsed());
+    if (duration>=0) {
+        header+=' '+QByteArray::number(duration);
+    }
+    header+=' '+QByteArray::number(data.length())+'\n';
+    traceFile->write(header);
+    traceFile->write(data);
+    traceFile->write("\n", 1);
+    traceFile->flush();
+}
+
+// Write a command directly to a socket, i.e. not via sendCommand(), recording this in any trace.
+static int writeCommand(MpdSocket &socket, const QByteArray &command)
+{
+    trace('C', command);
+    return socket.write(command+'\n');
+}
+
 // Uncomment the following to report error strings in MPDStatus to the UI
 // ...disabled, as stickers (for ratings) can cause lots of errors to be reported - and these all need clearing, etc.
 // #define REPORT_MPD_ERRORS
 static const int constSocketCommsTimeout=2000;
 static const int constMaxReadAttempts=4;
 static const int constMaxFilesPerAddCommand=2000;
+// Largest folder to list with a single "listall". Each path is typically 100-200 bytes, so this keeps the
+// response well within MPD's default 8MiB max_output_buffer_size.
+static const int constMaxListAllFiles=20000;
 static const int constConnTimer=5000;
 
 static const QByteArray constOkValue("OK");
@@ -109,6 +166,9 @@ GLOBAL_STATIC(MPDConnection, instance)
 
 const QString MPDConnection::constModifiedSince=QLatin1String("modified-since");
 const int MPDConnection::constMaxPqChanges=1000;
+const int MPDConnection::constPagedPlayQueueLength=20000;
+const int MPDConnection::constPlayQueuePageSize=250;
+const int MPDConnection::constCoalesceInterval=50;
 const QString MPDConnection::constStreamsPlayListName=QLatin1String("[Radio Streams]");
 const QString MPDConnection::constPlaylistPrefix=QLatin1String("playlist:");
 const QString MPDConnection::constDirPrefix=QLatin1String("dir:");
@@ -259,6 +319,8 @@ MPDConnection::MPDConnection()
     , idleSocket(this)
     , lastStatusPlayQueueVersion(0)
     , lastUpdatePlayQueueVersion(0)
+    , pagedPlayQueue(false)
+    , lastPlayQueueLength(-1)
     , state(State_Blank)
     , isListingMusic(false)
     , reconnectTimer(nullptr)
@@ -271,6 +333,10 @@ MPDConnection::MPDConnection()
     , volumeFade(nullptr)
     , fadeDuration(0)
     , restoreVolume(-1)
+    , coalesceTimer(nullptr)
+    , coalescedSeekId(-1)
+    , coalescedSeekTime(0)
+    , statusDeferred(false)
 {
     qRegisterMetaType<time_t>("time_t");
     qRegisterMetaType<Song>("Song");
@@ -321,6 +387,9 @@ void MPDConnection::start()
         moveToThread(thread);
         connect(thread, SIGNAL(finished()), connTimer, SLOT(stop()));
         connect(connTimer, SIGNAL(timeout()), SLOT(getStatus()));
+        coalesceTimer=thread->createTimer(this);
+        coalesceTimer->setSingleShot(true);
+        connect(coalesceTimer, SIGNAL(timeout()), SLOT(sendCoalescedCommands()));
         thread->start();
     }
 }
@@ -337,6 +406,8 @@ void MPDConnection::stop()
     if (thread) {
         thread->deleteTimer(connTimer);
         connTimer=nullptr;
+        thread->deleteTimer(coalesceTimer);
+        coalesceTimer=nullptr;
         thread->stop();
         thread=nullptr;
     }
@@ -362,6 +433,7 @@ MPDConnection::ConnectionReturn MPDConnection::connectToMPD(MpdSocket &socket, b
         if (socket.waitForConnected(constSocketCommsTimeout)) {
             DBUG << (void *)(&socket) << "established";
             QByteArray recvdata = readFromSocket(socket);
+            trace('G', recvdata);
 
             if (recvdata.isEmpty()) {
                 DBUG << (void *)(&socket) << "Couldn't connect";
@@ -398,9 +470,11 @@ MPDConnection::ConnectionReturn MPDConnection::connectToMPD(MpdSocket &socket, b
 
             if (!details.partition.isEmpty()) {
                 DBUG << (void *)(&socket) << "setting partition...";
-                socket.write("partition "+encodeName(details.partition)+'\n');
+                writeCommand(socket, "partition "+encodeName(details.partition));
                 socket.waitForBytesWritten(constSocketCommsTimeout);
-                if (!readReply(socket).ok) {
+                Response response=readReply(socket);
+                trace('R', response.data);
+                if (!response.ok) {
                     DBUG << (void *)(&socket) << "partition rejected, staying on default";
                 }
             }
@@ -411,7 +485,7 @@ MPDConnection::ConnectionReturn MPDConnection::connectToMPD(MpdSocket &socket, b
                 connect(&socket, SIGNAL(readyRead()), this, SLOT(idleDataReady()), Qt::QueuedConnection);
                 connect(&socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), this, SLOT(onSocketStateChanged(QAbstractSocket::SocketState)), Qt::QueuedConnection);
                 DBUG << (void *)(&socket) << "Enabling idle";
-                socket.write("idle\n");
+                writeCommand(socket, "idle");
                 socket.waitForBytesWritten();
             }
             return Success;
@@ -494,6 +568,11 @@ void MPDConnection::disconnectFromMPD()
 {
     DBUG << "disconnectFromMPD";
     connTimer->stop();
+    if (coalesceTimer) {
+        coalesceTimer->stop();
+    }
+    coalescedCommands.clear();
+    statusDeferred=false;
     disconnect(&idleSocket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), this, SLOT(onSocketStateChanged(QAbstractSocket::SocketState)));
     disconnect(&idleSocket, SIGNAL(readyRead()), this, SLOT(idleDataReady()));
     if (QAbstractSocket::ConnectedState==sock.state()) {
@@ -507,9 +586,11 @@ void MPDConnection::disconnectFromMPD()
     state=State_Disconnected;
     ver=0;
     playQueueIds.clear();
+    playQueueTimes.clear();
     streamIds.clear();
     lastStatusPlayQueueVersion=0;
     lastUpdatePlayQueueVersion=0;
+    lastPlayQueueLength=-1;
     currentSongId=0;
     songPos=0;
     serverInfo.reset();
@@ -541,12 +622,14 @@ void MPDConnection::reconnect()
         }
         serverInfo.detect();
         listPartitions();
+        // Read play queue before status, otherwise getStatus() sees that the (cleared) list of IDs does
+        // not match the play queue length and reads the play queue itself - which would then be read again.
+        playListInfo();
         getStatus();
         getStats();
         getUrlHandlers();
         getTagTypes();
         getStickerSupport();
-        playListInfo();
         outputs();
         reconnectStart=0;
         determineIfaceIp();
@@ -635,12 +718,12 @@ void MPDConnection::setDetails(const MPDConnectionDetails &d)
             }
             serverInfo.detect();
             listPartitions();
+            playListInfo(); // Before getStatus(), see reconnect()
             getStatus();
             getStats();
             getUrlHandlers();
             getTagTypes();
             getStickerSupport();
-            playListInfo();
             outputs();
             determineIfaceIp();
             emit stateChanged(true);
@@ -677,6 +760,10 @@ void MPDConnection::setDetails(const MPDConnectionDetails &d)
 MPDConnection::Response MPDConnection::sendCommand(const QByteArray &command, bool emitErrors, bool retry)
 {
     connTimer->stop();
+    if (!coalescedCommands.isEmpty()) {
+        // Preserve command order - send any pending volume, seek, etc. first.
+        sendCoalescedCommands();
+    }
     static bool reconnected=false; // If we reconnect, and send playlistinfo - dont want that call causing reconnects, and recursion!
     DBUG << (void *)(&sock) << "sendCommand:" << log(command) << emitErrors << retry;
 
@@ -707,6 +794,11 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray &command, bo
     }
 
     Response response;
+    QElapsedTimer roundTrip;
+    if (traceFile) {
+        trace('C', command);
+        roundTrip.start();
+    }
     if (-1==sock.write(command+'\n')) {
         DBUG << "Failed to write";
         // If we fail to write, dont wait for bytes to be written!!
@@ -719,6 +811,9 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray &command, bo
         DBUG << "Socket state after write:" << (int)sock.state();
         response=readReply(sock, timeout);
     }
+    if (traceFile) {
+        trace('R', response.data, roundTrip.elapsed());
+    }
 
     if (!response.ok) {
         DBUG << log(command) << "failed";
@@ -1109,9 +1204,19 @@ void MPDConnection::playListChanges()
     Response response=sendCommand(data, false);
     if (response.ok && status.ok && isPlayQueueIdValid()) {
         MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
+        lastPlayQueueLength=sv.playlistLength;
         if (lastUpdatePlayQueueVersion==sv.playlist) {
             return; // Playlist is already up-to-date
         }
+        if (pagedPlayQueue || sv.playlistLength>=(quint32)constPagedPlayQueueLength) {
+            // Switching between normal and paged modes requires a complete update.
+            if (pagedPlayQueue && sv.playlistLength>=(quint32)(constPagedPlayQueueLength/2)) {
+                pagedPlayListChanges(sv, response.data);
+            } else {
+                playListInfo();
+            }
+            return;
+        }
         lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
         emitStatusUpdated(sv);
         QList<MPDParseUtils::IdPos> changes=MPDParseUtils::parseChanges(response.data);
@@ -1216,8 +1321,25 @@ void MPDConnection::playListChanges()
 
 void MPDConnection::playListInfo()
 {
+    // Only check the length first if it is unknown, or the last status showed a large play queue. Status
+    // is always read after a full "playlistinfo", so a play queue that has grown will be paged next time.
+    Response status;
+    if (lastPlayQueueLength<0 || lastPlayQueueLength>=constPagedPlayQueueLength/2) {
+        status=sendCommand("status");
+        if (status.ok) {
+            MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
+            lastPlayQueueLength=sv.playlistLength;
+            if (sv.playlistLength>=(quint32)constPagedPlayQueueLength) {
+                pagedPlayListInfo(sv);
+                return;
+            }
+        }
+    }
+
     Response response=sendCommand("playlistinfo");
     QList<Song> songs;
+    pagedPlayQueue=false;
+    playQueueTimes.clear();
     if (response.ok) {
         lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion;
         songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue);
@@ -1241,7 +1363,7 @@ void MPDConnection::playListInfo()
         if (songs.isEmpty()) {
             stopVolumeFade();
         }
-        Response status=sendCommand("status");
+        status=sendCommand("status");
         if (status.ok) {
             MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
             lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
@@ -1251,12 +1373,194 @@ void MPDConnection::playListInfo()
     emit playlistUpdated(songs, true);
 }
 
+/*
+ * For very large play queues, only the ids and durations of the songs are kept. The full details are
+ * read page by page, so that the response data and parsed songs never exceed a page in size. Song
+ * details are then retrieved, as required, via playListRange()
+ */
+void MPDConnection::pagedPlayListInfo(MPDStatusValues &sv)
+{
+    DBUG << "pagedPlayListInfo" << sv.playlistLength;
+    QList<qint32> ids;
+    QList<quint32> times;
+    QSet<qint32> strmIds;
+    QList<Song> cStreams;
+
+    ids.reserve(sv.playlistLength);
+    times.reserve(sv.playlistLength);
+    for (quint32 start=0; start<sv.playlistLength; start+=constPlayQueuePageSize) {
+        QByteArray cmd="playlistinfo "+quote(start)+':'+quote(start+constPlayQueuePageSize);
+        Response response=sendCommand(cmd, false);
+        if (!response.ok) {
+            // Try once more, as sendCommand() will have reconnected if the connection was lost
+            response=sendCommand(cmd, false);
+        }
+        if (!response.ok) {
+            // Play queue is not updated, so ensure that the next change causes a complete reload.
+            DBUG << "Failed to read play queue page" << start;
+            lastUpdatePlayQueueVersion=0;
+            QString err=response.getError(cmd);
+            emit error(err.isEmpty() ? tr("Failed to read play queue.") : tr("Failed to read play queue. MPD reported the following error: %1").arg(err));
+            return;
+        }
+        QList<Song> songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue);
+        if (songs.isEmpty()) {
+            break;
+        }
+        for (const Song &s: songs) {
+            ids.append(s.id);
+            times.append(s.time);
+            if (s.isCdda()) {
+                cStreams.append(s);
+            } else if (s.isStream()) {
+                if (s.isCantataStream()) {
+                    cStreams.append(s);
+                } else {
+                    strmIds.insert(s.id);
+                }
+            }
+        }
+    }
+
+    // Use the version from *before* the pages were read, so that any changes made whilst reading
+    // will be picked up by the next call to playListChanges()
+    pagedPlayQueue=true;
+    playQueueIds=ids;
+    playQueueTimes=times;
+    streamIds=strmIds;
+    lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
+    emitStatusUpdated(sv);
+    emit cantataStreams(cStreams, false);
+    emit playlistPagedUpdated(ids, times);
+}
+
+/*
+ * Positions that are not listed by "plchangesposid" still hold the same song, so apply the
+ * changes to the current id list. Only songs that are new to the play queue need to be read.
+ */
+void MPDConnection::pagedPlayListChanges(MPDStatusValues &sv, const QByteArray &changesData)
+{
+    QList<MPDParseUtils::IdPos> changes=MPDParseUtils::parseChanges(changesData);
+    if (changes.count()>constMaxPqChanges || playQueueTimes.count()!=playQueueIds.count()) {
+        playListInfo();
+        return;
+    }
+
+    QList<qint32> ids=playQueueIds.mid(0, sv.playlistLength);
+    QList<quint32> times=playQueueTimes.mid(0, sv.playlistLength);
+    while ((quint32)ids.count()<sv.playlistLength) {
+        ids.append(-1);
+        times.append(0);
+    }
+
+    // Any song that has been removed was either at a changed position, or past the new end.
+    QSet<qint32> candidates;
+    QSet<qint32> changedIds;
+    for (const MPDParseUtils::IdPos &idp: changes) {
+        changedIds.insert(idp.id);
+        if (idp.pos<(quint32)playQueueIds.count()) {
+            candidates.insert(playQueueIds.at(idp.pos));
+        }
+    }
+    for (int i=sv.playlistLength; i<playQueueIds.count(); ++i) {
+        candidates.insert(playQueueIds.at(i));
+    }
+
+    QHash<qint32, quint32> prevTimes;
+    for (int i=0; i<playQueueIds.count() && prevTimes.count()<changedIds.count(); ++i) {
+        if (changedIds.contains(playQueueIds.at(i))) {
+            prevTimes.insert(playQueueIds.at(i), playQueueTimes.at(i));
+        }
+    }
+
+    QList<quint32> newPositions;
+    for (const MPDParseUtils::IdPos &idp: changes) {
+        if (idp.pos>=sv.playlistLength) {
+            playListInfo();
+            return;
+        }
+        ids[idp.pos]=idp.id;
+        QHash<qint32, quint32>::ConstIterator it=prevTimes.constFind(idp.id);
+        if (prevTimes.constEnd()==it || streamIds.contains(idp.id)) {
+            newPositions.append(idp.pos);
+        } else {
+            times[idp.pos]=it.value();
+        }
+    }
+
+    // Read details of new songs, in runs of consecutive positions.
+    QList<Song> newCantataStreams;
+    QSet<qint32> strmIds=streamIds;
+    std::sort(newPositions.begin(), newPositions.end());
+    for (int i=0; i<newPositions.count(); ) {
+        int end=i+1;
+        while (end<newPositions.count() && newPositions.at(end)==newPositions.at(end-1)+1) {
+            ++end;
+        }
+        Response response=sendCommand("playlistinfo "+quote(newPositions.at(i))+':'+quote(newPositions.at(end-1)+1));
+        if (!response.ok) {
+            playListInfo();
+            return;
+        }
+        QList<Song> songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue);
+        for (int s=0; s<songs.count() && i+s<end; ++s) {
+            const Song &song=songs.at(s);
+            quint32 pos=newPositions.at(i+s);
+            times[pos]=song.time;
+            if (song.isCdda()) {
+                newCantataStreams.append(song);
+            } else if (song.isStream()) {
+                if (song.isCantataStream()) {
+                    newCantataStreams.append(song);
+                } else {
+                    strmIds.insert(song.id);
+                }
+            }
+        }
+        i=end;
+    }
+
+    QSet<qint32> removed=candidates-changedIds;
+    for (qint32 id: removed) {
+        strmIds.remove(id);
+    }
+    playQueueIds=ids;
+    playQueueTimes=times;
+    streamIds=strmIds;
+    lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
+    emitStatusUpdated(sv);
+    if (!newCantataStreams.isEmpty()) {
+        emit cantataStreams(newCantataStreams, true);
+    }
+    if (!removed.isEmpty()) {
+        emit removedIds(removed);
+    }
+    emit playlistPagedUpdated(ids, times);
+    if (ids.isEmpty()) {
+        stopVolumeFade();
+    }
+}
+
+void MPDConnection::playListRange(quint32 start, quint32 end)
+{
+    Response response=sendCommand("playlistinfo "+quote(start)+':'+quote(end));
+    if (response.ok) {
+        emit playlistRange(start, MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue));
+    }
+}
+
+void MPDConnection::playListSearch(const QString &text)
+{
+    Response response=sendCommand("playlistsearch any "+encodeName(text));
+    emit playlistSearchResults(text, response.ok ? MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue) : QList<Song>());
+}
+
 /*
  * Playback commands
  */
 void MPDConnection::setCrossFade(int secs)
 {
-    sendCommand("crossfade "+quote(secs));
+    coalesceCommand(Coalesce_CrossFade, "crossfade "+quote(secs));
 }
 
 void MPDConnection::setReplayGain(const QString &v)
@@ -1419,16 +1723,15 @@ void MPDConnection::setSeekId(qint32 songId, quint32 time)
     if (songId!=currentSongId || 0==time) {
         toggleStopAfterCurrent(false);
     }
-    if (sendCommand("seekid "+quote(songId)+' '+quote(time)).ok) {
-        if (stopAfterCurrent && songId==currentSongId && songPos>time) {
-            songPos=time;
-        }
-    }
+    coalescedSeekId=songId;
+    coalescedSeekTime=time;
+    coalesceCommand(Coalesce_Seek, "seekid "+quote(songId)+' '+quote(time));
 }
 
 void MPDConnection::setVolume(int vol) //Range accepted by MPD: 0-100
 {
     if (-1==vol) {
+        coalescedCommands.remove(Coalesce_Volume);
         if (restoreVolume>=0) {
             sendCommand("setvol "+quote(restoreVolume), false);
         }
@@ -1438,12 +1741,13 @@ void MPDConnection::setVolume(int vol) //Range accepted by MPD: 0-100
         restoreVolume=-1;
     } else if (vol>=0) {
         unmuteVol=-1;
-        sendCommand("setvol "+quote(vol), false);
+        coalesceCommand(Coalesce_Volume, "setvol "+quote(vol));
     }
 }
 
 void MPDConnection::toggleMute()
 {
+    coalescedCommands.remove(Coalesce_Volume);
     if (unmuteVol>0) {
         sendCommand("setvol "+quote(unmuteVol), false);
         unmuteVol=-1;
@@ -1550,11 +1854,14 @@ void MPDConnection::getCover(const Song &song)
     int imageSize = 0;
     QByteArray imageData;
     bool firstRun = true;
+    bool notFound = false;
     QString path=Utils::getDir(song.file);
     while (dataToRead != 0) {
         Response response=sendCommand("albumart "+encodeName(path)+" "+QByteArray::number(firstRun ? 0 : (imageSize - dataToRead)));
         if (!response.ok) {
             DBUG << "albumart query failed";
+            // ACK_ERROR_NO_EXIST - there is no image, as opposed to a connection (etc.) error
+            notFound = firstRun && response.data.startsWith("ACK [50@");
             break;
         }
 
@@ -1605,7 +1912,7 @@ void MPDConnection::getCover(const Song &song)
     }
 
     DBUG << dataToRead << imageData.size();
-    emit albumArt(song, 0==dataToRead ? imageData : QByteArray());
+    emit albumArt(song, 0==dataToRead ? imageData : QByteArray(), notFound);
 }
 
 /*
@@ -1618,7 +1925,9 @@ void MPDConnection::idleDataReady()
     if (0==idleSocket.bytesAvailable()) {
         return;
     }
-    parseIdleReturn(readFromSocket(idleSocket));
+    QByteArray data=readFromSocket(idleSocket);
+    trace('I', data);
+    parseIdleReturn(data);
 }
 
 /*
@@ -1699,8 +2008,14 @@ void MPDConnection::parseIdleReturn(const QByteArray &data)
                     playListChanges();
                 }
             } else if (!statusUpdated && (constIdlePlayerValue==value || constIdleMixerValue==value || constIdleOptionsValue==value)) {
-                getStatus();
-                getReplayGain();
+                if (!coalescedCommands.isEmpty() || fadingVolume()) {
+                    // Most likely caused by our own writes, and more are due - so wait until these have been sent.
+                    statusDeferred=true;
+                } else {
+                    statusDeferred=false;
+                    getStatus();
+                    getReplayGain();
+                }
                 statusUpdated=true;
             } else if (constIdlePartitionValue==value) {
                 listPartitions();
@@ -1719,13 +2034,13 @@ void MPDConnection::parseIdleReturn(const QByteArray &data)
     }
 
     while (!idleSocketCommandQueue.isEmpty()) {
-        idleSocket.write(idleSocketCommandQueue.dequeue()+'\n');
+        writeCommand(idleSocket, idleSocketCommandQueue.dequeue());
         idleSocket.waitForBytesWritten();
-        readReply(idleSocket);
+        trace('R', readReply(idleSocket).data);
     }
 
     DBUG << (void *)(&idleSocket) << "write idle";
-    idleSocket.write("idle\n");
+    writeCommand(idleSocket, "idle");
     idleSocket.waitForBytesWritten();
 }
 
@@ -1749,7 +2064,7 @@ void MPDConnection::changePartition(QString name)
     if (sendCommand(cmd).ok) {
         getStatus();
         idleSocketCommandQueue.enqueue(cmd);
-        idleSocket.write("noidle\n");
+        writeCommand(idleSocket, "noidle");
         idleSocket.waitForBytesWritten();
     }
 }
@@ -2368,6 +2683,49 @@ QStringList MPDConnection::getPlaylistFiles(const QString &name)
 }
 
 QStringList MPDConnection::getAllFiles(const QString &dir)
+{
+    // MPD can list a whole folder tree with a single "listall", and we only need the paths. However, if
+    // the response is larger than MPD's output buffer then MPD closes the connection - and reconnecting
+    // reloads the play queue, etc. So, only use "listall" if the folder is known to be small enough -
+    // otherwise list the folder with "lsinfo", and try each sub-folder in turn. Other servers, uncounted
+    // folders, or if "listall" fails, use "lsinfo" for each folder.
+    if (isMpd()) {
+        int count=countFiles(dir);
+        if (count>constMaxListAllFiles) {
+            return getAllFilesRecursive(dir, true);
+        }
+        if (count>=0) {
+            Response response=sendCommand("listall "+encodeName(dir), false);
+            if (response.ok) {
+                QStringList files=MPDParseUtils::parseFileList(response.data);
+                DBUG << dir << files.count();
+                return files;
+            }
+        }
+    }
+    return getAllFilesRecursive(dir, false);
+}
+
+// Number of songs within a folder (and its sub-folders), or -1 if this cannot be determined. The whole
+// library's count is read from "stats", other folders require MPD 0.21 for "count" with a base filter.
+int MPDConnection::countFiles(const QString &dir)
+{
+    Response response(false);
+    if (dir.isEmpty() || QLatin1String("/")==dir) {
+        response=sendCommand("stats", false);
+    } else if (ver>=CANTATA_MAKE_VERSION(0, 21, 0)) {
+        response=sendCommand("count "+encodeName(QLatin1String("(base ")+QString::fromUtf8(encodeName(dir))+QLatin1Char(')')), false);
+    }
+    if (response.ok) {
+        QStringList songs=MPDParseUtils::parseList(response.data, QByteArray("songs: "));
+        if (!songs.isEmpty()) {
+            return songs.first().toInt();
+        }
+    }
+    return -1;
+}
+
+QStringList MPDConnection::getAllFilesRecursive(const QString &dir, bool countSubDirs)
 {
     QStringList files;
     Response response=sendCommand("lsinfo "+encodeName(dir));
@@ -2381,7 +2739,7 @@ QStringList MPDConnection::getAllFiles(const QString &dir)
             }
         }
         for (const QString &sub: subDirs) {
-            files+=getAllFiles(sub);
+            files+=countSubDirs ? getAllFiles(sub) : getAllFilesRecursive(sub, false);
         }
     }
 
@@ -2392,9 +2750,10 @@ bool MPDConnection::checkRemoteDynamicSupport()
 {
     if (ver>=CANTATA_MAKE_VERSION(0,17,0)) {
         Response response;
-        if (-1!=idleSocket.write("channels\n")) {
+        if (-1!=writeCommand(idleSocket, "channels")) {
             idleSocket.waitForBytesWritten(constSocketCommsTimeout);
             response=readReply(idleSocket);
+            trace('R', response.data);
             if (response.ok) {
                 return Utils::listToSet(MPDParseUtils::parseList(response.data, QByteArray("channel: "))).contains(constDynamicIn);
             }
@@ -2405,9 +2764,10 @@ bool MPDConnection::checkRemoteDynamicSupport()
 
 bool MPDConnection::subscribe(const QByteArray &channel)
 {
-    if (-1!=idleSocket.write("subscribe \""+channel+"\"\n")) {
+    if (-1!=writeCommand(idleSocket, "subscribe \""+channel+"\"")) {
         idleSocket.waitForBytesWritten(constSocketCommsTimeout);
         Response response=readReply(idleSocket);
+        trace('R', response.data);
         if (response.ok || response.data.startsWith("ACK [56@0]")) { // ACK => already subscribed...
             DBUG << "Created subscription to " << channel;
             return true;
@@ -2440,9 +2800,10 @@ void MPDConnection::setupRemoteDynamic()
 
 void MPDConnection::readRemoteDynamicMessages()
 {
-    if (-1!=idleSocket.write("readmessages\n")) {
+    if (-1!=writeCommand(idleSocket, "readmessages")) {
         idleSocket.waitForBytesWritten(constSocketCommsTimeout);
         Response response=readReply(idleSocket);
+        trace('R', response.data);
         if (response.ok) {
             MPDParseUtils::MessageMap messages=MPDParseUtils::parseMessages(response.data);
             if (!messages.isEmpty()) {
@@ -2614,13 +2975,68 @@ void MPDConnection::stopVolumeFade()
 {
     if (fadingVolume()) {
         volumeFade->stop();
-        setVolume(restoreVolume);
+        coalescedCommands.remove(Coalesce_Volume);
+        unmuteVol=-1;
+        sendCommand("setvol "+quote(restoreVolume), false);
         restoreVolume=-1;
     }
 }
 
+/*
+ * Volume, seek, and crossfade are continuous controls - a slider drag, or a volume fade, can
+ * produce many values per second. Only the latest value for each is kept, and these are sent
+ * at most every constCoalesceInterval ms.
+ */
+void MPDConnection::coalesceCommand(CoalescedCommand key, const QByteArray &command)
+{
+    coalescedCommands.insert(key, command);
+    if (coalesceTimer && !coalesceTimer->isActive()) {
+        qint64 elapsed=lastCoalescedSend.isValid() ? lastCoalescedSend.elapsed() : constCoalesceInterval;
+        coalesceTimer->start(elapsed>=constCoalesceInterval ? 0 : int(constCoalesceInterval-elapsed));
+    } else if (!coalesceTimer) {
+        sendCoalescedCommands();
+    }
+}
+
+void MPDConnection::sendCoalescedCommands()
+{
+    if (coalesceTimer) {
+        coalesceTimer->stop();
+    }
+    QMap<int, QByteArray> commands=coalescedCommands;
+    coalescedCommands.clear();
+    lastCoalescedSend.start();
+
+    QMap<int, QByteArray>::ConstIterator it=commands.constBegin();
+    QMap<int, QByteArray>::ConstIterator end=commands.constEnd();
+    for (; it!=end; ++it) {
+        switch (it.key()) {
+        case Coalesce_Volume:
+            sendCommand(it.value(), false);
+            break;
+        case Coalesce_Seek:
+            if (sendCommand(it.value()).ok) {
+                if (stopAfterCurrent && coalescedSeekId==currentSongId && songPos>coalescedSeekTime) {
+                    songPos=coalescedSeekTime;
+                }
+            }
+            break;
+        default:
+            sendCommand(it.value());
+            break;
+        }
+    }
+
+    if (statusDeferred && coalescedCommands.isEmpty() && !fadingVolume()) {
+        statusDeferred=false;
+        getStatus();
+        getReplayGain();
+    }
+}
+
 void MPDConnection::emitStatusUpdated(MPDStatusValues &v)
 {
+    lastPlayQueueLength=v.playlistLength;
     if (restoreVolume>=0) {
         v.volume=restoreVolume;
     }
@@ -2638,9 +3054,9 @@ void MPDConnection::clearError()
     #ifdef REPORT_MPD_ERRORS
     if (isConnected()) {
         DBUG << __FUNCTION__;
-        if (-1!=sock.write("clearerror\n")) {
+        if (-1!=writeCommand(sock, "clearerror")) {
             sock.waitForBytesWritten(500);
-            readReply(sock);
+            trace('R', readReply(sock).data);
         }
     }
     #endif
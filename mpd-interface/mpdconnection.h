@@ -34,6 +34,8 @@
 #include <QStringList>
 #include <QQueue>
 #include <QSet>
+#include <QMap>
+#include <QElapsedTimer>
 #include "mpdstats.h"
 #include "mpdstatus.h"
 #include "song.h"
@@ -244,6 +246,9 @@ public:
 
     static const QString constModifiedSince;
     static const int constMaxPqChanges;
+    static const int constPagedPlayQueueLength;
+    static const int constPlayQueuePageSize;
+    static const int constCoalesceInterval;
     static const QString constStreamsPlayListName;
     static const QString constPlaylistPrefix;
     static const QString constDirPrefix;
@@ -260,6 +265,7 @@ public:
     };
 
     static void enableDebug();
+    static void enableTrace(const QString &fileName);
 
     MPDConnection();
     ~MPDConnection() override;
@@ -308,6 +314,8 @@ public Q_SLOTS:
     void currentSong();
     void playListChanges();
     void playListInfo();
+    void playListRange(quint32 start, quint32 end);
+    void playListSearch(const QString &text);
     void removeSongs(const QList<qint32> &items);
     void move(quint32 from, quint32 to);
     void move(const QList<quint32> &items, quint32 pos, quint32 size);
@@ -403,6 +411,10 @@ Q_SIGNALS:
     void passwordError();
     void currentSongUpdated(const Song &song);
     void playlistUpdated(const QList<Song> &songs, bool isComplete);
+    // Used in place of playlistUpdated() for very large play queues - only ids and durations are sent.
+    void playlistPagedUpdated(const QList<qint32> &ids, const QList<quint32> &times);
+    void playlistRange(quint32 start, const QList<Song> &songs);
+    void playlistSearchResults(const QString &text, const QList<Song> &songs);
     void statsUpdated(const MPDStatsValues &stats);
     void statusUpdated(const MPDStatusValues &status);
     void partitionsUpdated(const QList<Partition> &partitions);
@@ -453,11 +465,12 @@ Q_SIGNALS:
 
     void ifaceIp(const QString &addr);
 
-    void albumArt(const Song &song, const QByteArray &data);
+    void albumArt(const Song &song, const QByteArray &data, bool notFound);
 
 private Q_SLOTS:
     void idleDataReady();
     void onSocketStateChanged(QAbstractSocket::SocketState socketState);
+    void sendCoalescedCommands();
 
 private:
     enum ConnectionReturn
@@ -468,6 +481,14 @@ private:
         IncorrectPassword
     };
 
+    // Commands for continuous controls, where only the latest value needs to be sent
+    enum CoalescedCommand
+    {
+        Coalesce_Volume,
+        Coalesce_Seek,
+        Coalesce_CrossFade
+    };
+
     static ConnectionReturn convertSocketCode(MpdSocket &socket);
     QString errorString(ConnectionReturn status) const;
     ConnectionReturn connectToMPD();
@@ -481,6 +502,8 @@ private:
     bool recursivelyListDir(const QString &dir, QList<Song> &songs);
     QStringList getPlaylistFiles(const QString &name);
     QStringList getAllFiles(const QString &dir);
+    QStringList getAllFilesRecursive(const QString &dir, bool countSubDirs);
+    int countFiles(const QString &dir);
     bool checkRemoteDynamicSupport();
     bool subscribe(const QByteArray &channel);
     void setupRemoteDynamic();
@@ -488,7 +511,10 @@ private:
     bool fadingVolume();
     bool startVolumeFade();
     void stopVolumeFade();
+    void coalesceCommand(CoalescedCommand key, const QByteArray &command);
     void emitStatusUpdated(MPDStatusValues &v);
+    void pagedPlayListInfo(MPDStatusValues &sv);
+    void pagedPlayListChanges(MPDStatusValues &sv, const QByteArray &changesData);
     void clearError();
     void getRatings(QList<Song> &songs);
     void getStickerSupport();
@@ -514,7 +540,10 @@ private:
 
     // The three items are used so that we can do quick playqueue updates...
     QList<qint32> playQueueIds;
+    QList<quint32> playQueueTimes; // Only used for paged play queues
     QSet<qint32> streamIds;
+    bool pagedPlayQueue;
+    qint32 lastPlayQueueLength; // From last status, -1 if not known
     quint32 lastStatusPlayQueueVersion;
     quint32 lastUpdatePlayQueueVersion;
 
@@ -540,6 +569,13 @@ private:
     QPropertyAnimation *volumeFade;
     int fadeDuration;
     int restoreVolume;
+
+    QTimer *coalesceTimer;
+    QElapsedTimer lastCoalescedSend;
+    QMap<int, QByteArray> coalescedCommands;
+    qint32 coalescedSeekId;
+    quint32 coalescedSeekTime;
+    bool statusDeferred;
 };
 
 #endif
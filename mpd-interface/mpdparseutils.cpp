@@ -565,6 +565,31 @@ MPDParseUtils::MessageMap MPDParseUtils::parseMessages(const QByteArray &data)
     return messages;
 }
 
+// Extract just the paths of the "file:" entries of a (possibly very large) listall response.
+// Lines are scanned in place, rather than splitting the whole response, and only the paths
+// are converted - so no Song objects (or per-line byte arrays) are created.
+QStringList MPDParseUtils::parseFileList(const QByteArray &data)
+{
+    QStringList files;
+    const char *d=data.constData();
+    int size=data.size();
+    int keyLen=constFileKey.length();
+    int pos=0;
+
+    while (pos<size) {
+        int end=data.indexOf('\n', pos);
+        if (-1==end) {
+            end=size;
+        }
+        if (end-pos>keyLen && 0==qstrncmp(d+pos, constFileKey.constData(), keyLen)) {
+            files.append(QString::fromUtf8(d+pos+keyLen, end-pos-keyLen));
+        }
+        pos=end+1;
+    }
+
+    return files;
+}
+
 void MPDParseUtils::parseDirItems(const QByteArray &data, const QString &mpdDir, long mpdVersion, QList<Song> &songList, const QString &dir, QStringList &subDirs, Location loc)
 {
     QList<QByteArray> currentItem;
@@ -34,10 +34,20 @@ MPDStatus * MPDStatus::self()
 }
 
 MPDStatus::MPDStatus()
+    : guessed(0)
 {
     connect(MPDConnection::self(), SIGNAL(statusUpdated(const MPDStatusValues &)), this, SLOT(update(const MPDStatusValues &)), Qt::QueuedConnection);
 }
 
+quint16 MPDStatus::guessedElapsed() const
+{
+    if (MPDState_Playing!=values.state || !guessedTime.isValid()) {
+        return guessed;
+    }
+    int elapsed=guessed+(guessedTime.elapsed()/1000);
+    return values.timeTotal>0 ? qMin(elapsed, (int)values.timeTotal) : elapsed;
+}
+
 void MPDStatus::update(const MPDStatusValues &v)
 {
     values=v;
@@ -28,6 +28,7 @@
 #define MPD_STATUS_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 enum MPDState {
     MPDState_Inactive,
@@ -121,8 +122,10 @@ public:
 
     // Cantata does not poll MPD for current position, but instead used a timer
     // This timer will update its value here - so this can be used elsewhere...
-    void setGuessedElapsed(quint16 v) { guessed=v; }
-    quint16 guessedElapsed() const { return guessed; }
+    // As the timer is not run whilst the window is hidden, the value is extrapolated
+    // from when it was last set.
+    void setGuessedElapsed(quint16 v) { guessed=v; guessedTime.start(); }
+    quint16 guessedElapsed() const;
 
 public Q_SLOTS:
     void update(const MPDStatusValues &v);
@@ -136,6 +139,7 @@ private:
 
 private:
     quint16 guessed;
+    QElapsedTimer guessedTime;
     MPDStatusValues values;
 };
 
@@ -38,6 +38,7 @@ OnlineDbWidget::OnlineDbWidget(OnlineDbService *s, QWidget *p)
 {
     srv->setParent(this);
     view->setModel(s);
+    view->setAsyncSearch(true);
     view->alwaysShowHeader();
     Configuration config(configGroup);
     view->setMode(ItemView::Mode_DetailedTree);
@@ -29,6 +29,7 @@
 #include "gui/settings.h"
 #include "tags/tags.h"
 #include "tagreader.h"
+#include "tagwriter.h"
 #include "support/utils.h"
 #include "support/messagebox.h"
 #include "support/monoicon.h"
@@ -43,8 +44,6 @@
 #include <QBoxLayout>
 #include <QHeaderView>
 #include <QCloseEvent>
-#include <QCoreApplication>
-#include <QEventLoop>
 #include <algorithm>
 
 enum Columns
@@ -75,6 +74,7 @@ RgDialog::RgDialog(QWidget *parent)
     , state(State_Idle)
     , totalToScan(0)
     , tagReader(0)
+    , tagWriter(0)
     , autoScanTags(false)
 {
     iCount++;
@@ -218,10 +218,7 @@ void RgDialog::slotButtonClicked(int button)
     case Ok:
         //if (MessageBox::Yes==MessageBox::questionYesNo(this, tr("Update ReplayGain tags in tracks?"), tr("Update Tags"),
         //                                               GuiItem(tr("Update Tags")), StdGuiItem::cancel())) {
-            if (saveTags()) {
-                stopScanning();
-                accept();
-            }
+            saveTags();
         //}
         break;
     case User1:
@@ -373,48 +370,65 @@ void RgDialog::stopReadingTags()
     autoScanTags=false;
 }
 
-bool RgDialog::saveTags()
+void RgDialog::saveTags()
 {
+    if (tagWriter) {
+        return;
+    }
+
     state=State_Saving;
     enableButton(Ok, false);
     enableButton(Close, false);
     enableButton(Cancel, false);
     enableButton(User1, false);
 
-    QStringList failed;
-
-    progress->setVisible(true);
-    progress->setRange(0, tagsToSave.count());
-
-    int count=0;
-    bool someTimedout=false;
+    QMap<QString, Tags::ReplayGain> tags;
     QMap<int, Tags::ReplayGain>::ConstIterator it=tagsToSave.constBegin();
     QMap<int, Tags::ReplayGain>::ConstIterator end=tagsToSave.constEnd();
 
     for (; it!=end; ++it) {
-        QString filePath=origSongs.at(it.key()).filePath(base);
-        switch (Tags::updateReplaygain(filePath, it.value())) {
-        case Tags::Update_Failed:
-            failed.append(filePath);
-            break;
-        case Tags::Update_BadFile:
-            failed.append(tr("%1 (Corrupt tags?)", "filename (Corrupt tags?)").arg(filePath));
-            break;
-        default:
-            break;
-        }
+        tags.insert(origSongs.at(it.key()).filePath(base), it.value());
+    }
 
-        progress->setValue(progress->value()+1);
-        if (0==count++%10) {
-            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-        }
+    progress->setValue(0);
+    progress->setRange(0, tags.count());
+    progress->setVisible(true);
+    statusLabel->setText(tr("Saving tags..."));
+    statusLabel->setVisible(true);
+    tagWriter=new TagWriter();
+    tagWriter->setDetails(tags);
+    connect(tagWriter, SIGNAL(progress(int)), this, SLOT(tagWriterProgress(int)));
+    connect(tagWriter, SIGNAL(done()), this, SLOT(tagWriterDone()));
+    JobController::self()->add(tagWriter);
+}
+
+void RgDialog::tagWriterProgress(int count)
+{
+    progress->setValue(count);
+}
+
+void RgDialog::tagWriterDone()
+{
+    TagWriter *t=qobject_cast<TagWriter *>(sender());
+    if (!t) {
+        return;
+    }
+
+    QStringList failed=t->failedFiles();
+    for (const QString &f: t->badFiles()) {
+        failed.append(tr("%1 (Corrupt tags?)", "filename (Corrupt tags?)").arg(f));
     }
+    JobController::self()->finishedWith(t);
+    tagWriter=0;
+    progress->setVisible(false);
+    statusLabel->setVisible(false);
+    state=State_Idle;
 
     if (failed.count()) {
         MessageBox::errorListEx(this, tr("Failed to update the tags of the following tracks:"), failed);
     }
-
-    return !someTimedout;
+    stopScanning();
+    accept();
 }
 
 void RgDialog::updateView()
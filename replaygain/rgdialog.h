@@ -38,6 +38,7 @@ class QProgressBar;
 class Device;
 #endif
 class TagReader;
+class TagWriter;
 class Action;
 
 class RgDialog : public SongDialog
@@ -64,7 +65,7 @@ private:
     void clearScanners();
     void startReadingTags();
     void stopReadingTags();
-    bool saveTags();
+    void saveTags();
     void updateView();
     #ifdef ENABLE_DEVICES_SUPPORT
     Device * getDevice(const QString &udi, QWidget *p);
@@ -76,6 +77,8 @@ private Q_SLOTS:
     void scannerDone();
     void songTags(int index, Tags::ReplayGain tags);
     void tagReaderDone();
+    void tagWriterProgress(int count);
+    void tagWriterDone();
     void toggleDisplay();
     void controlRemoveAct();
     void removeItems();
@@ -103,6 +106,7 @@ private:
     QMap<int, Tags::ReplayGain> origTags;
     QMap<int, Tags::ReplayGain> tagsToSave;
     TagReader *tagReader;
+    TagWriter *tagWriter;
 
     bool autoScanTags;
 
@@ -0,0 +1,77 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "tagwriter.h"
+#include <QElapsedTimer>
+
+// Progress is reported in batches, so that the dialog is not flooded with updates for files that
+// only needed patching in place.
+static const int constProgressBatch=25;
+static const int constProgressInterval=250; // ms
+
+void TagWriter::setDetails(const QMap<QString, Tags::ReplayGain> &t)
+{
+    tags=t;
+}
+
+void TagWriter::run()
+{
+    QElapsedTimer timer;
+    int count=0;
+    int reported=0;
+    QMap<QString, Tags::ReplayGain>::ConstIterator it=tags.constBegin();
+    QMap<QString, Tags::ReplayGain>::ConstIterator end=tags.constEnd();
+
+    timer.start();
+    for (; it!=end; ++it) {
+        if (abortRequested) {
+            setFinished(false);
+            return;
+        }
+
+        switch (Tags::updateReplaygain(it.key(), it.value())) {
+        case Tags::Update_Failed:
+            failed.append(it.key());
+            break;
+        case Tags::Update_BadFile:
+            bad.append(it.key());
+            break;
+        default:
+            break;
+        }
+
+        ++count;
+        if (count-reported>=constProgressBatch || timer.elapsed()>=constProgressInterval) {
+            reported=count;
+            timer.restart();
+            emit progress(count);
+        }
+    }
+    if (reported!=count) {
+        emit progress(count);
+    }
+    setFinished(true);
+}
+
+#include "moc_tagwriter.cpp"
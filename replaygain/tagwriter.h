@@ -0,0 +1,55 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2021 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef _TAGWRITER_H_
+#define _TAGWRITER_H_
+
+#include "jobcontroller.h"
+#include "tags/tags.h"
+#include <QMap>
+#include <QStringList>
+
+class TagWriter : public StandardJob
+{
+    Q_OBJECT
+
+public:
+    TagWriter() { }
+    virtual ~TagWriter() { }
+
+    void setDetails(const QMap<QString, Tags::ReplayGain> &t);
+    // Only valid once done() has been emitted
+    const QStringList & failedFiles() const { return failed; }
+    const QStringList & badFiles() const { return bad; }
+
+private:
+    void run();
+
+private:
+    QMap<QString, Tags::ReplayGain> tags;
+    QStringList failed;
+    QStringList bad;
+};
+
+#endif
@@ -30,6 +30,9 @@
 #include <QLocalSocket>
 #include <QTimer>
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #else
@@ -112,6 +115,38 @@ void TagHelper::checkParent()
     #endif
 }
 
+class ReadJob : public QRunnable
+{
+public:
+    ReadJob(const QString &f, Song *s) : file(f), song(s) { }
+    void run() override { *song=Tags::read(file); }
+
+private:
+    QString file;
+    Song *song;
+};
+
+// Read tags of several files using upto 'workers' threads. The first file is read
+// on the calling thread, so that TagLib's file type resolvers are registered
+// before any of the pool threads start.
+static QList<Song> readMany(const QStringList &files, int workers)
+{
+    QVector<Song> songs(files.count());
+    if (files.isEmpty()) {
+        return QList<Song>();
+    }
+    songs[0]=Tags::read(files.at(0));
+    if (files.count()>1) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(qBound(1, workers, QThread::idealThreadCount()));
+        for (int i=1; i<files.count(); ++i) {
+            pool.start(new ReadJob(files.at(i), &songs[i]));
+        }
+        pool.waitForDone();
+    }
+    return songs.toList();
+}
+
 void TagHelper::process()
 {
     QByteArray response;
@@ -125,6 +160,11 @@ void TagHelper::process()
     DBUG << "REQ" << request << fileName;
     if (QLatin1String("read")==request) {
         outStream << Tags::read(fileName);
+    } else if (QLatin1String("readMany")==request) {
+        QStringList files;
+        int workers=1;
+        inStream >> files >> workers;
+        outStream << readMany(files, workers);
     } else if (QLatin1String("readImage")==request) {
         outStream << Tags::readImage(fileName);
     } else if (QLatin1String("readLyrics")==request) {
@@ -88,6 +88,21 @@ Song TagHelperIface::read(const QString &fileName)
     return resp;
 }
 
+QList<Song> TagHelperIface::readMany(const QStringList &fileNames, int workers)
+{
+    DBUG << fileNames.count() << workers;
+    QList<Song> resp;
+    QByteArray message;
+    QDataStream outStream(&message, QIODevice::WriteOnly);
+    outStream << QString(__FUNCTION__) << QString() << fileNames << workers;
+    Reply reply=sendMessage(message);
+    if (reply.status) {
+        QDataStream inStream(reply.data);
+        inStream >> resp;
+    }
+    return resp;
+}
+
 QImage TagHelperIface::readImage(const QString &fileName)
 {
     DBUG << fileName;
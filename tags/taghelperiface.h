@@ -27,6 +27,7 @@
 #include "mpd-interface/song.h"
 #include <QImage>
 #include <QString>
+#include <QStringList>
 #include <QMutex>
 #include <QSemaphore>
 #include <QMap>
@@ -58,6 +59,7 @@ public:
     TagHelperIface();
     void stop();
     Song read(const QString &fileName);
+    QList<Song> readMany(const QStringList &fileNames, int workers);
     QImage readImage(const QString &fileName);
     QString readLyrics(const QString &fileName);
     QString readComment(const QString &fileName);
@@ -37,6 +37,7 @@
 #include <QString>
 #include <QStringList>
 #include <QTextCodec>
+#include <QtEndian>
 #include <QDebug>
 #define TAGLIB_VERSION CANTATA_MAKE_VERSION(TAGLIB_MAJOR_VERSION, TAGLIB_MINOR_VERSION, TAGLIB_PATCH_VERSION)
 
@@ -1562,10 +1563,191 @@ ReplayGain readReplaygain(const QString &fileName)
     return rg;
 }
 
+static QByteArray flacBlockHeader(int type, bool last, quint32 length)
+{
+    QByteArray hdr(4, '\0');
+    hdr[0]=(char)((last ? 0x80 : 0x00)|type);
+    hdr[1]=(char)((length>>16)&0xFF);
+    hdr[2]=(char)((length>>8)&0xFF);
+    hdr[3]=(char)(length&0xFF);
+    return hdr;
+}
+
+static void appendLE32(QByteArray &data, quint32 val)
+{
+    uchar le[4];
+    qToLittleEndian<quint32>(val, le);
+    data.append((const char *)le, 4);
+}
+
+// Replace the REPLAYGAIN_ fields of a native FLAC file's Vorbis comment, writing only the comment block (and
+// the header of the padding block that follows it) back to the file. TagLib's save re-renders all metadata
+// blocks, and rewrites the whole file if the new blocks do not fit. Returns false if the change cannot be
+// made in place, in which case TagLib should be used.
+static bool patchFlacReplaygain(const QString &fileName, const RgTags &rg, Update &result)
+{
+    enum BlockType {
+        Block_Padding = 1,
+        Block_VorbisComment = 4
+    };
+    static const qint64 constMaxBlockLength=0xFFFFFF;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadWrite) || "fLaC"!=file.read(4)) {
+        return false;
+    }
+
+    qint64 pos=4;
+    qint64 commentPos=-1;
+    qint64 commentLength=0;
+    bool commentLast=false;
+    qint64 paddingPos=-1;
+    qint64 paddingLength=0;
+    bool paddingLast=false;
+    for (;;) {
+        QByteArray hdr=file.read(4);
+        if (4!=hdr.size()) {
+            return false;
+        }
+        bool last=hdr[0]&0x80;
+        int type=hdr[0]&0x7F;
+        qint64 length=((quint8)hdr[1]<<16)|((quint8)hdr[2]<<8)|(quint8)hdr[3];
+        if (Block_VorbisComment==type) {
+            if (commentPos>=0) {
+                return false;
+            }
+            commentPos=pos;
+            commentLength=length;
+            commentLast=last;
+        } else if (Block_Padding==type && commentPos>=0 && pos==commentPos+4+commentLength) {
+            paddingPos=pos;
+            paddingLength=length;
+            paddingLast=last;
+        }
+        pos+=4+length;
+        if (last) {
+            break;
+        }
+        if (!file.seek(pos)) {
+            return false;
+        }
+    }
+
+    if (commentPos<0 || !file.seek(commentPos+4)) {
+        return false;
+    }
+
+    // Vorbis comment: vendor string, field count, then 'KEY=value' fields - all lengths are 32-bit little endian.
+    QByteArray body=file.read(commentLength);
+    if (body.size()!=commentLength || body.size()<4) {
+        return false;
+    }
+    const uchar *data=(const uchar *)body.constData();
+    qint64 offset=4+qFromLittleEndian<quint32>(data);
+    if (offset+4>body.size()) {
+        return false;
+    }
+    quint32 count=qFromLittleEndian<quint32>(data+offset);
+    offset+=4;
+
+    QList<QByteArray> fields;
+    QList<QByteArray> oldRgFields;
+    for (quint32 i=0; i<count; ++i) {
+        if (offset+4>body.size()) {
+            return false;
+        }
+        qint64 length=qFromLittleEndian<quint32>(data+offset);
+        offset+=4;
+        if (offset+length>body.size()) {
+            return false;
+        }
+        QByteArray field=body.mid(offset, length);
+        offset+=length;
+        QByteArray key=field.left(field.indexOf('=')).toUpper();
+        if ("REPLAYGAIN_TRACK_GAIN"==key || "REPLAYGAIN_TRACK_PEAK"==key || "REPLAYGAIN_ALBUM_GAIN"==key || "REPLAYGAIN_ALBUM_PEAK"==key) {
+            oldRgFields.append(field);
+        } else {
+            fields.append(field);
+        }
+    }
+    if (offset!=body.size()) {
+        return false;
+    }
+
+    RgTagsStrings rgs(rg);
+    QList<QByteArray> rgFields;
+    rgFields << QByteArray("REPLAYGAIN_TRACK_GAIN=")+rgs.trackGain.c_str()
+             << QByteArray("REPLAYGAIN_TRACK_PEAK=")+rgs.trackPeak.c_str();
+    if (rg.albumMode) {
+        rgFields << QByteArray("REPLAYGAIN_ALBUM_GAIN=")+rgs.albumGain.c_str()
+                 << QByteArray("REPLAYGAIN_ALBUM_PEAK=")+rgs.albumPeak.c_str();
+    }
+
+    std::sort(oldRgFields.begin(), oldRgFields.end());
+    std::sort(rgFields.begin(), rgFields.end());
+    if (oldRgFields==rgFields) {
+        result=Update_None;
+        return true;
+    }
+    fields+=rgFields;
+
+    QByteArray newBody=body.left(4+qFromLittleEndian<quint32>(data));
+    appendLE32(newBody, fields.count());
+    for (const QByteArray &field: fields) {
+        appendLE32(newBody, field.size());
+        newBody+=field;
+    }
+
+    // Space available is the current comment block, plus any padding block that directly follows it.
+    qint64 available=commentLength+(paddingPos>=0 ? 4+paddingLength : 0);
+    qint64 newLength=newBody.size();
+    bool last=paddingPos>=0 ? paddingLast : commentLast;
+    QByteArray out;
+
+    if (newLength>constMaxBlockLength) {
+        return false;
+    } else if (newLength==available) {
+        out=flacBlockHeader(Block_VorbisComment, last, newLength)+newBody;
+    } else if (newLength+4<=available) {
+        out=flacBlockHeader(Block_VorbisComment, false, newLength)+newBody+flacBlockHeader(Block_Padding, last, available-(newLength+4));
+        // Blank any of the old comment block that is now part of the padding
+        qint64 oldPaddingStart=commentPos+4+commentLength+(paddingPos>=0 ? 4 : 0);
+        qint64 newPaddingStart=commentPos+4+newLength+4;
+        if (oldPaddingStart>newPaddingStart) {
+            out+=QByteArray(oldPaddingStart-newPaddingStart, '\0');
+        }
+    } else {
+        return false;
+    }
+
+    result=file.seek(commentPos) && file.write(out)==out.size() ? Update_Modified : Update_Failed;
+    DBUG << fileName << "patched" << out.size() << "bytes in place";
+    return true;
+}
+
 Update updateReplaygain(const QString &fileName, const ReplayGain &rg)
 {
+    Update result=Update_Failed;
+    if (patchFlacReplaygain(fileName, RgTags(rg), result)) {
+        return result;
+    }
+
     TagLib::FileRef fileref = getFileRef(fileName);
-    return fileref.isNull() ? Update_Failed : update(fileref, Song(), Song(), RgTags(rg), QByteArray());
+    if (fileref.isNull()) {
+        return Update_Failed;
+    }
+
+    // Avoid re-saving the file if the tags already hold these values
+    ReplayGain existing;
+    readTags(fileref, nullptr, &existing, nullptr, nullptr, nullptr);
+    if (!existing.isEmpty()) {
+        RgTagsStrings o((RgTags(existing)));
+        RgTagsStrings n((RgTags(rg)));
+        if (o.trackGain==n.trackGain && o.trackPeak==n.trackPeak && o.albumGain==n.albumGain && o.albumPeak==n.albumPeak) {
+            return Update_None;
+        }
+    }
+    return update(fileref, Song(), Song(), RgTags(rg), QByteArray());
 }
 
 Update embedImage(const QString &fileName, const QByteArray &cover)
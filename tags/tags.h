@@ -70,6 +70,7 @@ namespace Tags
     inline void init() { TagHelperIface::self(); }
     inline void stop() { TagHelperIface::self()->stop(); }
     inline Song read(const QString &fileName) { return TagHelperIface::self()->read(fileName); }
+    inline QList<Song> read(const QStringList &fileNames, int workers) { return TagHelperIface::self()->readMany(fileNames, workers); }
     inline QImage readImage(const QString &fileName) { return TagHelperIface::self()->readImage(fileName); }
     inline QString readLyrics(const QString &fileName) { return TagHelperIface::self()->readLyrics(fileName); }
     inline QString readComment(const QString &fileName) { return TagHelperIface::self()->readComment(fileName); }
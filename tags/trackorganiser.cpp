@@ -41,13 +41,146 @@
 #include <QTimer>
 #include <QFile>
 #include <QDir>
+#include <QHeaderView>
+#include <QFontMetrics>
 #include <algorithm>
+#include <functional>
 
 #define REMOVE(w) \
     w->setVisible(false); \
     w->deleteLater(); \
     w=0;
 
+TrackOrganiserModel::TrackOrganiserModel(QList<Song> *s, QObject *parent)
+    : QAbstractTableModel(parent)
+    , songs(s)
+    , calculatedCount(0)
+    , differentCount(0)
+    , nextToCalculate(0)
+{
+}
+
+void TrackOrganiserModel::update(const QString &folder, const DeviceOptions &o, const QFont &f)
+{
+    beginResetModel();
+    musicFolder=folder;
+    opts=o;
+    italicFont=f;
+    italicFont.setItalic(true);
+    entries.clear();
+    entries.resize(songs->count());
+    calculatedCount=differentCount=nextToCalculate=0;
+    endResetModel();
+}
+
+void TrackOrganiserModel::removeSong(int row)
+{
+    if (row<0 || row>=songs->count()) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    const Entry &e=entries.at(row);
+    if (e.calculated) {
+        calculatedCount--;
+        if (e.different) {
+            differentCount--;
+        }
+    }
+    if (row<nextToCalculate) {
+        nextToCalculate--;
+    }
+    songs->removeAt(row);
+    entries.remove(row);
+    endRemoveRows();
+}
+
+void TrackOrganiserModel::setRenamed(int row, const Song &to, const QString &dest)
+{
+    if (row<0 || row>=songs->count()) {
+        return;
+    }
+    if (entry(row).different) {
+        differentCount--;
+    }
+    songs->replace(row, to);
+    entries[row].orig=dest;
+    entries[row].different=false;
+    emit dataChanged(index(row, 0), index(row, 1));
+}
+
+bool TrackOrganiserModel::calculateMore(int count)
+{
+    for (; count>0 && nextToCalculate<entries.count(); --count) {
+        entry(nextToCalculate++);
+    }
+    return calculatedCount<entries.count();
+}
+
+QString TrackOrganiserModel::text(int row, int col) const
+{
+    if (row<0 || row>=entries.count()) {
+        return QString();
+    }
+    const Entry &e=entry(row);
+    return 0==col ? e.orig : e.modified;
+}
+
+int TrackOrganiserModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : entries.count();
+}
+
+int TrackOrganiserModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 2;
+}
+
+QVariant TrackOrganiserModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (Qt::Horizontal==orientation && Qt::DisplayRole==role) {
+        return 0==section ? TrackOrganiser::tr("Original Name") : TrackOrganiser::tr("New Name");
+    }
+    return QVariant();
+}
+
+QVariant TrackOrganiserModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row()>=entries.count()) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        return text(index.row(), index.column());
+    case Qt::FontRole:
+        if (entry(index.row()).different) {
+            return italicFont;
+        }
+        break;
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+const TrackOrganiserModel::Entry & TrackOrganiserModel::entry(int row) const
+{
+    Entry &e=entries[row];
+    if (!e.calculated) {
+        const Song &s=songs->at(row);
+        e.orig=s.filePath(musicFolder);
+        e.modified=musicFolder+opts.createFilename(s);
+        e.different=e.modified!=e.orig;
+        e.calculated=true;
+        calculatedCount++;
+        if (e.different) {
+            differentCount++;
+        }
+    }
+    return e;
+}
+
 static int iCount=0;
 
 int TrackOrganiser::instanceCount()
@@ -74,6 +207,11 @@ TrackOrganiser::TrackOrganiser(QWidget *parent)
     setButtonGuiItem(Ok, GuiItem(tr("Rename")));
     connect(this, SIGNAL(update()), MPDConnection::self(), SLOT(updateMaybe()));
     progress->setVisible(false);
+    model=new TrackOrganiserModel(&origSongs, this);
+    checkTimer=new QTimer(this);
+    checkTimer->setInterval(0);
+    connect(checkTimer, SIGNAL(timeout()), SLOT(checkDifferences()));
+    files->setModel(model);
     files->setItemDelegate(new BasicItemDelegate(files));
     files->setAlternatingRowColors(false);
     files->setContextMenuPolicy(Qt::ActionsContextMenu);
@@ -81,7 +219,7 @@ TrackOrganiser::TrackOrganiser(QWidget *parent)
     removeAct=new Action(tr("Remove From List"), files);
     removeAct->setEnabled(false);
     files->addAction(removeAct);
-    connect(files, SIGNAL(itemSelectionChanged()), SLOT(controlRemoveAct()));
+    connect(files->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)), SLOT(controlRemoveAct()));
     connect(removeAct, SIGNAL(triggered()), SLOT(removeItems()));
 }
 
@@ -199,10 +337,6 @@ void TrackOrganiser::readOptions()
 
 void TrackOrganiser::updateView()
 {
-    QFont f(font());
-    f.setItalic(true);
-    files->clear();
-    bool different=false;
     readOptions();
 
     QString musicFolder;
@@ -217,25 +351,53 @@ void TrackOrganiser::updateView()
     #endif
         musicFolder=MPDConnection::self()->getDetails().dir;
 
-    for (const Song &s: origSongs) {
-        QString modified=musicFolder + opts.createFilename(s);
-        //different=different||(modified!=s.file);
-        QString orig=s.filePath(musicFolder);
-        bool diff=modified!=orig;
-        different|=diff;
-        QTreeWidgetItem *item=new QTreeWidgetItem(files, QStringList() << orig << modified);
-        if (diff) {
-            item->setFont(0, f);
-            item->setFont(1, f);
+    model->update(musicFolder, opts, font());
+    resizeColumns();
+    // Rows are only calculated when shown, so check the rest in chunks to find out whether
+    // there is anything to rename.
+    enableButtonOk(model->anyDifferent());
+    checkTimer->start();
+}
+
+void TrackOrganiser::checkDifferences()
+{
+    static const int constCheckChunk=500;
+
+    bool more=model->calculateMore(constCheckChunk);
+    if (model->anyDifferent() || !more) {
+        checkTimer->stop();
+        if (optionsBox->isEnabled()) {
+            enableButtonOk(model->anyDifferent());
+        }
+    }
+}
+
+void TrackOrganiser::resizeColumns()
+{
+    // Only measure a sample of the rows - measuring every row is far too slow for large selections.
+    static const int constSampleRows=200;
+
+    QFont f(font());
+    f.setItalic(true);
+    QFontMetrics fm(f);
+    int rows=model->rowCount();
+    int step=qMax(1, rows/constSampleRows);
+    int pad=fm.horizontalAdvance(QLatin1String("XX"));
+
+    for (int col=0; col<model->columnCount(); ++col) {
+        int width=0;
+        for (int row=0; row<rows; row+=step) {
+            width=qMax(width, fm.horizontalAdvance(model->text(row, col)));
+        }
+        if (width>0) {
+            files->header()->resizeSection(col, width+pad);
         }
     }
-    files->resizeColumnToContents(0);
-    files->resizeColumnToContents(1);
-    enableButtonOk(different);
 }
 
 void TrackOrganiser::startRename()
 {
+    checkTimer->stop();
     optionsBox->setEnabled(false);
     progress->setVisible(true);
     progress->setRange(1, origSongs.count());
@@ -255,8 +417,7 @@ void TrackOrganiser::renameFile()
 
     progress->setValue(progress->value()+1);
 
-    QTreeWidgetItem *item=files->topLevelItem(index);
-    files->scrollToItem(item);
+    files->scrollTo(model->index(index, 0));
     Song s=origSongs.at(index);
     QString modified=opts.createFilename(s);
     QString musicFolder;
@@ -421,9 +582,6 @@ void TrackOrganiser::renameFile()
                     }
                 }
             }
-            item->setText(0, dest);
-            item->setFont(0, font());
-            item->setFont(1, font());
             Song to=s;
             QString origPath;
             if (s.file.startsWith(Song::constMopidyLocal)) {
@@ -434,7 +592,7 @@ void TrackOrganiser::renameFile()
             } else {
                 to.file=modified;
             }
-            origSongs.replace(index, to);
+            model->setRenamed(index, to, dest);
             updated=true;
 
             if (deviceUdi.isEmpty()) {
@@ -463,25 +621,26 @@ void TrackOrganiser::renameFile()
 
 void TrackOrganiser::controlRemoveAct()
 {
-    removeAct->setEnabled(files->topLevelItemCount()>1 && !files->selectedItems().isEmpty());
+    removeAct->setEnabled(model->rowCount()>1 && files->selectionModel()->hasSelection());
 }
 
 void TrackOrganiser::removeItems()
 {
-    if (files->topLevelItemCount()<1) {
+    if (model->rowCount()<1) {
         return;
     }
 
     if (MessageBox::Yes==MessageBox::questionYesNo(this, tr("Remove the selected tracks from the list?"),
                                                    tr("Remove Tracks"), StdGuiItem::remove(), StdGuiItem::cancel())) {
 
-        QList<QTreeWidgetItem *> selection=files->selectedItems();
-        for (QTreeWidgetItem *item: selection) {
-            int idx=files->indexOfTopLevelItem(item);
-            if (idx>-1 && idx<origSongs.count()) {
-                origSongs.removeAt(idx);
-                delete files->takeTopLevelItem(idx);
-            }
+        QModelIndexList selection=files->selectionModel()->selectedRows();
+        QList<int> rows;
+        for (const QModelIndex &idx: selection) {
+            rows.append(idx.row());
+        }
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+        for (int row: rows) {
+            model->removeSong(row);
         }
     }
 }
@@ -33,8 +33,59 @@
 #include "devices/deviceoptions.h"
 #endif
 
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QFont>
+
 class FilenameSchemeDialog;
 class Action;
+class QTimer;
+
+// Rows are only generated when they are requested by the view, as creating
+// the new filename for many thousands of songs is not cheap.
+class TrackOrganiserModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    TrackOrganiserModel(QList<Song> *s, QObject *parent);
+    ~TrackOrganiserModel() override { }
+
+    void update(const QString &folder, const DeviceOptions &o, const QFont &f);
+    void removeSong(int row);
+    void setRenamed(int row, const Song &to, const QString &dest);
+    // Whether any row, of those calculated so far, would be renamed
+    bool anyDifferent() const { return differentCount>0; }
+    // Calculate up to 'count' more rows; returns false once all rows have been calculated
+    bool calculateMore(int count);
+    QString text(int row, int col) const;
+
+    int rowCount(const QModelIndex &parent=QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent=QModelIndex()) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role=Qt::DisplayRole) const override;
+    QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const override;
+
+private:
+    struct Entry {
+        Entry() : calculated(false), different(false) { }
+        QString orig;
+        QString modified;
+        bool calculated;
+        bool different;
+    };
+
+    const Entry & entry(int row) const;
+
+private:
+    QList<Song> *songs;
+    QString musicFolder;
+    DeviceOptions opts;
+    QFont italicFont;
+    mutable QVector<Entry> entries;
+    mutable int calculatedCount;
+    mutable int differentCount;
+    int nextToCalculate;
+};
 
 class TrackOrganiser : public SongDialog, Ui::TrackOrganiser
 {
@@ -59,6 +110,7 @@ private Q_SLOTS:
     void renameFile();
     void controlRemoveAct();
     void removeItems();
+    void checkDifferences();
     void showRatingsMessage();
     void setFilenameScheme(const QString &text);
 
@@ -71,10 +123,13 @@ private:
     #endif
     void doUpdate();
     void finish(bool ok);
+    void resizeColumns();
 
 private:
     FilenameSchemeDialog *schemeDlg;
     QList<Song> origSongs;
+    TrackOrganiserModel *model;
+    QTimer *checkTimer;
     QString deviceUdi;
     Action *removeAct;
     int index;
@@ -710,6 +710,13 @@ ItemView::ItemView(QWidget *p)
     , openFirstLevelAfterSearch(false)
     , initialised(false)
     , minSearchDebounce(250)
+    , searchCost(-1)
+    , asyncSearch(false)
+    , searchPending(false)
+    , preloadTimer(nullptr)
+    , lastScrollPos(0)
+    , scrollVelocity(0.0)
+    , preloadSize(0)
 {
     setupUi(this);
     if (!backAction) {
@@ -752,6 +759,7 @@ ItemView::ItemView(QWidget *p)
     connect(title, SIGNAL(addToPlayQueue()), this, SLOT(addTitleButtonClicked()));
     connect(title, SIGNAL(replacePlayQueue()), this, SLOT(replaceTitleButtonClicked()));
     connect(Covers::self(), SIGNAL(loaded(Song,int)), this, SLOT(coverLoaded(Song,int)));
+    connect(listView->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(viewScrolled(int)));
     searchWidget->setVisible(false);
     #ifdef Q_OS_MAC
     treeView->setAttribute(Qt::WA_MacShowFocusRect, 0);
@@ -914,6 +922,8 @@ void ItemView::setMode(Mode m)
         return;
     }
 
+    cancelCoverPreloads();
+
     prevTopIndex.clear();
     searchWidget->setText(QString());
     if (!title->property(constAlwaysShowProp).toBool()) {
@@ -1757,6 +1767,11 @@ void ItemView::activateItem(const QModelIndex &index, bool emitRootSet)
 
 void ItemView::modelReset()
 {
+    cancelCoverPreloads();
+    if (searchPending) {
+        searchPending=false;
+        addSearchCost(searchStart.elapsed());
+    }
     if (Mode_List==mode || Mode_IconTop==mode) {
         goToTop();
     } else if (usingTreeView() && !searchText().isEmpty()) {
@@ -1812,6 +1827,121 @@ void ItemView::coverLoaded(const Song &song, int size)
     view()->viewport()->update();
 }
 
+static const int constScrollIdleTime=250;
+static const int constPreloadInterval=50;
+static const int constMaxPreloadPerIteration=48;
+
+void ItemView::viewScrolled(int pos)
+{
+    if (Mode_IconTop!=mode) {
+        return;
+    }
+
+    qint64 elapsed=scrollTimer.isValid() ? scrollTimer.restart() : -1;
+    if (!scrollTimer.isValid()) {
+        scrollTimer.start();
+    }
+    if (elapsed>0 && elapsed<constScrollIdleTime) {
+        // Smooth velocity, as wheel events arrive in bursts
+        scrollVelocity=(scrollVelocity+((pos-lastScrollPos)/(double)elapsed))/2.0;
+    } else {
+        scrollVelocity=pos<lastScrollPos ? -0.0001 : 0.0001;
+    }
+    lastScrollPos=pos;
+
+    if (!preloadTimer) {
+        preloadTimer=new QTimer(this);
+        preloadTimer->setSingleShot(true);
+        connect(preloadTimer, SIGNAL(timeout()), this, SLOT(preloadCovers()));
+    }
+    // Don't restart an active timer, so that preloading keeps up with continuous scrolling
+    if (!preloadTimer->isActive()) {
+        preloadTimer->start(constPreloadInterval);
+    }
+}
+
+// Load covers for items just beyond the visible area, in the direction of scrolling. The faster the
+// view is scrolled, the further ahead we look. Items furthest away only get a tiny thumbnail, so that
+// something resembling the cover can be drawn until the real one is loaded.
+void ItemView::preloadCovers()
+{
+    if (Mode_IconTop!=mode || !itemModel || !isVisible()) {
+        cancelCoverPreloads();
+        return;
+    }
+
+    QModelIndex root=listView->rootIndex();
+    int size=zoomedSize(listView, gridCoverSize);
+    if (preloadRoot!=root || size!=preloadSize) {
+        cancelCoverPreloads();
+        preloadRoot=root;
+        preloadSize=size;
+    }
+
+    int rows=itemModel->rowCount(root);
+    QSize grid=listView->gridSize();
+    if (rows<=0 || grid.width()<=0 || grid.height()<=0) {
+        return;
+    }
+
+    QRect vr=listView->viewport()->rect();
+    int perRow=qMax(1, vr.width()/grid.width());
+    int visible=perRow*((vr.height()+grid.height()-1)/grid.height());
+    QModelIndex first=listView->indexAt(QPoint(grid.width()/2, grid.height()/2));
+    int firstRow=first.isValid() && first.parent()==root ? first.row() : 0;
+    int lastRow=qMin(rows-1, firstRow+visible-1);
+    bool down=scrollVelocity>=0.0;
+    double speed=qAbs(scrollVelocity);
+    int ahead=visible*(1+qMin(3, (int)(speed*2.0)));
+    int behind=visible/2;
+    int from=down ? firstRow-behind : firstRow-ahead;
+    int to=down ? lastRow+ahead : lastRow+behind;
+
+    // Cancel preloads that are no longer near the visible area
+    QHash<int, Song>::Iterator it=preloadedCovers.begin();
+    while (it!=preloadedCovers.end()) {
+        if (it.key()<from || it.key()>to) {
+            Covers::self()->cancelPreload(it.value(), size);
+            it=preloadedCovers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    int requested=0;
+    for (int i=1; i<=ahead && requested<constMaxPreloadPerIteration; ++i) {
+        int row=down ? lastRow+i : firstRow-i;
+        if (row<0 || row>=rows) {
+            break;
+        }
+        if (preloadedCovers.contains(row)) {
+            continue;
+        }
+        Song song=itemModel->index(row, 0, root).data(Cantata::Role_GridCoverSong).value<Song>();
+        if (song.isEmpty()) {
+            continue;
+        }
+        Covers::self()->preload(song, size, i>visible);
+        preloadedCovers.insert(row, song);
+        requested++;
+    }
+}
+
+void ItemView::cancelCoverPreloads()
+{
+    if (preloadTimer) {
+        preloadTimer->stop();
+    }
+    QHash<int, Song>::ConstIterator it=preloadedCovers.constBegin();
+    QHash<int, Song>::ConstIterator end=preloadedCovers.constEnd();
+    for (; it!=end; ++it) {
+        Covers::self()->cancelPreload(it.value(), preloadSize);
+    }
+    preloadedCovers.clear();
+    scrollTimer.invalidate();
+    scrollVelocity=0.0;
+}
+
 void ItemView::zoomIn()
 {
     if (listView->isVisible() && Mode_IconTop==mode) {
@@ -1848,6 +1978,9 @@ void ItemView::zoomOut()
     #endif
 }
 
+// Searches that take less than this (ms) to apply are considered cheap, and are started sooner.
+static const int constFastSearch=50;
+
 void ItemView::delaySearchItems()
 {
     if (searchWidget->text().isEmpty()) {
@@ -1865,7 +1998,13 @@ void ItemView::delaySearchItems()
             connect(searchTimer, SIGNAL(timeout()), this, SLOT(doSearch()));
         }
         int len=searchWidget->text().trimmed().length();
-        searchTimer->start(qMin(qMax(minSearchDebounce, len<2 ? 1000u : len<4 ? 750u : 500u), 5000u));
+        unsigned int delay=len<2 ? 1000u : len<4 ? 750u : 500u;
+        if (searchCost>=0) {
+            // If searches are slow wait longer for the user to stop typing - otherwise keystrokes queue up
+            // behind each search (blocking the GUI, or re-reading the model, whilst each is applied).
+            delay=searchCost<constFastSearch ? delay/2 : qMax(delay, (unsigned int)searchCost*2);
+        }
+        searchTimer->start(qMin(qMax(minSearchDebounce, delay), 5000u));
     }
 }
 
@@ -1875,7 +2014,21 @@ void ItemView::doSearch()
         searchTimer->stop();
     }
     performedSearch=true;
-    emit searchItems();
+    searchStart.start();
+    if (asyncSearch) {
+        // Cost is recorded when the model is reset with the results. If a search does not alter the
+        // results there is no reset, so the next reset will over-estimate - but only once.
+        searchPending=true;
+        emit searchItems();
+    } else {
+        emit searchItems();
+        addSearchCost(searchStart.elapsed());
+    }
+}
+
+void ItemView::addSearchCost(int cost)
+{
+    searchCost=searchCost<0 ? cost : ((searchCost+cost)/2);
 }
 
 void ItemView::searchActive(bool a)
@@ -30,6 +30,9 @@
 #include <QMap>
 #include <QList>
 #include <QPair>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QPersistentModelIndex>
 
 class Spinner;
 class QTimer;
@@ -148,6 +151,8 @@ public:
     void setOpenAfterSearch(bool o) { openFirstLevelAfterSearch=o; }
     void setEnabled(bool en);
     void setMinSearchDebounce(unsigned int val) { minSearchDebounce = val; }
+    // Model applies searches in the background, and resets once done - so time searches until then
+    void setAsyncSearch(bool a) { asyncSearch=a; }
     void setInfoText(const QString &info);
 
 private:
@@ -190,6 +195,8 @@ private Q_SLOTS:
     void addTitleButtonClicked();
     void replaceTitleButtonClicked();
     void coverLoaded(const Song &song, int size);
+    void viewScrolled(int pos);
+    void preloadCovers();
     void zoomIn();
     void zoomOut();
 
@@ -197,6 +204,8 @@ private:
     QAction * getAction(const QModelIndex &index);
     void setTitle();
     void controlViewFrame();
+    void cancelCoverPreloads();
+    void addSearchCost(int cost);
 
 private:
     QTimer *searchTimer;
@@ -219,6 +228,17 @@ private:
     bool openFirstLevelAfterSearch;
     bool initialised;
     unsigned int minSearchDebounce;
+    int searchCost; // Time (ms) taken to apply recent searches, -1 if not yet known
+    bool asyncSearch;
+    bool searchPending; // Async search started, but model not yet reset
+    QElapsedTimer searchStart;
+    QTimer *preloadTimer;
+    QElapsedTimer scrollTimer;
+    int lastScrollPos;
+    double scrollVelocity; // Pixels per millisecond, negative when scrolling up
+    QPersistentModelIndex preloadRoot;
+    int preloadSize;
+    QHash<int, Song> preloadedCovers;
 };
 
 #endif
@@ -49,7 +49,7 @@
 #include <QToolButton>
 #include <QClipboard>
 
-static const int constPollMpd = 5; // Poll every X seconds when playing
+static const int constTickSlack = 50; // Allow timer to fire this many ms early
 static const char * constUserSettingProp = "user-setting";
 
 class PosSliderProxyStyle : public QProxyStyle
@@ -91,6 +91,25 @@ public:
         QLabel::setEnabled(min!=max);
         if (!isEnabled()) {
             setText(QLatin1String(" "));
+            setMinimumWidth(0);
+        } else {
+            // Reserve space for the widest text in this range, so that the per-second
+            // text changes do not cause the rest of the widget to be re-laid out.
+            QFontMetrics fm=fontMetrics();
+            QChar widest=QLatin1Char('0');
+            for (char c='1'; c<='9'; ++c) {
+                if (fm.horizontalAdvance(QLatin1Char(c))>fm.horizontalAdvance(widest)) {
+                    widest=QLatin1Char(c);
+                }
+            }
+            QString sample=Utils::formatTime(max);
+            for (int i=0; i<sample.length(); ++i) {
+                if (sample.at(i).isDigit()) {
+                    sample[i]=widest;
+                }
+            }
+            QMargins m=contentsMargins();
+            setMinimumWidth(fm.horizontalAdvance(QString("%1 / -%1").arg(sample))+m.left()+m.right()+(2*margin()));
         }
     }
 
@@ -259,7 +278,8 @@ NowPlayingWidget::NowPlayingWidget(QWidget *p)
     : QWidget(p)
     , timer(nullptr)
     , lastVal(0)
-    , pollCount(0)
+    , running(false)
+    , suspended(false)
 {
     track=new SqueezedTextLabel(this);
     artist=new SqueezedTextLabel(this);
@@ -314,7 +334,6 @@ NowPlayingWidget::NowPlayingWidget(QWidget *p)
     connect(slider, SIGNAL(sliderReleased()), this, SLOT(released()));
     connect(slider, SIGNAL(positionSet()), this, SIGNAL(sliderReleased()));
     connect(slider, SIGNAL(valueChanged(int)), this, SLOT(updateTimes()));
-    connect(this, SIGNAL(mpdPoll()), MPDConnection::self(), SLOT(getStatus()));
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     clearTimes();
     update(Song());
@@ -348,21 +367,33 @@ void NowPlayingWidget::startTimer()
 {
     if (!timer) {
         timer=new QTimer(this);
-        timer->setInterval(1000);
+        timer->setSingleShot(true);
         connect(timer, SIGNAL(timeout()), this, SLOT(updatePos()));
     }
     elapsedTimer.start();
     lastVal=value();
-    timer->start();
-    pollCount=0;
+    running=true;
+    scheduleTick();
 }
 
 void NowPlayingWidget::stopTimer()
 {
+    running=false;
     if (timer) {
         timer->stop();
     }
-    pollCount=0;
+}
+
+// Position is only updated when MPD reports a change, or when a whole second has passed since
+// the last reported position. MPD's idle notifications (seek, pause, song change, etc.) cause
+// a status update, and so correct any drift - therefore there is no need to poll MPD.
+void NowPlayingWidget::scheduleTick()
+{
+    if (!running || suspended || !timer) {
+        return;
+    }
+    qint64 ms=elapsedTimer.elapsed();
+    timer->start(static_cast<int>((((ms+constTickSlack)/1000)+1)*1000-ms));
 }
 
 void NowPlayingWidget::setValue(int v)
@@ -372,6 +403,7 @@ void NowPlayingWidget::setValue(int v)
         lastVal=v;
         slider->setValue(v);
         updateTimes();
+        scheduleTick();
     }
 }
 
@@ -424,13 +456,12 @@ void NowPlayingWidget::updateTimes()
 
 void NowPlayingWidget::updatePos()
 {
-    quint16 elapsed=(elapsedTimer.elapsed()/1000.0)+0.5;
-    slider->setValue(lastVal+elapsed);
-    MPDStatus::self()->setGuessedElapsed(lastVal+elapsed);
-    if (++pollCount>=constPollMpd) {
-        pollCount=0;
-        emit mpdPoll();
+    quint16 elapsed=(elapsedTimer.elapsed()+constTickSlack)/1000;
+    if (slider->value()!=lastVal+elapsed) {
+        slider->setValue(lastVal+elapsed);
+        MPDStatus::self()->setGuessedElapsed(lastVal+elapsed);
     }
+    scheduleTick();
 }
 
 void NowPlayingWidget::pressed()
@@ -442,9 +473,7 @@ void NowPlayingWidget::pressed()
 
 void NowPlayingWidget::released()
 {
-    if (timer) {
-        timer->start();
-    }
+    scheduleTick();
     emit sliderReleased();
 }
 
@@ -530,6 +559,28 @@ void NowPlayingWidget::resizeEvent(QResizeEvent *ev)
     controlWidgets();
 }
 
+// No need to update position whilst window is hidden, or minimised. Spontaneous hide/show
+// events are received for the latter.
+void NowPlayingWidget::showEvent(QShowEvent *ev)
+{
+    QWidget::showEvent(ev);
+    if (suspended) {
+        suspended=false;
+        if (running && !slider->isSliderDown()) {
+            updatePos();
+        }
+    }
+}
+
+void NowPlayingWidget::hideEvent(QHideEvent *ev)
+{
+    QWidget::hideEvent(ev);
+    suspended=true;
+    if (timer) {
+        timer->stop();
+    }
+}
+
 void NowPlayingWidget::controlWidgets()
 {
     bool rwEnabled=ratingWidget->property(constUserSettingProp).toBool();
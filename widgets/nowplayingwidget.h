@@ -71,11 +71,12 @@ public:
     void initColors();
     QColor textColor() const { return track->palette().windowText().color(); }
     void resizeEvent(QResizeEvent *ev) override;
+    void showEvent(QShowEvent *ev) override;
+    void hideEvent(QHideEvent *ev) override;
 
 Q_SIGNALS:
     void sliderReleased();
 
-    void mpdPoll();
     void setRating(const QString &file, quint8 r);
 
 public Q_SLOTS:
@@ -92,6 +93,7 @@ private Q_SLOTS:
 
 private:
     void controlWidgets();
+    void scheduleTick();
 
 private:
     SqueezedTextLabel *track;
@@ -104,7 +106,8 @@ private:
     QElapsedTimer elapsedTimer;
     QString currentSongFile;
     int lastVal;
-    int pollCount;
+    bool running;
+    bool suspended;
 };
 
 #endif